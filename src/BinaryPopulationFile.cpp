@@ -0,0 +1,134 @@
+#include "BinaryPopulationFile.h"
+#include "Genome.h"
+
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <cstring>
+#include <cstdio>
+
+static const char s_populationMagic[8] = {'A', 'G', 'A', '4', 'P', 'O', 'P', 'B'};
+static const uint32_t s_populationVersion = 1;
+
+static uint64_t Align8(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+size_t BinaryPopulationFile::SchemaSize(size_t genomeLength)
+{
+    return size_t(Align8(2 * sizeof(int32_t) + 3 * genomeLength * sizeof(double) + genomeLength * sizeof(int32_t)));
+}
+
+int BinaryPopulationFile::Open(const std::string &filename)
+{
+    Close();
+    if (m_file.Open(filename, 0, true)) return __LINE__;
+    uint64_t size = m_file.GetSize();
+    if (size < sizeof(Header)) { Close(); return __LINE__; }
+    const Header *header = GetHeader();
+    bool valid = std::memcmp(header->magic, s_populationMagic, sizeof(header->magic)) == 0 && header->version == s_populationVersion && header->headerSize == sizeof(Header) &&
+                 header->fileSize == size && header->genomeLength <= size / sizeof(double) && header->populationSize <= size / sizeof(double) && header->schemaCount <= size;
+    if (valid)
+    {
+        uint64_t n = header->populationSize, length = header->genomeLength;
+        auto inside = [size](uint64_t offset, uint64_t bytes) { return offset % 8 == 0 && offset <= size && bytes <= size - offset; };
+        valid = (header->schemaCount > 0 || n == 0) && inside(header->schemaOffset, header->schemaCount * SchemaSize(size_t(length))) && inside(header->schemaIndexOffset, n * sizeof(uint32_t)) &&
+                inside(header->fitnessOffset, n * sizeof(double)) && (length == 0 || n <= size / (length * sizeof(double))) && inside(header->geneOffset, n * length * sizeof(double));
+    }
+    for (size_t i = 0; valid && i < GetPopulationSize(); i++) valid = GetSchemaIndex(i) < header->schemaCount;
+    if (!valid) { Close(); return __LINE__; }
+    return 0;
+}
+
+void BinaryPopulationFile::Close()
+{
+    m_file.Close();
+}
+
+void BinaryPopulationFile::GetGenome(size_t i, Genome *genome) const
+{
+    size_t length = GetGenomeLength();
+    const char *schema = m_file.GetData() + GetHeader()->schemaOffset + GetSchemaIndex(i) * SchemaSize(length);
+    int32_t genomeType;
+    std::memcpy(&genomeType, schema, sizeof(genomeType));
+    const double *lowBounds = reinterpret_cast<const double *>(schema + 2 * sizeof(int32_t));
+    const double *highBounds = lowBounds + length;
+    const double *gaussianSDs = highBounds + length;
+    const int32_t *circularMutationFlags = reinterpret_cast<const int32_t *>(gaussianSDs + length);
+    genome->Assign(Genome::GenomeType(genomeType), length, GetGenes(i), lowBounds, highBounds, gaussianSDs, circularMutationFlags, GetFitness(i));
+}
+
+// written under a temporary name and renamed like the text population files
+int BinaryPopulationFile::Write(const std::string &filename, const std::vector<std::shared_ptr<const Genome>> &genomes)
+{
+    size_t length = genomes.size() ? genomes.front()->GetGenomeLength() : 0;
+    std::vector<const Genome *> schemas;
+    std::vector<uint32_t> schemaIndices;
+    schemaIndices.reserve(genomes.size());
+    auto sameSchema = [](const Genome *lhs, const Genome *rhs)
+    {
+        return lhs->GetGenomeType() == rhs->GetGenomeType() && *lhs->GetLowBounds() == *rhs->GetLowBounds() && *lhs->GetHighBounds() == *rhs->GetHighBounds() &&
+               *lhs->GetGaussianSDs() == *rhs->GetGaussianSDs() && *lhs->GetCircularMutationFlags() == *rhs->GetCircularMutationFlags();
+    };
+    for (auto &&genome : genomes)
+    {
+        if (genome->GetGenomeLength() != length || genome->GetLowBounds()->size() != length) return __LINE__;
+        size_t index = schemaIndices.size() ? schemaIndices.back() : 0; // neighbours nearly always share a schema
+        if (index >= schemas.size() || !sameSchema(schemas[index], genome.get()))
+        {
+            for (index = 0; index < schemas.size(); index++) { if (sameSchema(schemas[index], genome.get())) break; }
+            if (index == schemas.size()) schemas.push_back(genome.get());
+        }
+        schemaIndices.push_back(uint32_t(index));
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, s_populationMagic, sizeof(header.magic));
+    header.version = s_populationVersion;
+    header.headerSize = sizeof(Header);
+    header.populationSize = genomes.size();
+    header.genomeLength = length;
+    header.schemaCount = schemas.size();
+    header.schemaOffset = Align8(sizeof(Header));
+    header.schemaIndexOffset = header.schemaOffset + schemas.size() * SchemaSize(length);
+    header.fitnessOffset = header.schemaIndexOffset + Align8(genomes.size() * sizeof(uint32_t));
+    header.geneOffset = header.fitnessOffset + genomes.size() * sizeof(double);
+    header.fileSize = header.geneOffset + genomes.size() * length * sizeof(double);
+
+    std::string temporaryFilename = filename + ".tmp";
+    {
+        std::ofstream outFile(temporaryFilename, std::ios::binary | std::ios::trunc);
+        if (!outFile) return __LINE__;
+        const char padding[8] = {};
+        auto writeArray = [&outFile](const void *data, size_t bytes) { outFile.write(reinterpret_cast<const char *>(data), std::streamsize(bytes)); };
+        writeArray(&header, sizeof(header));
+        for (auto &&schema : schemas)
+        {
+            int32_t typeAndReserved[2] = {int32_t(schema->GetGenomeType()), 0};
+            std::vector<int32_t> flags(schema->GetCircularMutationFlags()->begin(), schema->GetCircularMutationFlags()->end());
+            flags.resize(length); // only genomes read from a file are guaranteed to have the flags
+            writeArray(typeAndReserved, sizeof(typeAndReserved));
+            writeArray(schema->GetLowBounds()->data(), length * sizeof(double));
+            writeArray(schema->GetHighBounds()->data(), length * sizeof(double));
+            writeArray(schema->GetGaussianSDs()->data(), length * sizeof(double));
+            writeArray(flags.data(), length * sizeof(int32_t));
+            writeArray(padding, SchemaSize(length) - (2 * sizeof(int32_t) + 3 * length * sizeof(double) + length * sizeof(int32_t)));
+        }
+        writeArray(schemaIndices.data(), schemaIndices.size() * sizeof(uint32_t));
+        writeArray(padding, size_t(Align8(schemaIndices.size() * sizeof(uint32_t)) - schemaIndices.size() * sizeof(uint32_t)));
+        for (auto &&genome : genomes) { double fitness = genome->GetFitness(); writeArray(&fitness, sizeof(fitness)); }
+        for (auto &&genome : genomes) writeArray(genome->GetGenes()->data(), length * sizeof(double));
+        outFile.close();
+        if (!outFile) { std::remove(temporaryFilename.c_str()); return __LINE__; }
+    }
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryFilename, filename, errorCode);
+    if (errorCode) { std::remove(temporaryFilename.c_str()); return __LINE__; }
+    return 0;
+}
+
+bool BinaryPopulationFile::IsBinaryPopulationFile(const std::string &filename)
+{
+    char magic[sizeof(s_populationMagic)] = {};
+    std::ifstream inFile(filename, std::ios::binary);
+    if (!inFile.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, s_populationMagic, sizeof(magic)) == 0;
+}
@@ -0,0 +1,60 @@
+#ifndef BINARYPOPULATIONFILE_H
+#define BINARYPOPULATIONFILE_H
+
+#include "MemoryMappedFile.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+class Genome;
+
+// binary population file that is used in place through a memory mapping rather than parsed
+// the bounds, SDs and circular flags are usually the same for every genome so they are stored once as a schema
+// (a population that mixes schemas gets one per distinct set) and every genome is a row of genes in one contiguous
+// matrix with the fitness values in a separate column. All the sections are 8 byte aligned and the genomes are
+// stored fittest first to match the text format so either format can be converted to the other without change
+
+class BinaryPopulationFile
+{
+public:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t fileSize;
+        uint64_t populationSize;
+        uint64_t genomeLength;
+        uint64_t schemaCount;
+        uint64_t schemaOffset; // schemaCount of {int32 genomeType, int32 reserved, low[], high[], sd[], int32 circular[] padded to 8 bytes}
+        uint64_t schemaIndexOffset; // uint32 per genome padded to 8 bytes
+        uint64_t fitnessOffset; // double per genome
+        uint64_t geneOffset; // populationSize rows of genomeLength doubles
+    };
+
+    int Open(const std::string &filename);
+    void Close();
+
+    size_t GetPopulationSize() const { return size_t(GetHeader()->populationSize); }
+    size_t GetGenomeLength() const { return size_t(GetHeader()->genomeLength); }
+    size_t GetSchemaCount() const { return size_t(GetHeader()->schemaCount); }
+    const double *GetGenes(size_t i) const { return reinterpret_cast<const double *>(m_file.GetData() + GetHeader()->geneOffset) + i * GetGenomeLength(); }
+    double GetFitness(size_t i) const { return reinterpret_cast<const double *>(m_file.GetData() + GetHeader()->fitnessOffset)[i]; }
+    uint32_t GetSchemaIndex(size_t i) const { return reinterpret_cast<const uint32_t *>(m_file.GetData() + GetHeader()->schemaIndexOffset)[i]; }
+    void GetGenome(size_t i, Genome *genome) const;
+
+    // the genomes must all be the same length
+    static int Write(const std::string &filename, const std::vector<std::shared_ptr<const Genome>> &genomes);
+    static bool IsBinaryPopulationFile(const std::string &filename);
+
+private:
+    const Header *GetHeader() const { return reinterpret_cast<const Header *>(m_file.GetData()); }
+    static size_t SchemaSize(size_t genomeLength);
+
+    MemoryMappedFile m_file;
+};
+
+#endif // BINARYPOPULATIONFILE_H
@@ -0,0 +1,124 @@
+#include "Checkpoint.h"
+
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <cstdio>
+
+#if defined(WIN32) || defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+static const char s_checkpointMagic[8] = {'A', 'G', 'A', '4', 'C', 'K', 'P', 'T'};
+static const uint32_t s_checkpointVersion = 1;
+
+void Checkpoint::Clear()
+{
+    m_data.clear();
+    m_readPosition = 0;
+    m_readError = false;
+}
+
+void Checkpoint::Assign(const char *data, size_t size)
+{
+    m_data.assign(data, data + size);
+    m_readPosition = 0;
+    m_readError = false;
+}
+
+void Checkpoint::WriteString(const std::string &value)
+{
+    Write(uint64_t(value.size()));
+    Append(value.data(), value.size());
+}
+
+bool Checkpoint::ReadString(std::string *value)
+{
+    uint64_t length = 0;
+    if (!Read(&length)) return false;
+    if (length > m_data.size() - m_readPosition) { m_readError = true; return false; }
+    value->assign(m_data.data() + m_readPosition, size_t(length));
+    m_readPosition += size_t(length);
+    return true;
+}
+
+// the new checkpoint only replaces the old one once it has been completely written
+// and it is flushed to the disk before the rename and the rename after it so a crash leaves either the old or the new one
+int Checkpoint::WriteFile(const std::string &filename) const
+{
+    Header header = {};
+    std::memcpy(header.magic, s_checkpointMagic, sizeof(header.magic));
+    header.version = s_checkpointVersion;
+    header.size = m_data.size();
+    header.checksum = Checksum(m_data.data(), m_data.size());
+    std::filesystem::path temporaryPath(filename + ".tmp");
+    {
+#if defined(WIN32) || defined(_WIN32)
+        std::FILE *file = _wfopen(temporaryPath.c_str(), L"wb");
+#else
+        std::FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+#endif
+        if (!file) return __LINE__;
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        if (ok && m_data.size()) ok = std::fwrite(m_data.data(), m_data.size(), 1, file) == 1;
+        if (ok) ok = std::fflush(file) == 0;
+#if defined(WIN32) || defined(_WIN32)
+        if (ok) ok = _commit(_fileno(file)) == 0;
+#else
+        if (ok) ok = fsync(fileno(file)) == 0;
+#endif
+        if (std::fclose(file)) ok = false;
+        if (!ok) return __LINE__;
+    }
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryPath, filename, errorCode);
+    if (errorCode) return __LINE__;
+#if !defined(WIN32) && !defined(_WIN32)
+    // the rename is only durable once the directory entry has been written
+    std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    if (directory.empty()) directory = ".";
+    int directoryDescriptor = open(directory.c_str(), O_RDONLY);
+    if (directoryDescriptor < 0) return __LINE__;
+    int result = fsync(directoryDescriptor);
+    close(directoryDescriptor);
+    if (result) return __LINE__;
+#endif
+    return 0;
+}
+
+int Checkpoint::ReadFile(const std::string &filename)
+{
+    Clear();
+    std::ifstream inFile(filename, std::ios::binary);
+    if (!inFile) return __LINE__;
+    Header header = {};
+    if (!inFile.read(reinterpret_cast<char *>(&header), sizeof(header))) return __LINE__;
+    if (std::memcmp(header.magic, s_checkpointMagic, sizeof(header.magic)) != 0) return __LINE__;
+    if (header.version != s_checkpointVersion) return __LINE__;
+    std::error_code errorCode;
+    uintmax_t fileSize = std::filesystem::file_size(filename, errorCode);
+    if (errorCode || fileSize != sizeof(header) + header.size) return __LINE__;
+    m_data.resize(size_t(header.size));
+    if (!inFile.read(m_data.data(), std::streamsize(m_data.size()))) { Clear(); return __LINE__; }
+    if (Checksum(m_data.data(), m_data.size()) != header.checksum) { Clear(); return __LINE__; }
+    return 0;
+}
+
+// FNV-1a applied a word at a time which is plenty to catch truncation and corruption
+uint64_t Checkpoint::Checksum(const char *data, size_t size)
+{
+    const uint64_t prime = 0x100000001b3;
+    uint64_t hash = 0xcbf29ce484222325;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; i++) hash = (hash ^ uint64_t(uint8_t(data[i]))) * prime;
+    return hash;
+}
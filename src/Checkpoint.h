@@ -0,0 +1,92 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// binary buffer used to save and restore the complete state of a run
+// the owner of the state writes it into the buffer which can then be handed to another thread to be saved
+// values are stored in the native byte order so a checkpoint can only be resumed on the same kind of machine
+// the file has a header with a checksum so that a truncated or corrupt file is refused rather than partly restored
+// and it is written to a temporary file that is renamed over the previous one so a crash never leaves half a checkpoint
+
+class Checkpoint
+{
+public:
+    void Clear();
+
+    template<typename T> void Write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Append(&value, sizeof(T));
+    }
+    template<typename T> void WriteVector(const std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Write(uint64_t(values.size()));
+        Append(values.data(), values.size() * sizeof(T));
+    }
+    void WriteString(const std::string &value);
+
+    // once a read fails every later read fails too so the caller only needs to check at the end
+    template<typename T> bool Read(T *value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (m_readError || m_data.size() - m_readPosition < sizeof(T)) { m_readError = true; return false; }
+        std::memcpy(value, m_data.data() + m_readPosition, sizeof(T));
+        m_readPosition += sizeof(T);
+        return true;
+    }
+    template<typename T> bool ReadVector(std::vector<T> *values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        uint64_t count = 0;
+        if (!Read(&count)) return false;
+        if (count > (m_data.size() - m_readPosition) / sizeof(T)) { m_readError = true; return false; }
+        values->resize(size_t(count));
+        std::memcpy(values->data(), m_data.data() + m_readPosition, size_t(count) * sizeof(T));
+        m_readPosition += size_t(count) * sizeof(T);
+        return true;
+    }
+    bool ReadString(std::string *value);
+
+    int WriteFile(const std::string &filename) const;
+    int ReadFile(const std::string &filename);
+
+    void Assign(const char *data, size_t size); // replaces the contents ready to be read, for buffers stored inside other files
+    const char *GetData() const { return m_data.data(); }
+    size_t GetSize() const { return m_data.size(); }
+    bool GetReadError() const { return m_readError; }
+    bool AtEnd() const { return m_readPosition == m_data.size(); }
+
+    static uint64_t Checksum(const char *data, size_t size);
+
+private:
+    // resize and copy rather than a range insert because GCC 12 reports a false -Wstringop-overflow for the insert in optimised builds
+    void Append(const void *data, size_t size)
+    {
+        if (size == 0) return;
+        size_t position = m_data.size();
+        m_data.resize(position + size);
+        std::memcpy(m_data.data() + position, data, size);
+    }
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t size;
+        uint64_t checksum;
+    };
+
+    std::vector<char> m_data;
+    size_t m_readPosition = 0;
+    bool m_readError = false;
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,73 @@
+#include "ArgParse.h"
+#include "BinaryPopulationFile.h"
+#include "PopulationDelta.h"
+#include "Population.h"
+#include "Genome.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+using namespace std::string_literals;
+
+// converts population files between the text and the binary formats
+// the genomes are copied in file order without going through a Population so nothing is sorted or merged
+// a population delta is rebuilt from its keyframe so this is also how to get any snapshot back as an ordinary file
+
+int main(int argc, const char **argv)
+{
+    ArgParse argparse;
+    argparse.Initialise(argc, argv, "ConvertPopulation converts AsynchronousGA4CL population files between the text and binary formats"s, 0, 0);
+    argparse.AddArgument("-i"s, "--inputPopulation"s, "Population file in either format or a population delta"s, ""s, 1, true, ArgParse::String);
+    argparse.AddArgument("-o"s, "--outputPopulation"s, "Converted population file"s, ""s, 1, true, ArgParse::String);
+    argparse.AddArgument("-f"s, "--format"s, "Output format, text or binary [the other format from the input]"s, ""s, 1, false, ArgParse::String);
+
+    int err = argparse.Parse();
+    if (err)
+    {
+        argparse.Usage();
+        return 1;
+    }
+
+    std::string inputPopulation, outputPopulation, format;
+    argparse.Get("--inputPopulation"s, &inputPopulation);
+    argparse.Get("--outputPopulation"s, &outputPopulation);
+    argparse.Get("--format"s, &format);
+    std::string inputFormat = BinaryPopulationFile::IsBinaryPopulationFile(inputPopulation) ? "binary"s : PopulationDelta::IsPopulationDeltaFile(inputPopulation) ? "delta"s : "text"s;
+    if (format.empty()) format = inputFormat == "text"s ? "binary"s : "text"s;
+    if (format != "text"s && format != "binary"s)
+    {
+        std::cerr << "Error: --format must be text or binary\n";
+        return 1;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<const Genome>> genomes;
+    size_t expected = 0;
+    err = Population::ReadGenomes(inputPopulation.c_str(), [&genomes, &expected](std::unique_ptr<Genome> genome, size_t populationSize)
+    {
+        expected = populationSize;
+        genomes.push_back(std::move(genome));
+        return true;
+    });
+    if (err || genomes.size() != expected)
+    {
+        std::cerr << "Error: could not read \"" << inputPopulation << "\"\n";
+        return 1;
+    }
+    auto readTime = std::chrono::steady_clock::now();
+
+    if (format == "binary"s) err = BinaryPopulationFile::Write(outputPopulation, genomes);
+    else err = Population::WriteGenomes(outputPopulation.c_str(), genomes);
+    if (err)
+    {
+        std::cerr << "Error: could not write \"" << outputPopulation << "\"\n";
+        return 1;
+    }
+    auto writeTime = std::chrono::steady_clock::now();
+    std::cout << genomes.size() << " genomes converted from " << inputFormat << " to " << format << " read "
+              << std::chrono::duration<double>(readTime - startTime).count() << " s write " << std::chrono::duration<double>(writeTime - readTime).count() << " s\n";
+    return 0;
+}
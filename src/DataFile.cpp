@@ -21,6 +21,7 @@
 #include <sstream>
 #include <string_view>
 #include <vector>
+#include <algorithm>
 #include <cassert>
 
 #ifdef _WIN32
@@ -58,6 +59,7 @@ void DataFile::SetRawData(const char *string, size_t stringLen)
     m_fileData = std::make_unique<char[]>(m_size);
     memcpy(m_fileData.get(), string, m_size);
     m_index = m_fileData.get();
+    ClearIndex();
 }
 
 void DataFile::ClearData()
@@ -65,6 +67,7 @@ void DataFile::ClearData()
     m_size = 0;
     m_fileData.reset();
     m_index = nullptr;
+    ClearIndex();
 }
 
 size_t DataFile::Replace(const std::string &oldString, const std::string &newString)
@@ -115,9 +118,52 @@ size_t DataFile::Replace(const char *oldString, size_t oldLen, const char *newSt
     *destPtr = 0;
     m_fileData = std::move(newBuffer);
     m_size = newSize;
+    ClearIndex();
     return count;
 }
 
+// one pass through the data recording where every possible parameter name and every name="value" attribute is
+// the tokens are split exactly as FindParameter would match them (any character below 33 is a separator)
+// but tokens that look like numbers are left out because they are never names and most of a big data file is numbers
+void DataFile::BuildIndex()
+{
+    ClearIndex();
+    if (!m_fileData) return;
+    const char *data = m_fileData.get();
+    const char *p = data;
+    while (*p)
+    {
+        if (*p < 33) { p++; continue; }
+        const char *start = p;
+        while (*p > 32) p++;
+        if (IsIndexedName(start)) m_parameterIndex[std::string_view(start, size_t(p - start))].push_back(size_t(start - data));
+    }
+
+    for (const char *equals = strstr(data, "=\""); equals; )
+    {
+        const char *nameStart = equals;
+        while (nameStart > data && nameStart[-1] > 32 && strchr("<>\"'=/", nameStart[-1]) == nullptr) nameStart--;
+        const char *valueStart = equals + 2;
+        const char *valueEnd = strchr(valueStart, '"');
+        if (valueEnd == nullptr) break;
+        if (nameStart < equals) m_attributeIndex.emplace(std::string_view(nameStart, size_t(equals - nameStart)), std::make_pair(size_t(valueStart - data), size_t(valueEnd - data)));
+        equals = strstr(valueEnd + 1, "=\"");
+    }
+    m_indexed = true;
+}
+
+void DataFile::ClearIndex()
+{
+    m_parameterIndex.clear();
+    m_attributeIndex.clear();
+    m_indexed = false;
+}
+
+bool DataFile::IsIndexedName(const char *name)
+{
+    return *name > 32 && !(*name >= '0' && *name <= '9') && *name != '-' && *name != '+' && *name != '.';
+}
+
 
 // read the named file
 // returns true on error
@@ -463,10 +509,25 @@ bool DataFile::FindParameter(const char * const param,
     char *p;
     size_t len = strlen(param);
 
-    if (searchFromStart) p = m_fileData.get();
+    if (m_indexed && IsIndexedName(param) && std::find_if(param, param + len, [](char c) { return c < 33; }) == param + len)
+    {
+        auto found = m_parameterIndex.find(std::string_view(param, len));
+        if (found != m_parameterIndex.end())
+        {
+            size_t from = searchFromStart ? 0 : size_t(m_index - m_fileData.get());
+            auto offset = std::lower_bound(found->second.begin(), found->second.end(), from);
+            if (offset != found->second.end())
+            {
+                m_index = m_fileData.get() + *offset + len;
+                return false;
+            }
+        }
+        p = nullptr;
+    }
+    else if (searchFromStart) p = m_fileData.get();
     else p = m_index;
 
-    while (1)
+    while (p)
     {
         p = strstr(p, param);
         if (p == nullptr) break; // not found at all
@@ -1406,6 +1467,7 @@ bool DataFile::WriteNext(const char * const val, char after)
     bool needQuotes = false;
     size_t size = 0;
 
+    ClearIndex();
     // check for whitespace and measure actual size
     cp = val;
     while (*cp)
@@ -1455,6 +1517,7 @@ bool DataFile::WriteNextQuotedString(const char * const val, char after)
     const char *cp;
     size_t size = 0;
 
+    ClearIndex();
     // check for whitespace and measure actual size
     cp = val;
     while (*cp)
@@ -1657,6 +1720,13 @@ size_t DataFile::Replace(std::string *s, std::string const &toReplace, std::stri
 // returns false on success
 bool DataFile::RetrieveAttribute(const char * const attrib, std::string *val)
 {
+    if (m_indexed)
+    {
+        auto found = m_attributeIndex.find(std::string_view(attrib));
+        if (found == m_attributeIndex.end()) return true;
+        val->assign(m_fileData.get() + found->second.first, m_fileData.get() + found->second.second);
+        return false;
+    }
     std::string target(attrib);
     target.append("=\"");
     char *startPtr = strstr(m_fileData.get(), target.c_str());
@@ -14,6 +14,10 @@
 
 #include <string>
 #include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <utility>
 
 class DataFile
 {
@@ -48,6 +52,13 @@ class DataFile
     bool RetrieveAttribute(const char * const attrib, bool *val);
     bool RetrieveAttribute(const char * const attrib, std::string *val);
 
+    // optional index of the names in the data, built in one pass, so that each Retrieve call is a lookup rather than
+    // a scan of the whole file. FindParameter and RetrieveAttribute use it until the data are changed, which clears it,
+    // except that changes made through GetRawData are not noticed so call BuildIndex again after those
+    void BuildIndex();
+    void ClearIndex();
+    bool HasIndex() { return m_indexed; }
+
     // ranged functions
     // the file is searched for the parameter and then the next token is read
     bool RetrieveRangedParameter(const char * const param, double *val, bool searchFromStart = true);
@@ -150,6 +161,12 @@ class DataFile
     double m_rangeControl = false;
     size_t m_size = 0;
     std::string m_pathName;
+
+    // the keys point into m_fileData
+    std::unordered_map<std::string_view, std::vector<size_t>> m_parameterIndex; // offsets of every token that could be a parameter name
+    std::unordered_map<std::string_view, std::pair<size_t, size_t>> m_attributeIndex; // value span of the first name="value"
+    bool m_indexed = false;
+    static bool IsIndexedName(const char *name);
 #if defined(_WIN32) || defined(WIN32)
     // provide Windows specific wchar versions
     bool ReadFile(const std::wstring &name);
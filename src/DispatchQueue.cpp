@@ -0,0 +1,104 @@
+#include "DispatchQueue.h"
+
+DispatchQueue::DispatchQueue()
+{
+    m_weights = {8, 4, 2, 1, 0};
+    m_maximumAges.fill(0);
+    m_currentWeights.fill(0);
+    m_lastServedTimes.fill(0);
+    m_servedCounts.fill(0);
+    m_ageLimitCounts.fill(0);
+}
+
+void DispatchQueue::Push(PriorityClass priorityClass, uint64_t runID, double currentTime)
+{
+    m_queues[priorityClass].push_back(Item{runID, currentTime});
+}
+
+void DispatchQueue::PushFront(PriorityClass priorityClass, uint64_t runID, double enqueueTime)
+{
+    m_queues[priorityClass].push_front(Item{runID, enqueueTime});
+}
+
+bool DispatchQueue::Pop(PriorityClass priorityClass, uint64_t *runID, double *enqueueTime)
+{
+    if (m_queues[priorityClass].empty()) return false;
+    *runID = m_queues[priorityClass].front().runID;
+    *enqueueTime = m_queues[priorityClass].front().enqueueTime;
+    m_queues[priorityClass].pop_front();
+    return true;
+}
+
+DispatchQueue::PriorityClass DispatchQueue::Select(double currentTime, uint32_t availableMask)
+{
+    // queued classes are only available when they have something in them
+    for (int i = 0; i < StartPopulationClass; i++) { if (m_queues[i].empty()) availableMask &= ~ClassBit(PriorityClass(i)); }
+    if (availableMask == 0) return NumberOfClasses;
+
+    // age guarantees come first and the most overdue class wins
+    PriorityClass selected = NumberOfClasses;
+    double mostOverdue = 0;
+    for (int i = 0; i < NumberOfClasses; i++)
+    {
+        if (!(availableMask & ClassBit(PriorityClass(i))) || m_maximumAges[i] <= 0) continue;
+        double age = IsQueued(PriorityClass(i)) ? currentTime - m_queues[i].front().enqueueTime : currentTime - m_lastServedTimes[i];
+        double overdue = age - m_maximumAges[i];
+        if (overdue > mostOverdue)
+        {
+            mostOverdue = overdue;
+            selected = PriorityClass(i);
+        }
+    }
+    if (selected != NumberOfClasses)
+    {
+        m_ageLimitCounts[selected]++;
+        return selected;
+    }
+
+    // smooth weighted round robin
+    double totalWeight = 0;
+    for (int i = 0; i < NumberOfClasses; i++)
+    {
+        if (!(availableMask & ClassBit(PriorityClass(i))) || m_weights[i] <= 0) continue;
+        m_currentWeights[i] += m_weights[i];
+        totalWeight += m_weights[i];
+        if (selected == NumberOfClasses || m_currentWeights[i] > m_currentWeights[selected]) selected = PriorityClass(i);
+    }
+    if (selected != NumberOfClasses)
+    {
+        m_currentWeights[selected] -= totalWeight;
+        return selected;
+    }
+
+    // nothing with a weight is available so use the first of the zero weight classes
+    for (int i = 0; i < NumberOfClasses; i++) { if (availableMask & ClassBit(PriorityClass(i))) return PriorityClass(i); }
+    return NumberOfClasses;
+}
+
+void DispatchQueue::MarkServed(PriorityClass priorityClass, double currentTime)
+{
+    m_lastServedTimes[priorityClass] = currentTime;
+    m_servedCounts[priorityClass]++;
+}
+
+void DispatchQueue::Clear(double currentTime)
+{
+    for (auto &&queue : m_queues) queue.clear();
+    m_currentWeights.fill(0);
+    m_lastServedTimes.fill(currentTime);
+    m_servedCounts.fill(0);
+    m_ageLimitCounts.fill(0);
+}
+
+const char *DispatchQueue::ClassName(PriorityClass priorityClass)
+{
+    switch (priorityClass)
+    {
+    case RequeueClass: return "requeue";
+    case StragglerClass: return "straggler";
+    case EliteClass: return "elite";
+    case StartPopulationClass: return "start population";
+    case OffspringClass: return "offspring";
+    default: return "unknown";
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef DISPATCHQUEUE_H
+#define DISPATCHQUEUE_H
+
+#include <array>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+
+// decides what kind of work is sent to the next client that asks for a genome
+// the requeue, straggler and elite classes hold runIDs of entries that are already in the running list
+// and the start population and offspring classes are generated on demand so they only need an availability flag.
+// Classes are chosen by smooth weighted round robin among the available classes with a weight greater than zero,
+// and classes with zero weight are only used when nothing else is available. A class whose oldest item
+// (or for the generated classes the time since it was last served) exceeds its maximum age is served first.
+
+class DispatchQueue
+{
+public:
+    enum PriorityClass { RequeueClass = 0, StragglerClass, EliteClass, StartPopulationClass, OffspringClass, NumberOfClasses };
+
+    DispatchQueue();
+
+    void Push(PriorityClass priorityClass, uint64_t runID, double currentTime);
+    void PushFront(PriorityClass priorityClass, uint64_t runID, double enqueueTime); // puts back an item that could not be sent
+    bool Pop(PriorityClass priorityClass, uint64_t *runID, double *enqueueTime);
+    PriorityClass Select(double currentTime, uint32_t availableMask); // returns NumberOfClasses if nothing is available
+    void MarkServed(PriorityClass priorityClass, double currentTime);
+    void Clear(double currentTime);
+
+    void SetWeight(PriorityClass priorityClass, double weight) { m_weights[priorityClass] = weight; }
+    void SetMaximumAge(PriorityClass priorityClass, double maximumAge) { m_maximumAges[priorityClass] = maximumAge; }
+
+    static uint32_t ClassBit(PriorityClass priorityClass) { return uint32_t(1) << priorityClass; }
+    static bool IsQueued(PriorityClass priorityClass) { return priorityClass < StartPopulationClass; }
+    static const char *ClassName(PriorityClass priorityClass);
+
+    size_t GetSize(PriorityClass priorityClass) const { return m_queues[priorityClass].size(); }
+    uint64_t GetServedCount(PriorityClass priorityClass) const { return m_servedCounts[priorityClass]; }
+    uint64_t GetAgeLimitCount(PriorityClass priorityClass) const { return m_ageLimitCounts[priorityClass]; }
+
+private:
+    struct Item
+    {
+        uint64_t runID;
+        double enqueueTime;
+    };
+
+    std::array<std::deque<Item>, NumberOfClasses> m_queues;
+    std::array<double, NumberOfClasses> m_weights;
+    std::array<double, NumberOfClasses> m_maximumAges;
+    std::array<double, NumberOfClasses> m_currentWeights;
+    std::array<double, NumberOfClasses> m_lastServedTimes;
+    std::array<uint64_t, NumberOfClasses> m_servedCounts;
+    std::array<uint64_t, NumberOfClasses> m_ageLimitCounts;
+};
+
+#endif // DISPATCHQUEUE_H
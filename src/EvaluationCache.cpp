@@ -0,0 +1,160 @@
+#include "EvaluationCache.h"
+
+#include <cstring>
+#include <algorithm>
+#include <bit>
+
+static const char kMagic[8] = {'A', 'G', 'A', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t kVersion = 1;
+static const uint32_t kProbeLength = 16;
+static const uint64_t kMinimumCapacity = 1024;
+
+// splitmix64 finaliser
+static inline uint64_t Mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+EvaluationCache::EvaluationCache()
+{
+}
+
+EvaluationCache::~EvaluationCache()
+{
+    Close();
+}
+
+int EvaluationCache::Open(const std::string &filename, size_t capacity)
+{
+    Close();
+    uint64_t requestedCapacity = std::bit_ceil(std::max(uint64_t(capacity), kMinimumCapacity));
+    if (m_file.Open(filename, sizeof(Header) + requestedCapacity * sizeof(Entry), false)) return __LINE__;
+
+    m_header = reinterpret_cast<Header *>(m_file.GetData());
+    bool valid = std::memcmp(m_header->magic, kMagic, sizeof(kMagic)) == 0 && m_header->version == kVersion && m_header->probeLength == kProbeLength &&
+                 std::has_single_bit(m_header->capacity) && sizeof(Header) + m_header->capacity * sizeof(Entry) <= m_file.GetSize();
+    if (!valid)
+    {
+        // new or unreadable file so start again from scratch
+        std::memset(m_file.GetData(), 0, m_file.GetSize());
+        std::memcpy(m_header->magic, kMagic, sizeof(kMagic));
+        m_header->version = kVersion;
+        m_header->probeLength = kProbeLength;
+        m_header->capacity = requestedCapacity;
+        m_header->count = 0;
+        m_header->sequence = 0;
+    }
+    m_entries = reinterpret_cast<Entry *>(m_file.GetData() + sizeof(Header));
+    m_mask = m_header->capacity - 1;
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+    return 0;
+}
+
+void EvaluationCache::Close()
+{
+    m_file.Close();
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_mask = 0;
+}
+
+int EvaluationCache::Flush()
+{
+    return m_file.Flush();
+}
+
+uint64_t EvaluationCache::GetCount() const
+{
+    return m_header ? m_header->count : 0;
+}
+
+uint64_t EvaluationCache::GetCapacity() const
+{
+    return m_header ? m_header->capacity : 0;
+}
+
+// two independent 64 bit hashes of the MD5 and the genes so that false matches are vanishingly unlikely
+void EvaluationCache::HashKey(const uint32_t *md5, const double *genes, size_t genomeLength, uint64_t key[2])
+{
+    uint64_t h0 = 0x243f6a8885a308d3ull ^ genomeLength;
+    uint64_t h1 = 0x13198a2e03707344ull ^ Mix(genomeLength);
+    uint64_t word;
+    for (size_t i = 0; i < 4; i += 2)
+    {
+        word = uint64_t(md5[i]) | (uint64_t(md5[i + 1]) << 32);
+        h0 = Mix(h0 ^ word);
+        h1 = Mix(h1 + word * 0x9e3779b97f4a7c15ull);
+    }
+    for (size_t i = 0; i < genomeLength; i++)
+    {
+        double gene = genes[i] == 0 ? 0.0 : genes[i]; // treat -0 and +0 as the same value
+        std::memcpy(&word, &gene, sizeof(word));
+        h0 = Mix(h0 ^ word);
+        h1 = Mix(h1 + word * 0x9e3779b97f4a7c15ull);
+    }
+    key[0] = h0;
+    key[1] = h1;
+}
+
+EvaluationCache::Entry *EvaluationCache::FindEntry(const uint32_t *md5, const uint64_t key[2])
+{
+    uint64_t start = key[0] & m_mask;
+    for (uint64_t i = 0; i < kProbeLength; i++)
+    {
+        Entry *entry = &m_entries[(start + i) & m_mask];
+        if (entry->sequence && entry->key[0] == key[0] && entry->key[1] == key[1] && std::memcmp(entry->md5, md5, sizeof(entry->md5)) == 0) return entry;
+    }
+    return nullptr;
+}
+
+// returns true if the score was found
+bool EvaluationCache::Lookup(const uint32_t *md5, const double *genes, size_t genomeLength, double *score)
+{
+    if (!m_header) return false;
+    uint64_t key[2];
+    HashKey(md5, genes, genomeLength, key);
+    Entry *entry = FindEntry(md5, key);
+    if (!entry)
+    {
+        m_misses++;
+        return false;
+    }
+    *score = entry->score;
+    m_hits++;
+    return true;
+}
+
+void EvaluationCache::Insert(const uint32_t *md5, const double *genes, size_t genomeLength, double score)
+{
+    if (!m_header) return;
+    uint64_t key[2];
+    HashKey(md5, genes, genomeLength, key);
+    Entry *entry = FindEntry(md5, key);
+    if (!entry)
+    {
+        // use the first empty slot in the probe window or failing that the oldest
+        uint64_t start = key[0] & m_mask;
+        Entry *oldest = nullptr;
+        for (uint64_t i = 0; i < kProbeLength; i++)
+        {
+            Entry *candidate = &m_entries[(start + i) & m_mask];
+            if (candidate->sequence == 0) { entry = candidate; break; }
+            if (!oldest || candidate->sequence < oldest->sequence) oldest = candidate;
+        }
+        if (entry) { m_header->count++; }
+        else { entry = oldest; m_evictions++; }
+        entry->key[0] = key[0];
+        entry->key[1] = key[1];
+        std::memcpy(entry->md5, md5, sizeof(entry->md5));
+    }
+    entry->score = score;
+    m_header->sequence++;
+    entry->sequence = m_header->sequence;
+}
@@ -0,0 +1,66 @@
+#ifndef EVALUATIONCACHE_H
+#define EVALUATIONCACHE_H
+
+#include "MemoryMappedFile.h"
+
+#include <string>
+#include <cstdint>
+
+// persistent (base XML MD5, genome hash) -> score cache
+// the cache is a fixed capacity open addressing hash table held in a memory mapped file
+// so it survives restarts. Each key probes a small window of slots and when the window
+// is full the oldest entry in the window is overwritten so the file never grows.
+
+class EvaluationCache
+{
+public:
+    EvaluationCache();
+    ~EvaluationCache();
+
+    int Open(const std::string &filename, size_t capacity);
+    void Close();
+    int Flush();
+
+    bool Lookup(const uint32_t *md5, const double *genes, size_t genomeLength, double *score);
+    void Insert(const uint32_t *md5, const double *genes, size_t genomeLength, double score);
+
+    bool IsOpen() const { return m_file.IsOpen(); }
+    uint64_t GetCount() const;
+    uint64_t GetCapacity() const;
+    uint64_t GetHits() const { return m_hits; }
+    uint64_t GetMisses() const { return m_misses; }
+    uint64_t GetEvictions() const { return m_evictions; }
+
+private:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t probeLength;
+        uint64_t capacity;
+        uint64_t count;
+        uint64_t sequence;
+    };
+
+    struct Entry
+    {
+        uint64_t key[2];
+        uint32_t md5[4];
+        double score;
+        uint64_t sequence; // zero means the slot is empty
+    };
+
+    static void HashKey(const uint32_t *md5, const double *genes, size_t genomeLength, uint64_t key[2]);
+    Entry *FindEntry(const uint32_t *md5, const uint64_t key[2]);
+
+    MemoryMappedFile m_file;
+    Header *m_header = nullptr;
+    Entry *m_entries = nullptr;
+    uint64_t m_mask = 0;
+
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_evictions = 0;
+};
+
+#endif // EVALUATIONCACHE_H
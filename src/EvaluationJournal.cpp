@@ -0,0 +1,191 @@
+#include "EvaluationJournal.h"
+#include "DataFile.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#if defined(WIN32) || defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static const char s_journalMagic[8] = {'A', 'G', 'A', '4', 'J', 'R', 'N', 'L'};
+static const uint32_t s_journalVersion = 1;
+
+static std::FILE *OpenFile(const std::string &filename, const char *mode)
+{
+#if defined(WIN32) || defined(_WIN32)
+    std::wstring wideMode(mode, mode + std::strlen(mode));
+    return _wfopen(DataFile::ConvertUTF8ToWide(filename).c_str(), wideMode.c_str());
+#else
+    return std::fopen(filename.c_str(), mode);
+#endif
+}
+
+EvaluationJournal::~EvaluationJournal()
+{
+    Close();
+}
+
+int EvaluationJournal::Open(const std::string &filename, const uint32_t *md5)
+{
+    Close();
+    std::error_code errorCode;
+    if (std::filesystem::exists(filename, errorCode))
+    {
+        // anything after the last complete record was cut short by a crash and is removed so that appending keeps the records aligned
+        EvaluationJournalReader reader;
+        if (reader.Open(filename)) return __LINE__;
+        if (std::memcmp(reader.GetHeader()->md5, md5, sizeof(reader.GetHeader()->md5)) != 0) return __LINE__;
+        size_t validSize = reader.GetValidSize();
+        reader.Close();
+        std::filesystem::resize_file(filename, validSize, errorCode);
+        if (errorCode) return __LINE__;
+        m_file = OpenFile(filename, "ab");
+        if (!m_file) return __LINE__;
+    }
+    else
+    {
+        m_file = OpenFile(filename, "wb");
+        if (!m_file) return __LINE__;
+        FileHeader header = {};
+        std::memcpy(header.magic, s_journalMagic, sizeof(header.magic));
+        header.version = s_journalVersion;
+        header.recordSize = sizeof(Record);
+        std::memcpy(header.md5, md5, sizeof(header.md5));
+        header.createdTime = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        if (std::fwrite(&header, sizeof(header), 1, m_file) != 1 || std::fflush(m_file))
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+            return __LINE__;
+        }
+    }
+    m_filename = filename;
+    m_batch.clear();
+    m_batchRecords = 0;
+    m_lastCommitTime = 0;
+    m_appended = 0;
+    m_dropped = 0;
+    m_deferredCommits = 0;
+    m_written = 0;
+    m_commits = 0;
+    m_writeError = 0;
+    m_writerStage.Start("journal", 4);
+    return 0;
+}
+
+void EvaluationJournal::Close()
+{
+    if (!m_file) return;
+    Commit(0, true);
+    m_writerStage.Stop();
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void EvaluationJournal::Append(const Record &record, const double *genes, double currentTime)
+{
+    if (!m_file) return;
+    m_appended++;
+    size_t recordBytes = sizeof(Record) + record.genomeLength * sizeof(double);
+    if (m_batch.size() + recordBytes > m_maxBatchBytes)
+    {
+        m_dropped++;
+        return;
+    }
+    const char *recordData = reinterpret_cast<const char *>(&record);
+    const char *genesData = reinterpret_cast<const char *>(genes);
+    m_batch.insert(m_batch.end(), recordData, recordData + sizeof(Record));
+    m_batch.insert(m_batch.end(), genesData, genesData + record.genomeLength * sizeof(double));
+    m_batchRecords++;
+    Commit(currentTime, false);
+}
+
+// this is only ever called from one thread so the writer queue cannot fill up between the check and the push
+// which means a commit never waits unless it is forced
+void EvaluationJournal::Commit(double currentTime, bool force)
+{
+    if (!m_file || m_batchRecords == 0) return;
+    if (!force && m_batchRecords < m_commitRecords && currentTime < m_lastCommitTime + m_commitInterval) return;
+    if (!force && m_writerStage.GetDepth() >= m_writerStage.GetCapacity())
+    {
+        m_deferredCommits++;
+        return;
+    }
+    m_lastCommitTime = currentTime;
+    uint64_t records = m_batchRecords;
+    size_t batchBytes = m_batch.size();
+    std::function<void ()> job = [this, batch = std::move(m_batch), records]() { WriteBatch(batch, records); };
+    m_batch = std::vector<char>();
+    m_batch.reserve(batchBytes);
+    m_batchRecords = 0;
+    if (!m_writerStage.Push(std::move(job))) job();
+}
+
+void EvaluationJournal::Flush()
+{
+    if (!m_file) return;
+    Commit(0, true);
+    m_writerStage.Flush();
+}
+
+std::string EvaluationJournal::GetStatusString()
+{
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "journal appended %" PRIu64 " written %" PRIu64 " commits %" PRIu64 " deferred %" PRIu64 " dropped %" PRIu64 " write errors %d",
+                  m_appended, m_written.load(), m_commits.load(), m_deferredCommits, m_dropped, m_writeError.load());
+    return buffer;
+}
+
+// runs on the writer stage thread
+void EvaluationJournal::WriteBatch(const std::vector<char> &batch, uint64_t records)
+{
+    if (std::fwrite(batch.data(), 1, batch.size(), m_file) != batch.size() || std::fflush(m_file))
+    {
+        m_writeError++;
+        return;
+    }
+#if defined(WIN32) || defined(_WIN32)
+    _commit(_fileno(m_file));
+#else
+    fsync(fileno(m_file));
+#endif
+    m_written += records;
+    m_commits++;
+}
+
+int EvaluationJournalReader::Open(const std::string &filename)
+{
+    Close();
+    if (m_file.Open(filename, 0, true)) return __LINE__;
+    if (m_file.GetSize() < sizeof(EvaluationJournal::FileHeader)) { Close(); return __LINE__; }
+    const EvaluationJournal::FileHeader *header = GetHeader();
+    if (std::memcmp(header->magic, s_journalMagic, sizeof(header->magic)) != 0 || header->version != s_journalVersion || header->recordSize != sizeof(EvaluationJournal::Record))
+    {
+        Close();
+        return __LINE__;
+    }
+    size_t offset = sizeof(EvaluationJournal::FileHeader);
+    while (m_file.GetSize() - offset >= sizeof(EvaluationJournal::Record))
+    {
+        const EvaluationJournal::Record *record = reinterpret_cast<const EvaluationJournal::Record *>(m_file.GetData() + offset);
+        size_t recordBytes = sizeof(EvaluationJournal::Record) + size_t(record->genomeLength) * sizeof(double);
+        if (m_file.GetSize() - offset < recordBytes) break;
+        m_offsets.push_back(offset);
+        offset += recordBytes;
+    }
+    m_validSize = offset;
+    return 0;
+}
+
+void EvaluationJournalReader::Close()
+{
+    m_file.Close();
+    m_offsets.clear();
+    m_validSize = 0;
+}
@@ -0,0 +1,111 @@
+#ifndef EVALUATIONJOURNAL_H
+#define EVALUATIONJOURNAL_H
+
+#include "PipelineStage.h"
+#include "MemoryMappedFile.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+// append only binary record of every evaluation that comes back
+// the evolve thread adds records to a batch in memory and whole batches are handed to a background stage that writes
+// and syncs them in one go (group commit) so the evolve thread never waits for the disk. If the writer falls behind
+// the batch keeps growing up to a limit and after that records are dropped and counted rather than blocking.
+// each record is a fixed size header followed by the genes so the file can be read in place with EvaluationJournalReader
+
+class EvaluationJournal
+{
+public:
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize; // size of Record so that a reader can check the layout
+        uint32_t md5[4]; // base XML file that the scores belong to
+        double createdTime; // seconds since the epoch
+    };
+
+    struct Record
+    {
+        uint64_t runID;
+        double score; // the score as returned rather than any averaged fitness
+        double dispatchTime; // seconds since the epoch
+        double returnTime;
+        uint32_t senderIP;
+        uint32_t senderPort;
+        int32_t parentRanks[2]; // indices into the fitness sorted population at the time of mating, -1 if not used
+        uint32_t genomeLength; // number of doubles that follow the record
+        uint32_t flags;
+    };
+
+    enum Flags { Reevaluation = 1, FromStartPopulation = 2, DuplicateWon = 4 };
+
+    EvaluationJournal() = default;
+    ~EvaluationJournal();
+
+    EvaluationJournal(const EvaluationJournal &) = delete;
+    EvaluationJournal &operator=(const EvaluationJournal &) = delete;
+
+    // an existing journal is appended to if it was written for the same base XML file
+    int Open(const std::string &filename, const uint32_t *md5);
+    void Close(); // commits everything and waits for it to be written
+
+    void Append(const Record &record, const double *genes, double currentTime);
+    void Commit(double currentTime, bool force); // called periodically so that a quiet run still commits
+    void Flush(); // commits and waits for the writer
+
+    void SetGroupCommit(size_t records, double interval) { m_commitRecords = records; m_commitInterval = interval; }
+
+    bool IsOpen() const { return m_file != nullptr; }
+    const std::string &GetFilename() const { return m_filename; }
+    uint64_t GetAppended() const { return m_appended; }
+    uint64_t GetWritten() const { return m_written; }
+    uint64_t GetDropped() const { return m_dropped; }
+    uint64_t GetCommits() const { return m_commits; }
+    std::string GetStatusString();
+
+private:
+    void WriteBatch(const std::vector<char> &batch, uint64_t records);
+
+    std::string m_filename;
+    std::FILE *m_file = nullptr;
+    PipelineStage m_writerStage;
+    std::vector<char> m_batch;
+    uint64_t m_batchRecords = 0;
+    double m_lastCommitTime = 0;
+    size_t m_commitRecords = 256;
+    double m_commitInterval = 1;
+    size_t m_maxBatchBytes = size_t(256) << 20;
+    uint64_t m_appended = 0;
+    uint64_t m_dropped = 0;
+    uint64_t m_deferredCommits = 0;
+    std::atomic<uint64_t> m_written = {0};
+    std::atomic<uint64_t> m_commits = {0};
+    std::atomic<int> m_writeError = {0};
+};
+
+// read only view of a journal
+// the file is mapped as it is when opened and a record that was only partly written is ignored
+class EvaluationJournalReader
+{
+public:
+    int Open(const std::string &filename);
+    void Close();
+
+    size_t GetSize() const { return m_offsets.size(); }
+    size_t GetValidSize() const { return m_validSize; } // bytes up to the end of the last complete record
+    const EvaluationJournal::FileHeader *GetHeader() const { return reinterpret_cast<const EvaluationJournal::FileHeader *>(m_file.GetData()); }
+    const EvaluationJournal::Record *GetRecord(size_t i) const { return reinterpret_cast<const EvaluationJournal::Record *>(m_file.GetData() + m_offsets[i]); }
+    const double *GetGenes(size_t i) const { return reinterpret_cast<const double *>(m_file.GetData() + m_offsets[i] + sizeof(EvaluationJournal::Record)); }
+
+private:
+    MemoryMappedFile m_file;
+    std::vector<size_t> m_offsets;
+    size_t m_validSize = 0;
+};
+
+#endif // EVALUATIONJOURNAL_H
@@ -0,0 +1,203 @@
+#include "ExperimentRouter.h"
+#include "GAASIO.h"
+
+#include "pystring.h"
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+
+using namespace std::string_literals;
+
+int ExperimentRouter::ReadExperimentsFile(const std::string &filename, std::vector<Experiment> *experiments)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening " << filename << "\n";
+        return __LINE__;
+    }
+    experiments->clear();
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        std::string stripped = pystring::strip(line);
+        if (stripped.size() == 0 || stripped[0] == '#') continue;
+        std::vector<std::string> tokens;
+        pystring::split(stripped, tokens, "\t"s);
+        for (auto &&token : tokens) token = pystring::strip(token);
+        if (tokens.size() < 4 || tokens.size() > 5)
+        {
+            std::cerr << "Error in " << filename << " line " << lineNumber << ": expected 4 or 5 tab separated fields\n";
+            return __LINE__;
+        }
+        Experiment experiment;
+        char *end = nullptr;
+        experiment.weight = std::strtod(tokens[0].c_str(), &end);
+        if (*end != '\0' || !(experiment.weight > 0))
+        {
+            std::cerr << "Error in " << filename << " line " << lineNumber << ": weight must be a positive number\n";
+            return __LINE__;
+        }
+        experiment.parameterFile = tokens[1];
+        experiment.baseXMLFile = tokens[2];
+        experiment.outputDirectory = tokens[3];
+        if (tokens.size() > 4) experiment.startingPopulation = tokens[4];
+        experiments->push_back(experiment);
+    }
+    if (experiments->size() == 0)
+    {
+        std::cerr << "Error: no experiments found in " << filename << "\n";
+        return __LINE__;
+    }
+    return 0;
+}
+
+void ExperimentRouter::AddEvolution(GAMain *gaMain, double weight)
+{
+    Route route;
+    route.gaMain = gaMain;
+    route.weight = weight;
+    m_routes.push_back(route);
+}
+
+void ExperimentRouter::Attach(ServerASIO *server)
+{
+    server->attach("req_gen_"s, std::bind(&ExperimentRouter::handleRequestGenome, this, std::placeholders::_1));
+    server->attach("req_xml_"s, std::bind(&ExperimentRouter::handleRequestXML, this, std::placeholders::_1));
+    server->attach("score___"s, std::bind(&ExperimentRouter::handleScore, this, std::placeholders::_1));
+    server->attach("heartbt_"s, std::bind(&ExperimentRouter::handleHeartbeat, this, std::placeholders::_1));
+    server->attach("resume__"s, std::bind(&ExperimentRouter::handleResume, this, std::placeholders::_1));
+    server->attach("admin___"s, std::bind(&ExperimentRouter::handleAdmin, this, std::placeholders::_1));
+    server->setCloseHandler(std::bind(&ExperimentRouter::handleSessionClosed, this, std::placeholders::_1));
+}
+
+void ExperimentRouter::handleRequestGenome(MessageASIO message)
+{
+    UpdateActive();
+    size_t index = Choose(GetEvolveIdentifier(message));
+    if (index >= m_routes.size()) return; // nothing is running yet or everything has finished so the client will retry
+    m_routes[index].served++;
+    m_routes[index].requests++;
+    m_routes[index].gaMain->handleRequestGenome(std::move(message));
+}
+
+void ExperimentRouter::handleRequestXML(MessageASIO message)
+{
+    // a finished evolution can still supply its XML so that a late client can make sense of what it was sent
+    // a client that has not been sent anything yet gets the XML of the evolution it would be sent a genome from
+    // but one asking for an evolution that is not hosted here is told there is no work rather than sent another experiment's XML
+    UpdateActive();
+    uint64_t evolveIdentifier = GetEvolveIdentifier(message);
+    size_t index = Find(evolveIdentifier);
+    if (index >= m_routes.size() && evolveIdentifier != 0)
+    {
+        SendNoWork(message, evolveIdentifier);
+        return;
+    }
+    if (index >= m_routes.size()) index = Choose(0);
+    if (index >= m_routes.size()) return;
+    m_routes[index].gaMain->handleRequestXML(std::move(message));
+}
+
+void ExperimentRouter::handleScore(MessageASIO message)
+{
+    size_t index = Find(GetEvolveIdentifier(message));
+    if (index < m_routes.size()) m_routes[index].gaMain->handleScore(std::move(message));
+}
+
+void ExperimentRouter::handleHeartbeat(MessageASIO message)
+{
+    size_t index = Find(GetEvolveIdentifier(message));
+    if (index < m_routes.size()) m_routes[index].gaMain->handleHeartbeat(std::move(message));
+}
+
+void ExperimentRouter::handleResume(MessageASIO message)
+{
+    size_t index = Find(GetEvolveIdentifier(message));
+    if (index < m_routes.size()) m_routes[index].gaMain->handleResume(std::move(message));
+}
+
+void ExperimentRouter::handleSessionClosed(uint64_t sessionID)
+{
+    // a session can hold runs from more than one evolution if it has switched
+    for (auto &&route : m_routes) route.gaMain->handleSessionClosed(sessionID);
+}
+
+void ExperimentRouter::handleAdmin(MessageASIO message)
+{
+    // every evolution acts on the command and replies with its own report prefix
+    for (auto &&route : m_routes) route.gaMain->handleAdmin(message);
+}
+
+void ExperimentRouter::UpdateActive()
+{
+    // an evolution that starts late joins at the current normalised count rather than taking every request until it catches up
+    double minimumShare = std::numeric_limits<double>::max();
+    for (auto &&route : m_routes)
+    {
+        if (route.active) minimumShare = std::min(minimumShare, double(route.served) / route.weight);
+    }
+    if (minimumShare == std::numeric_limits<double>::max()) minimumShare = 0;
+    for (auto &&route : m_routes)
+    {
+        bool active = route.gaMain->GetRequestGenomeQueueEnabled();
+        if (active && !route.active) route.served = std::max(route.served, uint64_t(minimumShare * route.weight));
+        route.active = active;
+    }
+}
+
+size_t ExperimentRouter::Find(uint64_t evolveIdentifier) const
+{
+    if (evolveIdentifier == 0) return m_routes.size();
+    for (size_t i = 0; i < m_routes.size(); i++)
+    {
+        if (m_routes[i].gaMain->GetEvolveIdentifier() == evolveIdentifier) return i;
+    }
+    return m_routes.size();
+}
+
+size_t ExperimentRouter::Choose(uint64_t evolveIdentifier) const
+{
+    // the share used is the normalised count after serving this request
+    size_t best = m_routes.size();
+    double bestShare = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < m_routes.size(); i++)
+    {
+        if (!m_routes[i].active) continue;
+        double share = double(m_routes[i].served + 1) / m_routes[i].weight;
+        if (share < bestShare)
+        {
+            bestShare = share;
+            best = i;
+        }
+    }
+    size_t current = Find(evolveIdentifier);
+    if (current < m_routes.size() && current != best && m_routes[current].active)
+    {
+        if (double(m_routes[current].served + 1) <= bestShare * m_routes[current].weight + m_affinitySlack) return current;
+    }
+    return best;
+}
+
+// a data message with no payload that echoes the evolveIdentifier the client asked for
+void ExperimentRouter::SendNoWork(const MessageASIO &message, uint64_t evolveIdentifier)
+{
+    std::vector<char> dataMessage(sizeof(GAMain::DataMessage), 0);
+    GAMain::DataMessage *dataMessagePtr = reinterpret_cast<GAMain::DataMessage *>(dataMessage.data());
+    strncpy(dataMessagePtr->text, "no_work", sizeof(dataMessagePtr->text));
+    dataMessagePtr->evolveIdentifier = evolveIdentifier;
+    dataMessagePtr->runID = std::numeric_limits<uint32_t>::max();
+    if (auto sharedPtr = message.session.lock()) sharedPtr->write(dataMessage.data(), dataMessage.size());
+}
+
+uint64_t ExperimentRouter::GetEvolveIdentifier(const MessageASIO &message)
+{
+    if (message.content.size() < sizeof(GAMain::RequestMessage)) return 0;
+    return reinterpret_cast<const GAMain::RequestMessage *>(message.content.data())->evolveIdentifier;
+}
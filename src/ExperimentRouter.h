@@ -0,0 +1,71 @@
+#ifndef EXPERIMENTROUTER_H
+#define EXPERIMENTROUTER_H
+
+#include "ServerASIO.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class GAMain;
+
+// shares one server between several independent evolutions
+// genome requests go to the running evolution that is furthest behind its weighted fair share but a client stays with
+// the evolution it is already working on unless that evolution is more than the affinity slack ahead because a switch
+// means the client has to fetch and load a different XML file
+// everything else is routed by the evolveIdentifier in the message and all the handlers are called from the server thread
+
+class ExperimentRouter
+{
+public:
+    struct Experiment
+    {
+        double weight = 1;
+        std::string parameterFile;
+        std::string baseXMLFile;
+        std::string outputDirectory;
+        std::string startingPopulation; // optional, the parameter file value is used if this is empty
+    };
+
+    // one experiment per line with tab separated weight, parameter file, base XML file, output directory and optionally the starting population
+    // blank lines and lines starting with # are ignored
+    static int ReadExperimentsFile(const std::string &filename, std::vector<Experiment> *experiments);
+
+    void AddEvolution(GAMain *gaMain, double weight);
+    void Attach(ServerASIO *server);
+
+    void handleRequestGenome(MessageASIO message);
+    void handleRequestXML(MessageASIO message);
+    void handleScore(MessageASIO message);
+    void handleHeartbeat(MessageASIO message);
+    void handleResume(MessageASIO message);
+    void handleSessionClosed(uint64_t sessionID);
+    void handleAdmin(MessageASIO message);
+
+    void SetAffinitySlack(double affinitySlack) { m_affinitySlack = affinitySlack; }
+
+    size_t GetSize() const { return m_routes.size(); }
+    uint64_t GetRequestCount(size_t index) const { return m_routes[index].requests; }
+
+private:
+    struct Route
+    {
+        GAMain *gaMain = nullptr;
+        double weight = 1;
+        uint64_t served = 0; // includes any offset applied when the evolution joined late
+        uint64_t requests = 0;
+        bool active = false;
+    };
+
+    void UpdateActive();
+    size_t Find(uint64_t evolveIdentifier) const;
+    size_t Choose(uint64_t evolveIdentifier) const;
+    static uint64_t GetEvolveIdentifier(const MessageASIO &message);
+    static void SendNoWork(const MessageASIO &message, uint64_t evolveIdentifier);
+
+    std::vector<Route> m_routes;
+    double m_affinitySlack = 16; // in genome requests
+};
+
+#endif // EXPERIMENTROUTER_H
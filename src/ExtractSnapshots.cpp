@@ -0,0 +1,79 @@
+#include "ArgParse.h"
+#include "SnapshotArchive.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std::string_literals;
+
+// recreates the BestGenome and Population text files from a snapshot archive written by AsynchronousGA4CL
+
+int main(int argc, const char **argv)
+{
+    ArgParse argparse;
+    argparse.Initialise(argc, argv, "ExtractSnapshots recreates the snapshot files stored in an AsynchronousGA4CL snapshot archive"s, 0, 0);
+    argparse.AddArgument("-i"s, "--inputArchive"s, "Snapshot archive file"s, ""s, 1, true, ArgParse::String);
+    argparse.AddArgument("-o"s, "--outputDirectory"s, "Directory for the extracted files [current directory]"s, "."s, 1, false, ArgParse::String);
+    argparse.AddArgument("-n"s, "--name"s, "Only extract the snapshots with these file names [all]"s, ""s, 1, 65536, false, ArgParse::String);
+    argparse.AddArgument("-L"s, "--last"s, "Only extract the newest best genome and the newest population"s);
+    argparse.AddArgument("-l"s, "--list"s, "List the snapshots rather than extracting them"s);
+
+    int err = argparse.Parse();
+    if (err)
+    {
+        argparse.Usage();
+        return 1;
+    }
+
+    std::string inputArchive, outputDirectory;
+    std::vector<std::string> names;
+    bool last = false, list = false;
+    argparse.Get("--inputArchive"s, &inputArchive);
+    argparse.Get("--outputDirectory"s, &outputDirectory);
+    argparse.Get("--name"s, &names);
+    argparse.Get("--last"s, &last);
+    argparse.Get("--list"s, &list);
+
+    SnapshotArchive archive;
+    if (archive.Open(inputArchive, true))
+    {
+        std::cerr << "Error: could not open snapshot archive \"" << inputArchive << "\"\n";
+        return 1;
+    }
+    if (archive.GetRecovered()) std::cerr << "Warning: the index of \"" << inputArchive << "\" was incomplete and the snapshots were found by scanning\n";
+
+    std::vector<size_t> selected;
+    for (size_t i = 0; i < archive.GetSize(); i++)
+    {
+        const SnapshotArchive::Entry &entry = archive.GetEntry(i);
+        if (names.size() && std::find(names.begin(), names.end(), entry.name) == names.end()) continue;
+        if (last)
+        {
+            bool newer = false;
+            for (size_t j = i + 1; j < archive.GetSize() && !newer; j++) newer = archive.GetEntry(j).kind == entry.kind;
+            if (newer) continue;
+        }
+        selected.push_back(i);
+    }
+
+    int errors = 0;
+    for (auto &&i : selected)
+    {
+        const SnapshotArchive::Entry &entry = archive.GetEntry(i);
+        if (list)
+        {
+            std::cout << entry.name << "\t" << (entry.kind == SnapshotArchive::Population ? "population" : "best genome") << "\t" << entry.size << "\t" << entry.md5 << "\n";
+            continue;
+        }
+        if (archive.Extract(i, outputDirectory))
+        {
+            std::cerr << "Error: could not extract \"" << entry.name << "\" to \"" << outputDirectory << "\"\n";
+            errors++;
+            continue;
+        }
+        std::cout << entry.name << " extracted\n";
+    }
+    return errors ? 1 : 0;
+}
@@ -14,9 +14,11 @@
 #include "Random.h"
 #include "Statistics.h"
 #include "GAASIO.h"
+#include "BinaryPopulationFile.h"
 #include "MD5.h"
 #include "ServerASIO.h"
 #include "ArgParse.h"
+#include "ExperimentRouter.h"
 
 #include "pystring.h"
 
@@ -28,12 +30,15 @@
 #include <iomanip>
 #include <fstream>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 #include <cstdarg>
 #include <thread>
 #include <cinttypes>
 #include <filesystem>
 #include <regex>
+#include <sstream>
+#include <limits>
 #include <string>
 #if ! ( defined(WIN32) || defined(_WIN32))
 #include <sys/resource.h>
@@ -57,13 +62,21 @@ int main(int argc, const char **argv)
     ArgParse argparse;
     argparse.Initialise(argc, argv, "AsynchronousGA4CL distributed genetic algorithm program "s + compileDate + " "s + compileTime, 0, 0);
     // required arguments
-    argparse.AddArgument("-p"s, "--parameterFile"s, "Parameter file specifying the GA options"s, ""s, 1, true, ArgParse::String);
-    argparse.AddArgument("-b"s, "--baseXMLFile"s, "Base XML file that is optimised"s, ""s, 1, true, ArgParse::String);
-    argparse.AddArgument("-s"s, "--startingPopulation"s, "Starting population"s, ""s, 1, true, ArgParse::String);
     argparse.AddArgument("-t"s, "--serverPort"s, "The server TCP port to listen on"s, ""s, 1, true, ArgParse::Int);
+    // required unless an experiments file is used
+    argparse.AddArgument("-p"s, "--parameterFile"s, "Parameter file specifying the GA options"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-b"s, "--baseXMLFile"s, "Base XML file that is optimised"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-s"s, "--startingPopulation"s, "Starting population"s, ""s, 1, false, ArgParse::String);
     // optional arguments
+    argparse.AddArgument("-a"s, "--adminToken"s, "Token that must start every admin___ command sent to the server port [admin commands refused]"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-e"s, "--experiments"s, "Tab separated file of weight, parameter file, base XML file, output directory and optional starting population to run several evolutions on one server [not used]"s, ""s, 1, false, ArgParse::String);
     argparse.AddArgument("-o"s, "--outputDirectory"s, "Output directory [uses current date & time]"s, ""s, 1, false, ArgParse::String);
     argparse.AddArgument("-l"s, "--logLevel"s, "0, 1, 2 outputs more detail with higher numbers [0]"s, "0"s, 1, false, ArgParse::Int);
+    argparse.AddArgument("-c"s, "--evaluationCache"s, "Persistent evaluation cache file shared between runs [not used]"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-C"s, "--evaluationCacheSize"s, "Maximum number of entries in a new evaluation cache [1048576]"s, "1048576"s, 1, false, ArgParse::Int);
+    argparse.AddArgument("-f"s, "--trustStartingFitness"s, "Use the starting population fitness values if it was produced from the same base XML file"s);
+    argparse.AddArgument("-r"s, "--resume"s, "Checkpoint file written by a previous run to continue from instead of the starting population [not used]"s, ""s, 1, false, ArgParse::String);
+    argparse.AddArgument("-w"s, "--waitForSwap"s, "Keep the server and clients when the run finishes and wait for a swap command with a new base XML file and starting population"s);
 
     int err = argparse.Parse();
     if (err)
@@ -72,30 +85,147 @@ int main(int argc, const char **argv)
         exit(1);
     }
 
-    int logLevel, serverPort;
-    std::string baseXMLFile, parameterFile, outputDirectory, startingPopulation;
+    int logLevel, serverPort, evaluationCacheSize;
+    bool trustStartingFitness = false;
+    bool waitForSwap = false;
+    std::string baseXMLFile, parameterFile, outputDirectory, startingPopulation, evaluationCache, experimentsFile, adminToken, resumeCheckpoint;
     argparse.Get("--logLevel"s, &logLevel);
     argparse.Get("--serverPort"s, &serverPort);
     argparse.Get("--baseXMLFile"s, &baseXMLFile);
     argparse.Get("--parameterFile"s, &parameterFile);
     argparse.Get("--outputDirectory"s, &outputDirectory);
     argparse.Get("--startingPopulation"s, &startingPopulation);
+    argparse.Get("--evaluationCache"s, &evaluationCache);
+    argparse.Get("--evaluationCacheSize"s, &evaluationCacheSize);
+    argparse.Get("--trustStartingFitness"s, &trustStartingFitness);
+    argparse.Get("--experiments"s, &experimentsFile);
+    argparse.Get("--adminToken"s, &adminToken);
+    argparse.Get("--waitForSwap"s, &waitForSwap);
+    argparse.Get("--resume"s, &resumeCheckpoint);
+
+    if (experimentsFile.size())
+    {
+        if (evaluationCache.size()) std::cerr << "Warning: the evaluation cache is not used with an experiments file\n";
+        if (resumeCheckpoint.size()) std::cerr << "Warning: --resume is not used with an experiments file\n";
+        return GAMain::ProcessExperiments(&argparse, experimentsFile, serverPort, logLevel, trustStartingFitness, adminToken);
+    }
+    if (parameterFile.empty() || baseXMLFile.empty() || (startingPopulation.empty() && resumeCheckpoint.empty()))
+    {
+        std::cerr << "Error: --parameterFile, --baseXMLFile and --startingPopulation or --resume are required unless --experiments is used\n";
+        argparse.Usage();
+        exit(1);
+    }
 
     GAMain ga;
     ga.setArgParse(&argparse);
     ga.SetLogLevel(logLevel);
     ga.LoadBaseXMLFile(baseXMLFile);
     ga.SetServerPort(serverPort);
+    ga.SetEvaluationCache(evaluationCache, size_t(std::max(evaluationCacheSize, 0)));
+    ga.SetTrustStartingFitness(trustStartingFitness);
+    ga.SetAdminToken(adminToken);
+    ga.SetWaitForSwap(waitForSwap);
+    ga.SetResumeCheckpoint(resumeCheckpoint);
     return ga.Process(parameterFile, outputDirectory, startingPopulation);
 }
 
+std::atomic<uint64_t> GAMain::s_lastEvolveIdentifier = {0};
+std::mutex GAMain::s_reportMutex;
+
 GAMain::GAMain()
 {
     m_outputLogFile.exceptions(std::ios::failbit|std::ios::badbit);
 }
 
+GAMain::~GAMain()
+{
+    StopPopulationLoader();
+}
+
+// runs each experiment in its own thread with a single shared server and handles stdin for all of them
+int GAMain::ProcessExperiments(ArgParse *argParse, const std::string &experimentsFile, int serverPort, int logLevel, bool trustStartingFitness, const std::string &adminToken)
+{
+    std::vector<ExperimentRouter::Experiment> experiments;
+    if (ExperimentRouter::ReadExperimentsFile(experimentsFile, &experiments)) return __LINE__;
+
+    std::vector<std::unique_ptr<GAMain>> evolutions;
+    ExperimentRouter router;
+    for (size_t i = 0; i < experiments.size(); i++)
+    {
+        auto ga = std::make_unique<GAMain>();
+        ga->setArgParse(argParse);
+        ga->SetLogLevel(logLevel);
+        ga->SetReportPrefix(ToString("[%zu] ", i));
+        if (ga->LoadBaseXMLFile(experiments[i].baseXMLFile)) std::cerr << "Error reading " << experiments[i].baseXMLFile << "\n";
+        ga->SetServerPort(serverPort);
+        ga->SetTrustStartingFitness(trustStartingFitness);
+        ga->SetAdminToken(adminToken);
+        ga->SetRedirectHandler(std::bind(&ExperimentRouter::handleRequestGenome, &router, std::placeholders::_1));
+        router.AddEvolution(ga.get(), experiments[i].weight);
+        evolutions.push_back(std::move(ga));
+    }
+
+    ServerASIO *server = new ServerASIO();
+    if (server->setPort(uint16_t(serverPort)))
+    {
+        std::cerr << "Unable to set listening port to " << serverPort << "\n";
+        delete server;
+        return __LINE__;
+    }
+    router.Attach(server);
+    for (auto &&ga : evolutions) ga->SetSharedServer(server);
+    std::thread *serverThread = new std::thread(&ServerASIO::start, server);
+    StopServerASIOGuard serverGuard(server, serverThread);
+
+    std::vector<int> results(evolutions.size(), 0);
+    std::atomic<size_t> finishedCount = {0};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < evolutions.size(); i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            results[i] = evolutions[i]->Process(experiments[i].parameterFile, experiments[i].outputDirectory, experiments[i].startingPopulation);
+            finishedCount++;
+        });
+    }
+    while (finishedCount < evolutions.size())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (!pollStdin()) continue;
+        std::string instruction;
+        std::getline(std::cin, instruction);
+        instruction = pystring::strip(instruction);
+        if (instruction == "stop"s)
+        {
+            for (auto &&ga : evolutions) ga->RequestStop();
+        }
+        if (instruction.rfind("log"s, 0) == 0)
+        {
+            int newLogLevel = std::atoi(instruction.c_str() + 3);
+            for (auto &&ga : evolutions)
+            {
+                ga->SetLogLevel(newLogLevel);
+                ga->ReportProgress(ToString("Log level changed to %d", newLogLevel), 0);
+            }
+        }
+    }
+    for (auto &&thread : threads) thread.join();
+
+    int firstError = 0;
+    for (size_t i = 0; i < evolutions.size(); i++)
+    {
+        evolutions[i]->ReportProgress(ToString("Experiment %zu weight %g genome requests routed %" PRIu64 " returned %d", i, experiments[i].weight, router.GetRequestCount(i), results[i]), 0);
+        if (results[i] && !firstError) firstError = results[i];
+    }
+    return firstError;
+}
+
 int GAMain::Process(const std::string &parameterFile, const std::string &outputDirectory, const std::string &startingPopulation)
 {
+    // console output and file output run as their own pipeline stages so that neither can hold up dispatch
+    // the evolve loop owns the populations and the other stages only ever see copies
+    m_reportingStage.Start("reporting"s, 65536);
+    StopPipelineStageGuard reportingStageGuard(&m_reportingStage);
     std::string arguments = pystring::join(" "s, m_argParse->rawArguments());
     ReportProgress(arguments, 0);
     // check and if necessary set some file open limits since this program can open a lot of files
@@ -128,21 +258,6 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
     }
 #endif
 
-#if ( __GNUC__ >= 14 ) || ( _MSC_VER >= 1929 ) // these versions required for std::format and std::chrono::current_zone support for C++20
-    auto currentTime = std::chrono::system_clock::now();
-    auto localSecondsTime = std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::current_zone()->to_local(currentTime)); //needs to be cast to seconds otherwise %S has decimal digits
-    std::string timeString = std::format("{:%Y-%m-%d_%H.%M.%S}", localSecondsTime);
-#else
-    time_t now = time(nullptr);
-    struct tm local;
-#ifdef _MSC_VER
-    localtime_s(&now, &local);
-#else
-    localtime_r(&now, &local);
-#endif
-    std::string timeString = ToString("%04d-%02d-%02d_%02d.%02d.%02d", local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec);
-#endif
-
     if (m_baseXMLFile.GetSize() == 0)
     {
         ReportProgress("Error: XML base file missing"s, 0);
@@ -156,6 +271,8 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
         return (__LINE__);
     }
     ReportProgress(m_parameterFile + " read"s, 0);
+    std::error_code errorCode;
+    m_parameterFileTime = std::filesystem::last_write_time(m_parameterFile, errorCode);
 
     // sanity check some of the parameters
     if (m_preferences.parentsToKeep >= m_preferences.populationSize)
@@ -169,6 +286,93 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
     m_preferences.startingPopulation = pystring::os::path::abspath(m_preferences.startingPopulation, std::filesystem::current_path().string());
 
     // create a directory for all the output
+    if (CreateOutputFolder(outputDirectory)) return __LINE__;
+    CloseFileGuard closeFileGuard(&m_outputLogFile);
+    m_persistenceStage.Start("persistence"s, 64);
+    StopPipelineStageGuard persistenceStageGuard(&m_persistenceStage); // stopped before the log file is closed
+    m_ingestStage.Start("ingest"s, 65536);
+    StopPipelineStageGuard ingestStageGuard(&m_ingestStage);
+
+    // the listener comes up before the starting population is read so that clients can connect and load the XML straight away
+    // a checkpoint is read first though because it sets the evolveIdentifier that the clients are given
+    m_xmlGenomeLength = uint32_t(m_preferences.genomeLength);
+    if (m_resumeCheckpointFile.size())
+    {
+        if (ReadStateCheckpoint(m_resumeCheckpointFile)) return __LINE__;
+    }
+    else
+    {
+        NewEvolveIdentifier();
+    }
+
+    // the server is created here rather than in Evolve so that clients stay connected when the base XML and population are swapped
+    ServerASIO *server = m_sharedServer;
+    std::thread *serverThread = nullptr;
+    if (!m_sharedServer)
+    {
+        server = new ServerASIO();
+        if (server->setPort(uint16_t(m_tcpPort)))
+        {
+            ReportProgress(ToString("Unable to set listening port to %d", m_tcpPort), 0);
+            delete server;
+            return __LINE__;
+        }
+        server->attach("req_gen_"s, std::bind(&GAMain::handleRequestGenome, this, std::placeholders::_1));
+        server->attach("req_xml_"s, std::bind(&GAMain::handleRequestXML, this, std::placeholders::_1));
+        server->attach("score___"s, std::bind(&GAMain::handleScore, this, std::placeholders::_1));
+        server->attach("heartbt_"s, std::bind(&GAMain::handleHeartbeat, this, std::placeholders::_1));
+        server->attach("resume__"s, std::bind(&GAMain::handleResume, this, std::placeholders::_1));
+        server->attach("admin___"s, std::bind(&GAMain::handleAdmin, this, std::placeholders::_1));
+        server->setCloseHandler(std::bind(&GAMain::handleSessionClosed, this, std::placeholders::_1));
+        serverThread = new std::thread(&ServerASIO::start, server);
+    }
+    StopServerASIOGuard serverGuard(m_sharedServer ? nullptr : server, serverThread);
+    server->getLocalAddress(&m_ipAddress, &m_port);
+    if (!m_sharedServer) m_requestGenomeQueueEnabled = true; // requests wait in the queue until the first genomes have been read
+
+    // the starting population is read in the background while the evaluation cache is opened
+    if (!m_resuming && InitialisePopulations()) return __LINE__;
+
+    // open the evaluation cache
+    if (m_evaluationCacheFile.size())
+    {
+        m_evaluationCacheFile = pystring::os::path::abspath(m_evaluationCacheFile, std::filesystem::current_path().string());
+        if (m_evaluationCache.Open(m_evaluationCacheFile, m_evaluationCacheSize))
+        {
+            ReportProgress("Error opening evaluation cache "s + m_evaluationCacheFile, 0);
+            return __LINE__;
+        }
+        ReportProgress(ToString("%s opened with %" PRIu64 " of %" PRIu64 " entries used", m_evaluationCacheFile.c_str(), m_evaluationCache.GetCount(), m_evaluationCache.GetCapacity()), 0);
+    }
+
+    while (true)
+    {
+        if (Evolve())
+        {
+            ReportProgress("Error: Terminated due to Evolve failure"s, 0);
+            CloseRequestGenomeQueue();
+            return __LINE__;
+        }
+        if (!m_swapPending && m_waitForSwap && !m_userStopped) WaitForSwap();
+        if (!m_swapPending) break;
+        if (ApplySwap())
+        {
+            ReportProgress("Error: Terminated due to swap failure"s, 0);
+            CloseRequestGenomeQueue();
+            return __LINE__;
+        }
+    }
+    CloseRequestGenomeQueue();
+    m_persistenceStage.Flush();
+    if (m_snapshotArchive.IsOpen() && m_snapshotArchive.Close()) ReportProgress("Error writing the index of the snapshot archive so it will be recovered when it is next opened"s, 0);
+
+    return 0;
+}
+
+// creates the output folder if necessary and opens a new log file in it
+int GAMain::CreateOutputFolder(const std::string &outputDirectory)
+{
+    std::string timeString = GetTimeString();
     if (outputDirectory.size())
     {
         m_outputFolderName = pystring::os::path::abspath(outputDirectory, std::filesystem::current_path().string());
@@ -208,22 +412,49 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
 
     // write log
     std::string logFileName = pystring::os::path::join(m_outputFolderName, "log.txt"s);
+    if (m_outputLogFile.is_open()) m_outputLogFile.close();
     m_outputLogFile.open(logFileName.c_str());
     if (m_outputLogFile.fail())
     {
         ReportProgress(ToString("Error opening \"%s\": %s", logFileName.c_str(), std::strerror(errno)), 0);
         return __LINE__;
     }
-    CloseFileGuard closeFileGuard(&m_outputLogFile);
     m_outputLogFile << "GA build " << __DATE__ << " " << __TIME__ "\n";
     m_outputLogFile << "Log produced " << timeString << "\n";
-    m_outputLogFile << "Arguments " << arguments << "\n";
+    m_outputLogFile << "Arguments " << pystring::join(" "s, m_argParse->rawArguments()) << "\n";
     m_outputLogFile << "parameterFile \"" << m_parameterFile << "\"\n";
     m_outputLogFile << m_preferences.GetPreferencesString() << "\n";
     m_outputLogFile.flush();
     ReportProgress(logFileName + " opened"s, 0);
 
-    // initialise the population
+    // the journal follows the output folder so that its scores always belong to one base XML file
+    m_evaluationJournal.Close();
+    if (m_preferences.journalEvaluations)
+    {
+        std::string journalFileName = pystring::os::path::join(m_outputFolderName, m_evaluationJournalName);
+        if (m_evaluationJournal.Open(journalFileName, m_md5.data())) ReportProgress("Error opening \""s + journalFileName + "\" so evaluations are not journalled"s, 0);
+        else ReportProgress(journalFileName + " opened"s, 0);
+    }
+
+    // so that long runs do not leave thousands of snapshot files in the output folder
+    m_snapshotArchive.Close();
+    if (m_preferences.snapshotArchive)
+    {
+        std::string archiveFileName = pystring::os::path::join(m_outputFolderName, m_snapshotArchiveName);
+        if (m_snapshotArchive.Open(archiveFileName)) ReportProgress("Error opening \""s + archiveFileName + "\" so snapshots are written as separate files"s, 0);
+        else ReportProgress(ToString("%s opened with %zu snapshots%s", archiveFileName.c_str(), m_snapshotArchive.GetSize(), m_snapshotArchive.GetRecovered() ? " after recovering its index" : ""), 0);
+    }
+
+    // the first population written in each folder is a keyframe so that the folder can be read on its own
+    m_populationDelta.Clear();
+    if (m_preferences.populationKeyframeEvery > 1 && (m_snapshotArchive.IsOpen() || m_preferences.onlyKeepBestPopulation))
+        ReportProgress("populationKeyframeEvery is ignored because "s + (m_snapshotArchive.IsOpen() ? "the snapshot archive is open"s : "onlyKeepBestPopulation is set"s), 0);
+    return 0;
+}
+
+// the population settings come from the preferences rather than the starting population or a checkpoint
+void GAMain::ConfigurePopulations()
+{
     m_startPopulation.SetGlobalCircularMutation(m_preferences.circularMutation);
     m_startPopulation.SetResizeControl(m_preferences.resizeControl);
     m_startPopulation.SetSelectionType(m_preferences.parentSelection);
@@ -237,7 +468,117 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
     m_startPopulation.SetFrameShiftMutationChance(m_preferences.frameShiftMutationChance);
     m_startPopulation.SetDuplicationMutationChance(m_preferences.duplicationMutationChance);
     m_startPopulation.SetMinimizeScore(m_preferences.minimizeScore);
-    if (m_startPopulation.ReadPopulation(m_preferences.startingPopulation.c_str()))
+
+    m_evolvePopulation.SetGlobalCircularMutation(m_preferences.circularMutation);
+    m_evolvePopulation.SetResizeControl(m_preferences.resizeControl);
+    m_evolvePopulation.SetSelectionType(m_preferences.parentSelection);
+    m_evolvePopulation.SetParentsToKeep(m_preferences.parentsToKeep);
+    m_evolvePopulation.SetGamma(m_preferences.gamma);
+    m_evolvePopulation.SetCrossoverChance(m_preferences.crossoverChance);
+    m_evolvePopulation.SetCrossoverType(m_preferences.crossoverType);
+    m_evolvePopulation.SetMultipleGaussian(m_preferences.multipleGaussian);
+    m_evolvePopulation.SetGaussianMutationChance(m_preferences.gaussianMutationChance);
+    m_evolvePopulation.SetBounceMutation(m_preferences.bounceMutation);
+    m_evolvePopulation.SetFrameShiftMutationChance(m_preferences.frameShiftMutationChance);
+    m_evolvePopulation.SetDuplicationMutationChance(m_preferences.duplicationMutationChance);
+    m_evolvePopulation.SetMinimizeScore(m_preferences.minimizeScore);
+    m_evolvePopulation.SetGenomePool(m_genomePool);
+}
+
+// sets up both populations from the preferences and starts reading the starting population in the background
+// the evolve loop takes the genomes as they are read so that dispatch can start before the whole file has been parsed
+int GAMain::InitialisePopulations()
+{
+    StopPopulationLoader();
+    m_startPopulation.Clear();
+    m_evolvePopulation.Clear();
+    m_startQueue.clear();
+    m_startPopulationLoaded = false;
+    ConfigurePopulations();
+
+    // the stored fitness values can only be used if the population was produced using the current base XML file
+    m_startingFitnessTrusted = false;
+    if (m_trustStartingFitness)
+    {
+        std::string recordedMD5;
+        if (m_preferences.randomiseModel) ReportProgress("Info: Starting population fitness not used because randomiseModel is set"s, 0);
+        else if (ReadMD5Record(m_preferences.startingPopulation, &recordedMD5)) ReportProgress("Info: Starting population fitness not used because the base XML MD5 record is missing"s, 0);
+        else if (recordedMD5 != std::string(hexDigest(m_md5.data()))) ReportProgress("Info: Starting population fitness not used because it was produced with a different base XML file"s, 0);
+        else m_startingFitnessTrusted = true;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_loadedGenomesMutex);
+        m_loadedGenomes.clear();
+    }
+    m_startGenomes.clear();
+    m_startFitnessValues.clear();
+    m_populationLoadError = 0;
+    m_populationLoaderAbort = false;
+    m_populationLoading = true;
+    m_populationLoaderThread = std::thread(&GAMain::LoadStartingPopulation, this, m_preferences.startingPopulation, m_preferences.randomiseModel);
+    ReportProgress("Reading "s + m_preferences.startingPopulation + " in the background"s, 1);
+    return 0;
+}
+
+// runs on the loader thread and hands over each genome as soon as it has been parsed
+void GAMain::LoadStartingPopulation(const std::string &filename, bool randomise)
+{
+    Random random;
+    int err = Population::ReadGenomes(filename.c_str(), [&](std::unique_ptr<Genome> genome, size_t /* populationSize */)
+    {
+        if (randomise) genome->Randomise(&random);
+        std::unique_lock<std::mutex> lock(m_loadedGenomesMutex);
+        m_loadedGenomes.push_back(std::move(genome));
+        return !m_populationLoaderAbort;
+    });
+    m_populationLoadError = err;
+    m_populationLoading = false;
+}
+
+void GAMain::StopPopulationLoader()
+{
+    m_populationLoaderAbort = true;
+    if (m_populationLoaderThread.joinable()) m_populationLoaderThread.join();
+}
+
+// queues the genomes read so far to be sent and builds the start population once the whole file has been read
+// the population is then checked and resized as it was when it was read in one go
+int GAMain::ProcessLoadedGenomes()
+{
+    bool loading = m_populationLoading; // checked before taking the genomes so that the last few cannot be missed
+    std::vector<std::unique_ptr<Genome>> loadedGenomes;
+    {
+        std::unique_lock<std::mutex> lock(m_loadedGenomesMutex);
+        loadedGenomes.swap(m_loadedGenomes);
+    }
+    for (auto &&genome : loadedGenomes)
+    {
+        if (genome->GetGenomeLength() != size_t(m_preferences.genomeLength))
+        {
+            ReportProgress("Error: Starting population genome does not match specified genome length"s, 0);
+            return __LINE__;
+        }
+        if (!m_startFitnessValues.insert(genome->GetFitness()).second) continue; // the population only keeps the first genome with a given fitness
+        if (!m_startingFitnessTrusted) m_startQueue.push_back(genome.get());
+        m_startGenomes.push_back(std::move(genome));
+    }
+    if (loading) return 0;
+
+    m_startPopulationLoaded = true;
+    StopPopulationLoader();
+    // inserting in population order means every genome goes on the end rather than shuffling the whole population up
+    bool minimizeScore = m_preferences.minimizeScore;
+    std::sort(m_startGenomes.begin(), m_startGenomes.end(), [minimizeScore](const std::unique_ptr<Genome> &lhs, const std::unique_ptr<Genome> &rhs) { return minimizeScore ? lhs->GetFitness() > rhs->GetFitness() : lhs->GetFitness() < rhs->GetFitness(); });
+    size_t fileSize = m_startGenomes.size();
+    for (auto &&genome : m_startGenomes)
+    {
+        if (m_startingFitnessTrusted) m_evolvePopulation.InsertGenome(std::make_unique<Genome>(*genome), m_preferences.populationSize);
+        m_startPopulation.InsertGenome(std::move(genome), fileSize);
+    }
+    m_startGenomes.clear();
+    m_startFitnessValues.clear();
+    if (m_populationLoadError)
     {
         ReportProgress("Error reading starting population: "s + m_preferences.startingPopulation, 0);
         return __LINE__;
@@ -249,47 +590,170 @@ int GAMain::Process(const std::string &parameterFile, const std::string &outputD
     }
     ReportProgress(m_preferences.startingPopulation + " read"s, 0);
 
-    if (m_startPopulation.GetPopulationSize() != m_preferences.populationSize)
+    if (m_startPopulation.GetPopulationSize() != m_preferences.populationSize && !m_startingFitnessTrusted)
     {
         ReportProgress("Info: Starting population size "s + std::to_string(m_startPopulation.GetPopulationSize()) + " does not match specified population size "s + std::to_string(m_preferences.populationSize), 0);
+        // genomes that are removed must not be sent and genomes that are added need to be queued
+        std::unordered_set<const Genome *> previousGenomes;
+        for (size_t i = 0; i < m_startPopulation.GetPopulationSize(); i++) previousGenomes.insert(m_startPopulation.GetGenome(i));
         m_startPopulation.ResizePopulation(m_preferences.populationSize);
+        std::unordered_set<const Genome *> currentGenomes;
+        for (size_t i = 0; i < m_startPopulation.GetPopulationSize(); i++) currentGenomes.insert(m_startPopulation.GetGenome(i));
+        std::erase_if(m_startQueue, [&currentGenomes](const Genome *genome) { return currentGenomes.count(genome) == 0; });
+        Random random;
+        for (size_t i = 0; i < m_startPopulation.GetPopulationSize(); i++)
+        {
+            if (previousGenomes.count(m_startPopulation.GetGenome(i))) continue;
+            if (m_preferences.randomiseModel) m_startPopulation.GetUnsharedGenome(i)->Randomise(&random);
+            m_startQueue.push_back(m_startPopulation.GetGenome(i));
+        }
+    }
+    if (m_startingFitnessTrusted) ReportProgress(ToString("Info: %zu genomes inserted into the population using their stored fitness", m_evolvePopulation.GetPopulationSize()), 0);
+    return 0;
+}
+
+std::string GAMain::GetTimeString()
+{
+#if ( __GNUC__ >= 14 ) || ( _MSC_VER >= 1929 ) // these versions required for std::format and std::chrono::current_zone support for C++20
+    auto currentTime = std::chrono::system_clock::now();
+    auto localSecondsTime = std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::current_zone()->to_local(currentTime)); //needs to be cast to seconds otherwise %S has decimal digits
+    std::string timeString = std::format("{:%Y-%m-%d_%H.%M.%S}", localSecondsTime);
+#else
+    time_t now = time(nullptr);
+    struct tm local;
+#ifdef _MSC_VER
+    localtime_s(&now, &local);
+#else
+    localtime_r(&now, &local);
+#endif
+    std::string timeString = ToString("%04d-%02d-%02d_%02d.%02d.%02d", local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec);
+#endif
+    return timeString;
+}
+
+void GAMain::NewEvolveIdentifier()
+{
+    // identifiers are based on the start time but they must still be unique when evolutions start within the same second
+    uint64_t evolveStartTime = uint64_t(std::chrono::duration_cast<std::chrono::duration<double, std::chrono::seconds::period>>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    uint64_t evolveIdentifier = s_lastEvolveIdentifier.load();
+    uint64_t newEvolveIdentifier;
+    do { newEvolveIdentifier = std::max(evolveStartTime, evolveIdentifier + 1); }
+    while (!s_lastEvolveIdentifier.compare_exchange_weak(evolveIdentifier, newEvolveIdentifier));
+    m_evolveIdentifier = newEvolveIdentifier;
+}
+
+// the genome requests that are still waiting are either dropped or passed back to be routed to an evolution that is still running
+void GAMain::CloseRequestGenomeQueue()
+{
+    std::deque<MessageASIO> unservedRequests;
+    {
+        std::unique_lock<std::mutex> lock(m_requestGenomeMutex);
+        m_requestGenomeQueueEnabled = false;
+        unservedRequests.swap(m_requestGenomeQueue);
     }
-    if (m_preferences.randomiseModel)
+    if (m_sharedServer && m_redirectHandler)
     {
-        ReportProgress("Info: Randomising starting population", 1);
-        m_startPopulation.Randomise();
+        for (auto &&message : unservedRequests) m_sharedServer->post([handler = m_redirectHandler, message]() { handler(message); });
     }
+}
 
-    if (m_startPopulation.GetGenome(0)->GetGenomeLength() != m_preferences.genomeLength)
+// arguments are the base XML file, the starting population and optionally the output directory
+// everything is checked here so that a bad swap is refused rather than ending the run
+int GAMain::RequestSwap(const std::vector<std::string> &arguments, std::string *result)
+{
+    if (m_sharedServer)
     {
-        ReportProgress("Error: Starting population genome does not match specified genome length"s, 0);
-        return __LINE__;
+        *result = "error swap is not available when the server is shared between experiments"s;
     }
-    if (m_preferences.randomiseModel)
+    else if (arguments.size() < 2 || arguments.size() > 3)
     {
-        m_startPopulation.Randomise();
+        *result = "error swap needs a base XML file, a starting population and optionally an output directory"s;
     }
+    else if (m_swapPending)
+    {
+        *result = "error a swap is already pending"s;
+    }
+    else
+    {
+        std::string baseXMLFile = pystring::os::path::abspath(arguments[0], std::filesystem::current_path().string());
+        std::string startingPopulation = pystring::os::path::abspath(arguments[1], std::filesystem::current_path().string());
+        DataFile xmlFile;
+        std::unique_ptr<Genome> firstGenome; // only the first genome is read here since the full population is read in the background
+        Population::ReadGenomes(startingPopulation.c_str(), [&firstGenome](std::unique_ptr<Genome> genome, size_t /* populationSize */) { firstGenome = std::move(genome); return false; });
+        if (xmlFile.ReadFile(baseXMLFile) || xmlFile.GetSize() == 0)
+        {
+            *result = "error reading "s + baseXMLFile;
+        }
+        else if (!firstGenome)
+        {
+            *result = "error reading "s + startingPopulation;
+        }
+        else if (firstGenome->GetGenomeLength() != size_t(m_preferences.genomeLength))
+        {
+            *result = ToString("error %s has genome length %zu but genomeLength is %d", startingPopulation.c_str(), firstGenome->GetGenomeLength(), m_preferences.genomeLength);
+        }
+        else
+        {
+            m_swapBaseXMLFile = baseXMLFile;
+            m_swapStartingPopulation = startingPopulation;
+            m_swapOutputDirectory = arguments.size() > 2 ? arguments[2] : ""s;
+            m_swapPending = true;
+            *result = "ok swap to "s + baseXMLFile + " after the current runs have drained"s;
+        }
+    }
+    ReportProgress("Swap: "s + *result, 0);
+    return m_swapPending ? 0 : __LINE__;
+}
 
-    m_evolvePopulation.SetGlobalCircularMutation(m_preferences.circularMutation);
-    m_evolvePopulation.SetResizeControl(m_preferences.resizeControl);
-    m_evolvePopulation.SetSelectionType(m_preferences.parentSelection);
-    m_evolvePopulation.SetParentsToKeep(m_preferences.parentsToKeep);
-    m_evolvePopulation.SetGamma(m_preferences.gamma);
-    m_evolvePopulation.SetCrossoverChance(m_preferences.crossoverChance);
-    m_evolvePopulation.SetCrossoverType(m_preferences.crossoverType);
-    m_evolvePopulation.SetMultipleGaussian(m_preferences.multipleGaussian);
-    m_evolvePopulation.SetGaussianMutationChance(m_preferences.gaussianMutationChance);
-    m_evolvePopulation.SetBounceMutation(m_preferences.bounceMutation);
-    m_evolvePopulation.SetFrameShiftMutationChance(m_preferences.frameShiftMutationChance);
-    m_evolvePopulation.SetDuplicationMutationChance(m_preferences.duplicationMutationChance);
-    m_evolvePopulation.SetMinimizeScore(m_preferences.minimizeScore);
-
-    if (Evolve())
+// the server stays up with the genome request queue still enabled so that the clients simply wait
+void GAMain::WaitForSwap()
+{
+    ReportProgress("Waiting for swap"s, 0);
+    while (!m_swapPending)
     {
-        ReportProgress("Error: Terminated due to Evolve failure"s, 0);
-        return __LINE__;
+        if (m_stopRequested.exchange(false)) break;
+        if (pollStdin())
+        {
+            std::string instruction;
+            std::getline(std::cin, instruction);
+            instruction = pystring::strip(instruction);
+            if (instruction == "stop"s) break;
+            if (instruction.rfind("swap "s, 0) == 0)
+            {
+                std::vector<std::string> arguments;
+                pystring::split(instruction, arguments);
+                std::string result;
+                RequestSwap(std::vector<std::string>(arguments.begin() + 1, arguments.end()), &result);
+            }
+        }
+        ClearScoreQueue(); // anything that arrives now belongs to the finished evolution
+        ClearHeartbeatQueue();
+        ClearClosedSessionQueue();
+        ProcessAdminCommands([]() { return "waiting for swap"s; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+    if (!m_swapPending) ReportProgress("Stopped by user"s, 0);
+}
 
+// the new XML, MD5 and evolveIdentifier are installed together so that a client can never load a mismatched set
+// clients pick up the change from the evolveIdentifier in the next genome they are sent and then request the new XML
+int GAMain::ApplySwap()
+{
+    m_swapPending = false;
+    m_persistenceStage.Flush();
+    {
+        std::unique_lock<std::mutex> lock(m_baseXMLMutex);
+        if (LoadBaseXMLFile(m_swapBaseXMLFile))
+        {
+            ReportProgress("Error reading base XML file "s + m_swapBaseXMLFile, 0);
+            return __LINE__;
+        }
+        NewEvolveIdentifier();
+    }
+    ReportProgress(m_swapBaseXMLFile + " read"s, 0);
+    m_preferences.startingPopulation = m_swapStartingPopulation;
+    if (CreateOutputFolder(m_swapOutputDirectory)) return __LINE__;
+    if (InitialisePopulations()) return __LINE__;
     return 0;
 }
 
@@ -310,170 +774,489 @@ int GAMain::Evolve()
 {
     // This is the asynchronous evolution loop
     double evolveStartTime = std::chrono::duration_cast<std::chrono::duration<double, std::chrono::seconds::period>>(std::chrono::steady_clock::now().time_since_epoch()).count();
-    m_evolveIdentifier = uint64_t(evolveStartTime);
-    uint32_t submitCount = 0;
+    double wallClockOffset = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count() - evolveStartTime; // journal times are since the epoch
+    uint64_t submitCount = 0;
     uint32_t returnCount = 0;
-    int startPopulationIndex = 0;
     TenPercentiles tenPercentiles;
     double bestFitness = m_preferences.minimizeScore ? std::numeric_limits<double>::max(): -std::numeric_limits<double>::max();
     double lastBestFitness = m_preferences.minimizeScore ? std::numeric_limits<double>::max(): -std::numeric_limits<double>::max();
     std::string filename;
     bool stopSendingFlag = false;
-    std::map<uint32_t, std::unique_ptr<RunSpecifier>> runningList;
+    RunningList runningList;
+    runningList.SetGenomePool(m_genomePool); // genomes that drop out of the population are reused for offspring
+    TimerWheel timerWheel(0.1);
+    std::vector<TimerWheel::Timer> expiredTimers;
+    LatencyTracker latencyTracker(1000);
+    double leaseDuration = m_preferences.watchDogTimerLimit;
+    uint64_t expiredLeaseCount = 0;
+    // straggler mitigation: runs older than a high quantile of the recent evaluation times are sent again to the next idle client
+    // and whichever score comes back first is used. The late score is discarded because the runID is no longer running.
+    double stragglerAge = 0; // 0 means speculation is not active yet
+    struct CompletedDuplicate
+    {
+        uint32_t runID;
+        double returnTime;
+        bool duplicateWon; // time is only saved when the duplicate beat the original host
+    };
+    std::deque<CompletedDuplicate> completedDuplicates; // recent duplicated runs so that the late score can be timed
+    const size_t maxCompletedDuplicates = 1024;
+    uint64_t duplicateCount = 0;
+    uint64_t duplicateWins = 0;
+    uint64_t lateDuplicateScores = 0;
+    double duplicateTimeSaved = 0;
+    // runs held by sessions that have closed are kept in the running list with their runID until their lease expires
+    // and with requeueClosedSessions they are also sent to the next idle client
+    // a reconnecting client can reclaim its run with resume__ or simply send the score since scores are matched by runID
+    m_requeueCount = 0;
+    m_resumeCount = 0;
+    // all the work that can be sent goes through a dispatch queue with weighted priority classes
+    DispatchQueue dispatchQueue;
+    dispatchQueue.Clear(evolveStartTime);
+    for (int i = 0; i < DispatchQueue::NumberOfClasses; i++)
+    {
+        dispatchQueue.SetWeight(DispatchQueue::PriorityClass(i), m_preferences.dispatchWeights[size_t(i)]);
+        dispatchQueue.SetMaximumAge(DispatchQueue::PriorityClass(i), m_preferences.dispatchMaximumAges[size_t(i)]);
+    }
+    uint64_t eliteReevaluations = 0;
+    m_hostStatistics.Clear();
+    m_hostStatistics.SetLatencySmoothing(m_preferences.hostLatencySmoothing);
+    m_hostStatistics.SetThroughputTimeConstant(m_preferences.hostThroughputTimeConstant);
+    m_fastHostSelections = 0;
+    m_prefetchDeferrals = 0;
+    m_activeClients = 0;
+    m_populationSize = size_t(m_preferences.populationSize);
+    // the in flight cap limits how far the asynchronous GA can run ahead of selection
+    uint64_t inFlightCapCount = 0;
+    bool lastInFlightCapped = false;
+    double elasticPopulationInterval = 10; // population resizing is not urgent and needs some hysteresis
+    double lastElasticTime = evolveStartTime;
+    double parameterFileCheckInterval = 1; // an edited parameter file is picked up within a second
+    double lastParameterFileCheck = evolveStartTime;
+    std::vector<char> dataMessage; // reused so that the dispatch path does not allocate in the steady state
     bool shouldStop = false;
+    bool draining = false;
+    bool abandonDrain = false;
+    double drainDeadline = 0;
 
-    ReportInfo(ToString("Evolve Identifier = %" PRIu64, m_evolveIdentifier));
-
-    // start the TCP server
-    ServerASIO *server = new ServerASIO();
-    if (server->setPort(uint16_t(m_tcpPort)))
+    if (m_resuming)
     {
-        ReportProgress(ToString("Unable to set listening port to %d", m_tcpPort), 0);
-        delete server;
-        return __LINE__;
+        // runs that were out when the checkpoint was written are sent again
+        // but since the evolveIdentifier is unchanged a client that still has one can return its score as usual
+        m_resuming = false;
+        submitCount = m_resumeCounters.submitCount;
+        returnCount = m_resumeCounters.returnCount;
+        bestFitness = m_resumeCounters.bestFitness;
+        lastBestFitness = m_resumeCounters.lastBestFitness;
+        stopSendingFlag = m_resumeCounters.stopSendingFlag;
+        eliteReevaluations = m_resumeCounters.eliteReevaluations;
+        m_populationSize = m_resumeCounters.populationSize;
+        for (auto &&run : m_resumeRuns)
+        {
+            RunningList::RunSpecifier *runSpecifier = runningList.Insert(run.runID, std::move(run.genome));
+            runSpecifier->awaitingDispatch = true;
+            runSpecifier->reevaluation = run.reevaluation;
+            dispatchQueue.Push(run.reevaluation ? DispatchQueue::EliteClass : DispatchQueue::RequeueClass, run.runID, evolveStartTime);
+        }
+        ReportProgress(ToString("Resumed at returnCount = %" PRIu32 " submitCount = %" PRIu64 " with %zu runs to send again", returnCount, submitCount, m_resumeRuns.size()), 0);
+        m_resumeRuns.clear();
     }
-    server->attach("req_gen_"s, std::bind(&GAMain::handleRequestGenome, this, std::placeholders::_1));
-    server->attach("req_xml_"s, std::bind(&GAMain::handleRequestXML, this, std::placeholders::_1));
-    server->attach("score___"s, std::bind(&GAMain::handleScore, this, std::placeholders::_1));
-    std::thread *serverThread = new std::thread(&ServerASIO::start, server);
-    StopServerASIOGuard serverGuard(server, serverThread);
+    auto evolveCounters = [&]() { return EvolveCounters{submitCount, returnCount, bestFitness, lastBestFitness, stopSendingFlag, eliteReevaluations, m_populationSize}; };
+    m_genomePool->ReserveBlocks(3 * m_populationSize);
+
+    ReportInfo(ToString("Evolve Identifier = %" PRIu64, m_evolveIdentifier.load()));
+
     m_requestGenomeQueueEnabled = true;
-    server->getLocalAddress(&m_ipAddress, &m_port);
+    OpenScoreQueue(true);
+    // offspring are bred ahead on their own stage from copies of the population that are published whenever it has changed
+    if (m_preferences.offspringPrefetch > 0) m_offspringProducer.Start("offspring"s, size_t(m_preferences.offspringPrefetch), m_genomePool);
+    StopOffspringProducerGuard offspringProducerGuard(&m_offspringProducer);
+    bool populationChanged = true;
 
     int progressValue = 0;
     int lastProgressValue = -1;
     double lastTime = evolveStartTime;
     double lastSlowTime = evolveStartTime;
     double fastPeriodicTaskInterval = 0.1; // this is used for things like response to user interaction so 0.1s is about as high as it should be
-    double slowPeriodicTaskInterval = 100; // this is used for internal housekeeping of things like the watchDogTimerLimit so 100s should be fine
-    while (returnCount < uint32_t(m_preferences.maxReproductions) && stopSendingFlag == false && shouldStop == false)
+    double slowPeriodicTaskInterval = 100; // this is used for internal housekeeping and reporting so 100s should be fine
+    double hostForgetLeases = 5; // hosts not heard from for this many lease durations are dropped from the host statistics
+    timerWheel.Initialise(evolveStartTime);
+    while (true)
     {
         double currentTime = std::chrono::duration_cast<std::chrono::duration<double, std::chrono::seconds::period>>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (!m_startPopulationLoaded && ProcessLoadedGenomes())
+        {
+            StopPopulationLoader();
+            OpenScoreQueue(false);
+            return __LINE__;
+        }
+        if (populationChanged && m_offspringProducer.Publish(m_evolvePopulation)) populationChanged = false;
+        if (!draining && (returnCount >= uint32_t(m_preferences.maxReproductions) || stopSendingFlag || shouldStop || m_swapPending))
+        {
+            // no new work is sent but evaluations that are already out are given time to come back
+            if (m_preferences.drainTimeLimit < 0) break;
+            draining = true;
+            drainDeadline = currentTime + (m_preferences.drainTimeLimit > 0 ? m_preferences.drainTimeLimit : leaseDuration);
+            std::vector<uint64_t> unsentEliteRunIDs;
+            runningList.ForEach([&unsentEliteRunIDs](const RunningList::RunSpecifier &runSpecifier) { if (runSpecifier.awaitingDispatch && runSpecifier.reevaluation) unsentEliteRunIDs.push_back(runSpecifier.runID); });
+            for (auto &&runID : unsentEliteRunIDs) runningList.Erase(runID);
+            ReportProgress(ToString("Draining %zu runs for up to %g s", runningList.GetSize(), drainDeadline - currentTime), 0);
+        }
+        if (draining && (runningList.GetSize() == 0 || currentTime >= drainDeadline || abandonDrain))
+        {
+            ReportProgress(ToString("Drain finished with %zu runs outstanding", runningList.GetSize()), 0);
+            break;
+        }
         if (currentTime >= lastTime + fastPeriodicTaskInterval) // this part of the loop is for things that don't need to be done all that often
         {
             lastTime = currentTime;
-            if (pollStdin())
+            if (m_stopRequested.exchange(false))
+            {
+                if (draining) abandonDrain = true;
+                shouldStop = true;
+                ReportProgress("Stopped by user"s, 0);
+            }
+            if (!m_sharedServer && pollStdin())
             {
                 std::string instruction;
                 std::getline(std::cin, instruction);
                 instruction = pystring::strip(instruction);
                 if (instruction == "stop"s)
                 {
+                    // a second stop does not wait for the drain to finish
+                    if (draining) abandonDrain = true;
                     shouldStop = true;
                     ReportProgress("Stopped by user"s, 0);
                 }
                 if (instruction.rfind("log"s, 0) == 0)
                 {
                     m_logLevel = std::atoi(instruction.c_str() + 3); // used std::atoi rather that std::stoi because std::atoi does not throw exceptions
-                    ReportProgress(ToString("Log level changed to %d", m_logLevel), 0);
+                    ReportProgress(ToString("Log level changed to %d", m_logLevel.load()), 0);
+                }
+                if (instruction.rfind("swap "s, 0) == 0)
+                {
+                    std::vector<std::string> arguments;
+                    pystring::split(instruction, arguments);
+                    std::string result;
+                    RequestSwap(std::vector<std::string>(arguments.begin() + 1, arguments.end()), &result);
+                }
+            }
+            // renew leases and then expire the ones that have run out
+            // timers are not cancelled when a score arrives or a lease is renewed so a timer that fires is checked against the running list
+            ProcessClosedSessions(&runningList, &dispatchQueue, currentTime); // before the heartbeats so that a resume from a reconnected client wins
+            ProcessHeartbeats(&runningList, currentTime);
+            ProcessAdminCommands([&]()
+            {
+                return ToString("returns %" PRIu32 " sent %" PRIu64 " running %zu population %zu best %g clients %zu lease %g s paused %d draining %d log %d queues %zu %zu %zu %zu %zu %zu",
+                                returnCount, submitCount, runningList.GetSize(), m_populationSize, m_evolvePopulation.GetPopulationSize() ? m_evolvePopulation.GetLastGenome()->GetFitness() : 0.0,
+                                m_activeClients, leaseDuration, int(m_dispatchPaused), int(draining), m_logLevel.load(),
+                                GenomeRequestQueueSize(), m_ingestStage.GetDepth(), ScoreQueueSize(), m_offspringProducer.GetDepth(), m_persistenceStage.GetDepth(), m_reportingStage.GetDepth());
+            });
+            m_evaluationJournal.Commit(currentTime, false);
+            if (m_checkpointRequested)
+            {
+                m_checkpointRequested = false;
+                WriteCheckpoint(returnCount);
+                WriteStateCheckpoint(evolveCounters(), runningList);
+            }
+            if (currentTime >= lastParameterFileCheck + parameterFileCheckInterval)
+            {
+                lastParameterFileCheck = currentTime;
+                std::error_code errorCode;
+                std::filesystem::file_time_type parameterFileTime = std::filesystem::last_write_time(m_parameterFile, errorCode);
+                if (!errorCode && parameterFileTime != m_parameterFileTime)
+                {
+                    // a failed reload is tried again on every check because the file may still be being written
+                    // and the finished file can have the same time stamp but the failure is only reported once
+                    std::string result;
+                    if (ReloadPreferences(&result, parameterFileTime != m_parameterFileFailedTime) == 0) m_parameterFileTime = parameterFileTime;
+                    else m_parameterFileFailedTime = parameterFileTime;
+                }
+            }
+            if (m_dispatchSettingsChanged)
+            {
+                m_dispatchSettingsChanged = false;
+                for (int i = 0; i < DispatchQueue::NumberOfClasses; i++)
+                {
+                    dispatchQueue.SetWeight(DispatchQueue::PriorityClass(i), m_preferences.dispatchWeights[size_t(i)]);
+                    dispatchQueue.SetMaximumAge(DispatchQueue::PriorityClass(i), m_preferences.dispatchMaximumAges[size_t(i)]);
+                }
+            }
+            expiredTimers.clear();
+            timerWheel.Advance(currentTime, &expiredTimers);
+            for (auto &&timer : expiredTimers)
+            {
+                RunningList::RunSpecifier *runSpecifier = runningList.Find(timer.id);
+                if (!runSpecifier) continue;
+                if (timer.type == StragglerTimer)
+                {
+                    // a timer left over from before the run was requeued is ignored because the new dispatch has its own
+                    if (runSpecifier->duplicateTime == 0 && !runSpecifier->awaitingDispatch && currentTime - runSpecifier->startTime >= stragglerAge - timerWheel.GetResolution())
+                        dispatchQueue.Push(DispatchQueue::StragglerClass, timer.id, currentTime);
+                    continue;
+                }
+                if (runSpecifier->awaitingDispatch) // nobody is evaluating this run so there is nothing to expire yet
+                {
+                    timerWheel.Schedule(timer.id, timer.type, currentTime + leaseDuration);
+                    continue;
                 }
+                if (runSpecifier->leaseExpiry > currentTime)
+                {
+                    timerWheel.Schedule(timer.id, timer.type, runSpecifier->leaseExpiry);
+                    continue;
+                }
+                std::string address = ConvertAddressPortToString(runSpecifier->senderIP, uint16_t(runSpecifier->senderPort));
+                ReportProgress(ToString("RunID %" PRIu64 " host %s has been deleted due to lease expiry after %g s", runSpecifier->runID, address.c_str(), currentTime - runSpecifier->startTime), 1);
+                runningList.Erase(timer.id);
+                expiredLeaseCount++;
+            }
+            leaseDuration = LeaseDuration(&latencyTracker);
+            m_activeClients = m_hostStatistics.GetActiveHostCount(currentTime - leaseDuration);
+            if (m_preferences.elasticPopulation && currentTime >= lastElasticTime + elasticPopulationInterval)
+            {
+                lastElasticTime = currentTime;
+                UpdateElasticPopulation();
             }
-            progressValue = int(100 * returnCount / m_preferences.maxReproductions);
+            if (m_preferences.stragglerQuantile <= 0) stragglerAge = 0; // can be turned off by reloading the parameter file
+            else if (latencyTracker.GetSampleCount() >= size_t(std::max(m_preferences.leaseMinimumSamples, 1))) stragglerAge = latencyTracker.GetQuantile(m_preferences.stragglerQuantile);
+            progressValue = std::min(int(100 * returnCount / m_preferences.maxReproductions), 100);
             if (progressValue != lastProgressValue)
             {
                 lastProgressValue = progressValue;
                 ReportInfo(ToString("Progress = %d", progressValue));
             }
+            populationChanged = true; // settings and the population size can be changed by the admin channel or a reload
         }
         if (currentTime >= lastSlowTime + slowPeriodicTaskInterval) // this part of the loop is for things that don't need to be done all that often
         {
             lastSlowTime = currentTime;
-            for (auto &&it = runningList.begin(); it != runningList.end();)
-            {
-                if (currentTime - it->second->startTime > m_preferences.watchDogTimerLimit)
-                {
-                    std::string address = ConvertAddressPortToString(it->second->senderIP, it->second->senderPort);
-                    ReportProgress(ToString("RunID %" PRIu32 " host %s has been deleted due to watchdog timer limit", it->first, address.c_str()), 1);
-                    it = runningList.erase(it); // erase invalidates the iterator but returns the next valid iterator
-                }
-                else { it++; }
-            }
+            ReportProgress(ToString("Lease duration %g s running %zu timers %zu expired %" PRIu64, leaseDuration, runningList.GetSize(), timerWheel.GetSize(), expiredLeaseCount), 1);
+            ReportProgress(ToString("Straggler age %g s duplicates %" PRIu64 " (%.2f%% of dispatches) wins %" PRIu64 " time saved %g s", stragglerAge, duplicateCount,
+                                    submitCount ? 100.0 * double(duplicateCount) / double(submitCount) : 0.0, duplicateWins, duplicateTimeSaved), 1);
+            m_hostStatistics.Prune(currentTime - hostForgetLeases * leaseDuration);
+            ReportHostStatistics(currentTime, leaseDuration, 2);
+            ReportProgress(ToString("Active clients %zu population size %zu in flight cap reached %" PRIu64 " times", m_activeClients, m_populationSize, inFlightCapCount), 1);
+            ReportProgress(ToString("Queue depths: genome requests %zu scores %zu ", GenomeRequestQueueSize(), ScoreQueueSize()) + m_ingestStage.GetStatusString() + " "s + m_offspringProducer.GetStatusString() + " "s +
+                           m_persistenceStage.GetStatusString() + " "s + m_reportingStage.GetStatusString(), 1);
+            if (m_evaluationJournal.IsOpen()) ReportProgress(m_evaluationJournal.GetStatusString(), 1);
         }
 
-        size_t genomeQueueSize = GenomeRequestQueueSize();
+        // when the cap is reached only work that is already counted in the running list can be sent
+        bool inFlightCapped = m_preferences.maxInFlightMultiple > 0 && double(runningList.GetSize()) >= m_preferences.maxInFlightMultiple * double(m_populationSize);
+        if (inFlightCapped && !lastInFlightCapped) inFlightCapCount++;
+        lastInFlightCapped = inFlightCapped;
+        uint32_t availableMask = DispatchQueue::ClassBit(DispatchQueue::RequeueClass) | DispatchQueue::ClassBit(DispatchQueue::StragglerClass);
+        if (!draining) availableMask |= DispatchQueue::ClassBit(DispatchQueue::EliteClass);
+        if (!inFlightCapped && !draining)
+        {
+            // offspring need the whole starting population but its genomes can be sent as soon as they have been read
+            if (m_startPopulationLoaded) availableMask |= DispatchQueue::ClassBit(DispatchQueue::OffspringClass);
+            if (m_startQueue.size()) availableMask |= DispatchQueue::ClassBit(DispatchQueue::StartPopulationClass);
+        }
+        bool queuedWork = dispatchQueue.GetSize(DispatchQueue::RequeueClass) || dispatchQueue.GetSize(DispatchQueue::StragglerClass) || (!draining && dispatchQueue.GetSize(DispatchQueue::EliteClass));
+        size_t genomeQueueSize = (m_dispatchPaused || ((inFlightCapped || draining) && !queuedWork)) ? 0 : GenomeRequestQueueSize();
         if (genomeQueueSize)
         {
             MessageASIO message;
-            GetNextGenomeRequest(&message);
+            // when several clients are waiting and there is time critical work the fastest client gets it, otherwise clients
+            // holding fewer runs than their prefetch target are served first come first served
+            if (genomeQueueSize > 1 && queuedWork) GetFastestGenomeRequest(&message);
+            else if (genomeQueueSize > 1) GetPrefetchGenomeRequest(&message, runningList, leaseDuration, currentTime);
+            else GetNextGenomeRequest(&message);
             const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(message.content.data());
-            Genome offspring;
-            // if we are still working from the start population, just get the next one
-            if (startPopulationIndex < m_startPopulation.GetPopulationSize())
-            {
-                offspring = *m_startPopulation.GetGenome(startPopulationIndex);
-                startPopulationIndex++;
-            }
-            else
-            {
-                // it is unlikely but possible to get here before any of the genomes in start population have returned
-                if (m_evolvePopulation.GetPopulationSize() > 0) offspring = m_evolvePopulation.GetOffspring();
-                else offspring = m_startPopulation.GetOffspring();
-            }
-            // got a genome to send
-            std::vector<char> dataMessage(sizeof(DataMessage) + offspring.GetGenomeLength() * sizeof(double));
-            DataMessage *dataMessagePtr = reinterpret_cast<DataMessage *>(dataMessage.data());
-            strncpy(dataMessagePtr->text, "genome", sizeof(dataMessagePtr->text));
-//            server.GetMyAddress(&dataMessagePtr->senderIP, &dataMessagePtr->senderPort);
-            dataMessagePtr->evolveIdentifier = m_evolveIdentifier;
-            dataMessagePtr->runID = submitCount;
-            dataMessagePtr->genomeLength = uint32_t(offspring.GetGenomeLength());
-            dataMessagePtr->xmlLength = uint32_t(m_baseXMLFile.GetSize());
-            std::copy(std::begin(m_md5), std::end(m_md5), std::begin(dataMessagePtr->md5));
-            std::copy_n(offspring.GetGenes()->data(), offspring.GetGenomeLength(), dataMessagePtr->payload.genome);
+            m_hostStatistics.AddRequest(HostStatistics::HostKey(messageContent->senderIP, messageContent->senderPort), currentTime);
+            std::string address = ConvertAddressPortToString(messageContent->senderIP, uint16_t(messageContent->senderPort));
             auto sharedPtr = message.session.lock();
-            if (sharedPtr)
+            if (!sharedPtr)
             {
-                sharedPtr->write(dataMessage.data(), dataMessage.size());
-                std::unique_ptr<RunSpecifier> runSpecifier = std::make_unique<RunSpecifier>();
-                runSpecifier->genome = std::move(offspring);
-                runSpecifier->startTime = currentTime;
-                runSpecifier->senderPort = messageContent->senderPort;
-                runSpecifier->senderIP = messageContent->senderIP;
-                runningList[submitCount] = std::move(runSpecifier);
-                std::string address = ConvertAddressPortToString(messageContent->senderIP, uint16_t(messageContent->senderPort));
-                ReportProgress(ToString("Sample %" PRIu32 " [%zu bytes] sent to %s evolveIdentifier %" PRIu64, submitCount, dataMessage.size(), address.c_str(), m_evolveIdentifier), 2);
-                submitCount++;
+                ReportProgress(ToString("Sample %" PRIu64 " evolveIdentifier %" PRIu64 " unable to lock pointer", submitCount, m_evolveIdentifier.load()), 1);
+                continue;
             }
-            else
+
+            // stale entries in the queued classes are skipped so this loops until something is sent or nothing is available
+            bool sent = false;
+            DispatchQueue::PriorityClass priorityClass;
+            while (!sent && (priorityClass = dispatchQueue.Select(currentTime, availableMask)) != DispatchQueue::NumberOfClasses)
             {
-                ReportProgress(ToString("Sample %" PRIu32 " evolveIdentifier %" PRIu64 " unable to lock pointer", submitCount, m_evolveIdentifier), 1);
+                if (priorityClass == DispatchQueue::StragglerClass)
+                {
+                    // only one duplicate is ever sent and never back to the original host
+                    uint64_t runID;
+                    double enqueueTime;
+                    dispatchQueue.Pop(priorityClass, &runID, &enqueueTime);
+                    RunningList::RunSpecifier *straggler = runningList.Find(runID);
+                    if (!straggler || straggler->duplicateTime != 0 || straggler->awaitingDispatch) continue;
+                    if (straggler->sessionID == message.sessionID || (straggler->senderIP == messageContent->senderIP && straggler->senderPort == messageContent->senderPort))
+                    {
+                        dispatchQueue.PushFront(priorityClass, runID, enqueueTime);
+                        availableMask &= ~DispatchQueue::ClassBit(priorityClass);
+                        continue;
+                    }
+                    BuildDataMessage(*straggler->genome, straggler->runID, &dataMessage);
+                    sharedPtr->write(dataMessage.data(), dataMessage.size());
+                    straggler->duplicateTime = currentTime;
+                    straggler->duplicateIP = messageContent->senderIP;
+                    straggler->duplicatePort = messageContent->senderPort;
+                    runningList.SetDuplicateSessionID(straggler, message.sessionID);
+                    straggler->leaseExpiry = std::max(straggler->leaseExpiry, currentTime + leaseDuration);
+                    duplicateCount++;
+                    ReportProgress(ToString("Sample %" PRIu64 " duplicate sent to %s after %g s", straggler->runID, address.c_str(), currentTime - straggler->startTime), 2);
+                }
+                else if (DispatchQueue::IsQueued(priorityClass))
+                {
+                    // requeued runs and elite re-evaluations are already in the running list waiting to be sent
+                    uint64_t runID;
+                    double enqueueTime;
+                    dispatchQueue.Pop(priorityClass, &runID, &enqueueTime);
+                    RunningList::RunSpecifier *waiting = runningList.Find(runID);
+                    if (!waiting || !waiting->awaitingDispatch) continue; // already scored or resumed
+                    BuildDataMessage(*waiting->genome, waiting->runID, &dataMessage);
+                    sharedPtr->write(dataMessage.data(), dataMessage.size());
+                    waiting->awaitingDispatch = false;
+                    runningList.SetSessionID(waiting, message.sessionID);
+                    waiting->senderIP = messageContent->senderIP;
+                    waiting->senderPort = messageContent->senderPort;
+                    waiting->startTime = currentTime;
+                    waiting->leaseExpiry = currentTime + leaseDuration;
+                    timerWheel.Schedule(waiting->runID, LeaseTimer, waiting->leaseExpiry);
+                    if (stragglerAge > 0 && currentTime + stragglerAge < waiting->leaseExpiry) timerWheel.Schedule(waiting->runID, StragglerTimer, currentTime + stragglerAge);
+                    ReportProgress(ToString("Sample %" PRIu64 " %s sent to %s after waiting %g s", waiting->runID, DispatchQueue::ClassName(priorityClass), address.c_str(), currentTime - enqueueTime), 2);
+                }
+                else
+                {
+                    // the offspring is built directly in a pooled genome that is handed over to the running list or the population
+                    // the start population can run out (or not be loaded yet) so the flag says where the genome actually came from
+                    std::unique_ptr<Genome> offspring = runningList.AcquireGenome();
+                    std::array<int32_t, 2> parentRanks;
+                    bool fromStartPopulation = GetNextGenomeToSend(&offspring, priorityClass == DispatchQueue::StartPopulationClass, &parentRanks);
+                    if (m_evaluationCache.IsOpen())
+                    {
+                        // carried over start population genomes that have already been scored against this XML go straight into the population
+                        // but limit the number per request so that a well populated cache cannot stall dispatch
+                        // bred offspring are always sent because an unmutated copy of a parent would hit the parent's score
+                        const int maxCacheHitsPerRequest = 1000;
+                        double cachedScore;
+                        for (int i = 0; i < maxCacheHitsPerRequest && fromStartPopulation && m_evaluationCache.Lookup(m_md5.data(), offspring->GetGenes()->data(), offspring->GetGenomeLength(), &cachedScore); i++)
+                        {
+                            offspring->SetFitness(cachedScore);
+                            m_evolvePopulation.InsertGenome(std::move(offspring), m_populationSize);
+                            populationChanged = true;
+                            m_evaluationCacheHits++;
+                            ReportProgress(ToString("Evaluation cache hit score %g", cachedScore), 2);
+                            offspring = runningList.AcquireGenome();
+                            fromStartPopulation = GetNextGenomeToSend(&offspring, true, &parentRanks);
+                        }
+                    }
+                    if (!fromStartPopulation) priorityClass = DispatchQueue::OffspringClass;
+                    // got a genome to send
+                    BuildDataMessage(*offspring, submitCount, &dataMessage);
+                    sharedPtr->write(dataMessage.data(), dataMessage.size());
+                    RunningList::RunSpecifier *runSpecifier = runningList.Insert(submitCount, std::move(offspring), message.sessionID);
+                    runSpecifier->startTime = currentTime;
+                    runSpecifier->leaseExpiry = currentTime + leaseDuration;
+                    timerWheel.Schedule(submitCount, LeaseTimer, runSpecifier->leaseExpiry);
+                    if (stragglerAge > 0 && currentTime + stragglerAge < runSpecifier->leaseExpiry) timerWheel.Schedule(submitCount, StragglerTimer, currentTime + stragglerAge);
+                    runSpecifier->senderPort = messageContent->senderPort;
+                    runSpecifier->senderIP = messageContent->senderIP;
+                    runSpecifier->fromStartPopulation = fromStartPopulation;
+                    runSpecifier->parentRanks = parentRanks;
+                    ReportProgress(ToString("Sample %" PRIu64 " [%zu bytes] sent to %s evolveIdentifier %" PRIu64, submitCount, dataMessage.size(), address.c_str(), m_evolveIdentifier.load()), 2);
+                    submitCount++;
+                }
+                dispatchQueue.MarkServed(priorityClass, currentTime);
+                sent = true;
             }
-            continue;
+            if (sent) continue;
+            // nothing can be sent because of the in flight cap or the drain so the client waits until a score comes back
+            ReturnGenomeRequest(std::move(message));
+            genomeQueueSize = 0;
         }
 
         size_t scoreQueueSize = ScoreQueueSize();
         if (scoreQueueSize)
         {
-            MessageASIO message;
-            GetNextScore(&message);
-            const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(message.content.data());
+            RequestMessage score;
+            GetNextScore(&score);
+            const RequestMessage *messageContent = &score;
             if (returnCount % 100 == 0) ReportInfo(ToString("Return Count = %" PRIu32, returnCount));
             uint32_t index = messageContent->runID;
             double result = messageContent->score;
             std::string address = ConvertAddressPortToString(messageContent->senderIP, messageContent->senderPort);
-            ReportProgress(ToString("Sample %" PRIu32 " score %g from %s evolveIdentifier %" PRIu64, index, result, address.c_str(), messageContent->evolveIdentifier), 2);
-            auto iter = runningList.find(index);
-            if (messageContent->evolveIdentifier != m_evolveIdentifier)
+            if (messageContent->evolveIdentifier != m_evolveIdentifier) // checked again in case the evolution changed after the score was ingested
             {
                 ReportProgress(ToString("Sample %" PRIu32 " evolveIdentier mismatch: score %g from %s evolveIdentifier %" PRIu64, index, result, address.c_str(), messageContent->evolveIdentifier), 1);
                 continue;
             }
-            if (iter == runningList.end())
+            RunningList::RunSpecifier *runSpecifier = runningList.FindWireRunID(index);
+            if (!runSpecifier)
             {
+                auto completed = std::find_if(completedDuplicates.begin(), completedDuplicates.end(), [index](const CompletedDuplicate &item) { return item.runID == index; });
+                if (completed != completedDuplicates.end())
+                {
+                    lateDuplicateScores++;
+                    if (completed->duplicateWon) duplicateTimeSaved += currentTime - completed->returnTime;
+                    ReportProgress(ToString("Sample %" PRIu32 " late %s discarded: score %g from %s %g s after the first", index, completed->duplicateWon ? "original" : "duplicate",
+                                            result, address.c_str(), currentTime - completed->returnTime), 2);
+                    completedDuplicates.erase(completed);
+                    continue;
+                }
                 ReportProgress(ToString("Sample %" PRIu32 " not found: score %g from %s evolveIdentifier %" PRIu64, index, result, address.c_str(), messageContent->evolveIdentifier), 1);
                 continue;
             }
-            iter->second->genome.SetFitness(result);
-            // std::cerr << iter->second->genome;
-            m_evolvePopulation.InsertGenome(std::make_unique<Genome>(std::move(iter->second->genome)), m_preferences.populationSize);
-            runningList.erase(iter);
+            if (runSpecifier->duplicateTime != 0)
+            {
+                bool duplicateWon = messageContent->senderIP == runSpecifier->duplicateIP && messageContent->senderPort == runSpecifier->duplicatePort;
+                if (duplicateWon) duplicateWins++;
+                latencyTracker.AddSample(currentTime - (duplicateWon ? runSpecifier->duplicateTime : runSpecifier->startTime));
+                m_hostStatistics.AddReturn(HostStatistics::HostKey(messageContent->senderIP, messageContent->senderPort), currentTime - (duplicateWon ? runSpecifier->duplicateTime : runSpecifier->startTime), currentTime);
+                completedDuplicates.push_back({index, currentTime, duplicateWon});
+                if (completedDuplicates.size() > maxCompletedDuplicates) completedDuplicates.pop_front();
+            }
+            else
+            {
+                latencyTracker.AddSample(currentTime - runSpecifier->startTime);
+                m_hostStatistics.AddReturn(HostStatistics::HostKey(messageContent->senderIP, messageContent->senderPort), currentTime - runSpecifier->startTime, currentTime);
+            }
+            if (m_evaluationJournal.IsOpen())
+            {
+                bool duplicateWon = runSpecifier->duplicateTime != 0 && messageContent->senderIP == runSpecifier->duplicateIP && messageContent->senderPort == runSpecifier->duplicatePort;
+                EvaluationJournal::Record record = {};
+                record.runID = runSpecifier->runID;
+                record.score = result;
+                record.dispatchTime = (duplicateWon ? runSpecifier->duplicateTime : runSpecifier->startTime) + wallClockOffset;
+                record.returnTime = currentTime + wallClockOffset;
+                record.senderIP = messageContent->senderIP;
+                record.senderPort = messageContent->senderPort;
+                record.parentRanks[0] = runSpecifier->parentRanks[0];
+                record.parentRanks[1] = runSpecifier->parentRanks[1];
+                record.genomeLength = uint32_t(runSpecifier->genome->GetGenomeLength());
+                record.flags = (runSpecifier->reevaluation ? EvaluationJournal::Reevaluation : 0) | (runSpecifier->fromStartPopulation ? EvaluationJournal::FromStartPopulation : 0) |
+                               (duplicateWon ? EvaluationJournal::DuplicateWon : 0);
+                m_evaluationJournal.Append(record, runSpecifier->genome->GetGenes()->data(), currentTime);
+            }
+            bool reevaluation = runSpecifier->reevaluation;
+            std::unique_ptr<Genome> genome = runningList.Take(runSpecifier->runID);
+            genome->SetFitness(result);
+            if (reevaluation)
+            {
+                // the elite is replaced by a copy whose fitness is a running average of its evaluations
+                // if it has already left the population the new score is used as it is
+                std::shared_ptr<const Genome> previous = m_evolvePopulation.RemoveGenome(*genome->GetGenes());
+                if (previous) genome->SetFitness(0.5 * (previous->GetFitness() + result));
+                ReportProgress(ToString("Sample %" PRIu32 " elite re-evaluation score %g fitness now %g", index, result, genome->GetFitness()), 2);
+                eliteReevaluations++;
+            }
+            if (m_evaluationCache.IsOpen()) m_evaluationCache.Insert(m_md5.data(), genome->GetGenes()->data(), genome->GetGenomeLength(), result); // the raw score and not the re-evaluation average
+            // std::cerr << *genome;
+            m_evolvePopulation.InsertGenome(std::move(genome), m_populationSize);
+            populationChanged = true;
 
             if (returnCount % uint32_t(m_preferences.outputStatsEvery) == uint32_t(m_preferences.outputStatsEvery) - 1)
             {
                 CalculateTenPercentiles(&m_evolvePopulation, &tenPercentiles);
-                m_outputLogFile << std::setw(10) << returnCount << " ";
-                m_outputLogFile << tenPercentiles << "\n";
-                m_outputLogFile.flush();
+                std::ostringstream statistics;
+                statistics << std::setw(10) << returnCount << " ";
+                statistics << tenPercentiles << "\n";
+                AppendToLog(statistics.str());
             }
 
             if (returnCount % uint32_t(m_preferences.saveBestEvery) == uint32_t(m_preferences.saveBestEvery) - 1 || returnCount == 1)
@@ -483,52 +1266,76 @@ int GAMain::Evolve()
                 {
                     bestFitness = m_evolvePopulation.GetLastGenome()->GetFitness();
                     filename = pystring::os::path::join(m_outputFolderName, ToString(m_bestGenomeModel.c_str(), returnCount));
-                    try
-                    {
-                        ReportProgress("Writing "s + filename, 1);
-                        std::ofstream bestFile;
-                        bestFile.exceptions (std::ios::failbit|std::ios::badbit);
-                        bestFile.open(filename);
-                        bestFile << *m_evolvePopulation.GetLastGenome();
-                        bestFile.close();
-                    }
-                    catch (std::exception& e)
-                    {
-                        ReportProgress("Error writing "s + filename, 0);
-                        ReportProgress(e.what(), 0);
-                    }
-                    catch (...)
-                    {
-                        ReportProgress("Error writing "s + filename, 0);
-                    }
+                    SaveBestGenome(filename, false);
                     ReportInfo(ToString("Best Score = %g", bestFitness));
                 }
             }
 
             if (returnCount % uint32_t(m_preferences.savePopEvery) == uint32_t(m_preferences.savePopEvery) - 1 || returnCount == 0)
             {
-                filename = pystring::os::path::join(m_outputFolderName, ToString(m_bestPopulationModel.c_str(), returnCount));
-                ReportProgress("Writing "s + filename, 1);
-                int err = m_evolvePopulation.WritePopulation(filename.c_str(), m_preferences.outputPopulationSize);
-                if (err) { ReportProgress("Error writing "s + filename, 0); }
+                filename = GetPopulationFileName(returnCount);
+                SavePopulation(filename, false);
             }
 
             if (returnCount % uint32_t(m_preferences.improvementReproductions) == uint32_t(m_preferences.improvementReproductions) - 1)
             {
                 ReportProgress(ToString("Fitness change for %d reproductions is %g", m_preferences.improvementReproductions, std::abs(bestFitness - lastBestFitness)), 2);
-                if (std::abs(bestFitness - lastBestFitness) < m_preferences.improvementThreshold ) stopSendingFlag = true; // it will now quit
+                if (std::abs(bestFitness - lastBestFitness) < m_preferences.improvementThreshold ) stopSendingFlag = true; // it will now drain and quit
                 lastBestFitness = bestFitness;
             }
 
+            if (!draining && m_preferences.eliteReevaluationEvery > 0 && returnCount % uint32_t(m_preferences.eliteReevaluationEvery) == uint32_t(m_preferences.eliteReevaluationEvery) - 1 &&
+                dispatchQueue.GetSize(DispatchQueue::EliteClass) == 0)
+            {
+                // the best genomes are queued for re-evaluation so that a lucky score on a noisy objective does not dominate selection
+                // the copies name the originals as their parents so that a population delta can store them without their genes
+                std::vector<std::shared_ptr<const Genome>> elites = m_evolvePopulation.GetSnapshot(size_t(std::max(m_preferences.eliteReevaluationCount, 0)));
+                for (size_t i = 0; i < elites.size(); i++)
+                {
+                    std::unique_ptr<Genome> elite = runningList.AcquireGenome();
+                    *elite = *elites[i];
+                    elite->SetParents(elites[i]);
+                    RunningList::RunSpecifier *eliteSpecifier = runningList.Insert(submitCount, std::move(elite));
+                    eliteSpecifier->awaitingDispatch = true;
+                    eliteSpecifier->reevaluation = true;
+                    dispatchQueue.Push(DispatchQueue::EliteClass, submitCount, currentTime);
+                    submitCount++;
+                }
+            }
+
             returnCount++;
+            if (m_preferences.checkpointEvery > 0 && returnCount % uint32_t(m_preferences.checkpointEvery) == 0) WriteStateCheckpoint(evolveCounters(), runningList);
             continue;
         }
 
         if (!scoreQueueSize && !genomeQueueSize) { std::this_thread::sleep_for(std::chrono::microseconds(m_loopSleepTimeMicroSeconds)); }
     }
 
+    if (m_preferences.checkpointEvery > 0) WriteStateCheckpoint(evolveCounters(), runningList); // so that a stopped run can be continued
     if (returnCount) returnCount--; // reduce return count back to the value for the last actual return
-    ReportProgress(ToString("GA evolveIdentifier = %" PRIu64 " ended returnCount = %" PRIu32 "", m_evolveIdentifier, returnCount), 1);
+    ReportProgress(ToString("GA evolveIdentifier = %" PRIu64 " ended returnCount = %" PRIu32 "", m_evolveIdentifier.load(), returnCount), 1);
+    if (m_evaluationCache.IsOpen())
+    {
+        ReportProgress(ToString("Evaluation cache hits = %" PRIu64 " entries = %" PRIu64 " evictions = %" PRIu64, m_evaluationCacheHits, m_evaluationCache.GetCount(), m_evaluationCache.GetEvictions()), 0);
+        if (m_evaluationCache.Flush()) ReportProgress("Error flushing evaluation cache "s + m_evaluationCacheFile, 0);
+    }
+    ReportProgress(ToString("Leases expired = %" PRIu64 " final lease duration = %g s", expiredLeaseCount, leaseDuration), 1);
+    ReportProgress(ToString("Time critical runs sent to the fastest waiting client = %" PRIu64, m_fastHostSelections), 1);
+    ReportProgress(ToString("Requests served ahead of clients holding their prefetch target = %" PRIu64, m_prefetchDeferrals), 1);
+    ReportProgress(ToString("In flight cap reached = %" PRIu64 " times final population size = %zu", inFlightCapCount, m_populationSize), 1);
+    ReportHostStatistics(std::chrono::duration_cast<std::chrono::duration<double, std::chrono::seconds::period>>(std::chrono::steady_clock::now().time_since_epoch()).count(), leaseDuration, 1);
+    for (int i = 0; i < DispatchQueue::NumberOfClasses; i++)
+    {
+        DispatchQueue::PriorityClass priorityClass = DispatchQueue::PriorityClass(i);
+        ReportProgress(ToString("Dispatched %s = %" PRIu64 " age limit used %" PRIu64, DispatchQueue::ClassName(priorityClass), dispatchQueue.GetServedCount(priorityClass), dispatchQueue.GetAgeLimitCount(priorityClass)), 1);
+    }
+    if (eliteReevaluations) ReportProgress(ToString("Elite re-evaluations = %" PRIu64, eliteReevaluations), 1);
+    if (m_requeueCount || m_resumeCount) ReportProgress(ToString("Runs requeued after disconnection = %" PRIu64 " resumed = %" PRIu64, m_requeueCount, m_resumeCount), 0);
+    if (duplicateCount)
+    {
+        ReportProgress(ToString("Speculative duplicates = %" PRIu64 " (%.2f%% of dispatches) duplicate wins = %" PRIu64 " late scores discarded = %" PRIu64 " time saved = %g s",
+                                duplicateCount, submitCount ? 100.0 * double(duplicateCount) / double(submitCount) : 0.0, duplicateWins, lateDuplicateScores, duplicateTimeSaved), 0);
+    }
 
     if (m_evolvePopulation.GetPopulationSize())
     {
@@ -536,47 +1343,190 @@ int GAMain::Evolve()
             (!m_preferences.minimizeScore && m_evolvePopulation.GetLastGenome()->GetFitness() > bestFitness))
         {
             filename = pystring::os::path::join(m_outputFolderName, ToString(m_bestGenomeModel.c_str(), returnCount));
-            if (!std::filesystem::exists(filename))
-            {
-                try
-                {
-                    ReportProgress("Writing final "s + filename, 1);
-                    std::ofstream bestFile(filename);
-                    bestFile << *m_evolvePopulation.GetLastGenome();
-                }
-                catch (std::exception& e)
-                {
-                    ReportProgress("Error writing "s + filename, 0);
-                    ReportProgress(e.what(), 0);
-                }
-                catch(...)
-                {
-                    ReportProgress("Error writing "s + filename, 0);
-                }
-            }
+            SaveBestGenome(filename, true);
+        }
+
+        filename = GetPopulationFileName(returnCount);
+        SavePopulation(filename, true);
+
+        bool onlyKeepBestGenome = m_preferences.onlyKeepBestGenome && !m_snapshotArchive.IsOpen(); // the archive does its own retention
+        bool onlyKeepBestPopulation = m_preferences.onlyKeepBestPopulation && !m_snapshotArchive.IsOpen();
+        bool binaryPopulations = m_preferences.binaryPopulations;
+        std::function<void ()> job = [this, onlyKeepBestGenome, onlyKeepBestPopulation, binaryPopulations]()
+        {
+            if (onlyKeepBestGenome) OnlyKeepLastMatching(m_bestGenomeRegex);
+            if (onlyKeepBestPopulation) OnlyKeepLastMatching(binaryPopulations ? m_binaryPopulationRegex : m_bestPopulationRegex);
+        };
+        m_persistenceStage.PushLatest(TidyJob, std::move(job));
+    }
+    // everything for this evolution is on disk before the output folder can change
+    m_persistenceStage.Flush();
+    if (m_evaluationJournal.IsOpen())
+    {
+        m_evaluationJournal.Flush();
+        ReportProgress(m_evaluationJournal.GetStatusString(), 1);
+    }
+    ReportProgress(m_persistenceStage.GetStatusString(), 1);
+    ReportProgress(m_reportingStage.GetStatusString(), 1);
+    ReportProgress(m_ingestStage.GetStatusString(), 1);
+    ReportProgress(m_offspringProducer.GetStatusString(), 1);
+
+    StopPopulationLoader();
+    // waiting clients are kept if another evolution may follow on the same server
+    m_userStopped = shouldStop;
+    if (!m_swapPending && !(m_waitForSwap && !m_userStopped)) CloseRequestGenomeQueue();
+    OpenScoreQueue(false);
+    ClearScoreQueue();
+    ClearHeartbeatQueue();
+    ClearClosedSessionQueue();
+    ClearAdminQueue();
+
+    return 0;
+}
+
+// the lease starts at the watchdog limit and once there are enough returns it tracks a high quantile of the evaluation times
+double GAMain::LeaseDuration(LatencyTracker *latencyTracker)
+{
+    if (latencyTracker->GetSampleCount() < size_t(std::max(m_preferences.leaseMinimumSamples, 1))) return m_preferences.watchDogTimerLimit;
+    double duration = m_preferences.leaseMultiplier * latencyTracker->GetQuantile(m_preferences.leaseQuantile);
+    return std::clamp(duration, std::min(m_preferences.leaseMinimum, m_preferences.watchDogTimerLimit), m_preferences.watchDogTimerLimit);
+}
+
+// a heartbeat renews the lease for a run that is still being evaluated
+void GAMain::ProcessHeartbeats(RunningList *runningList, double currentTime)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_heartbeatMutex);
+        if (m_heartbeatQueue.empty()) return;
+        std::swap(m_heartbeatQueue, m_heartbeatProcessQueue);
+    }
+    for (auto &&message : m_heartbeatProcessQueue)
+    {
+        const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(message.content.data());
+        if (messageContent->evolveIdentifier != m_evolveIdentifier) continue;
+        RunningList::RunSpecifier *runSpecifier = runningList->FindWireRunID(messageContent->runID);
+        if (!runSpecifier)
+        {
+            ReportProgress(ToString("Heartbeat for sample %" PRIu32 " not found", messageContent->runID), 2);
+            continue;
+        }
+        runSpecifier->leaseExpiry = std::max(runSpecifier->leaseExpiry, currentTime + m_preferences.heartbeatExtension);
+        if (message.content.compare(0, 8, "resume__") == 0 && (runSpecifier->awaitingDispatch || runSpecifier->sessionID == 0))
+        {
+            // the client has reconnected and is still working on the run so it does not need to be sent again
+            runSpecifier->awaitingDispatch = false;
+            runningList->SetSessionID(runSpecifier, message.sessionID);
+            runSpecifier->senderIP = messageContent->senderIP;
+            runSpecifier->senderPort = messageContent->senderPort;
+            m_resumeCount++;
+            ReportProgress(ToString("Sample %" PRIu32 " resumed by %s", messageContent->runID, ConvertAddressPortToString(messageContent->senderIP, uint16_t(messageContent->senderPort)).c_str()), 2);
         }
+    }
+    m_heartbeatProcessQueue.clear();
+}
+
+// the runs held by a closed session are marked as having no session so that a reconnecting client can resume them
+// and with requeueClosedSessions they go back on the requeue list unless a duplicate is still being evaluated elsewhere
+void GAMain::ProcessClosedSessions(RunningList *runningList, DispatchQueue *dispatchQueue, double currentTime)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_closedSessionMutex);
+        if (m_closedSessionQueue.empty()) return;
+        std::swap(m_closedSessionQueue, m_closedSessionProcessQueue);
+    }
+    m_closedSessionRunIDs.clear();
+    for (auto &&sessionID : m_closedSessionProcessQueue) runningList->CloseSession(sessionID, &m_closedSessionRunIDs);
+    m_closedSessionProcessQueue.clear();
+    if (!m_preferences.requeueClosedSessions) return; // clients that open a connection per request close their session after every dispatch
+    for (auto &&runID : m_closedSessionRunIDs)
+    {
+        RunningList::RunSpecifier *runSpecifier = runningList->Find(runID);
+        if (!runSpecifier || runSpecifier->sessionID || runSpecifier->duplicateSessionID || runSpecifier->awaitingDispatch) continue;
+        runSpecifier->awaitingDispatch = true;
+        runSpecifier->duplicateTime = 0; // allows another duplicate after the run has been sent again
+        dispatchQueue->Push(DispatchQueue::RequeueClass, runID, currentTime);
+        m_requeueCount++;
+        ReportProgress(ToString("Sample %" PRIu64 " requeued because the session closed", runID), 2);
+    }
+}
+
+void GAMain::SetServerPort(int port)
+{
+    m_tcpPort = port;
+}
 
-        filename = pystring::os::path::join(m_outputFolderName, ToString(m_bestPopulationModel.c_str(), returnCount));
-        if (!std::filesystem::exists(filename))
-        {
-            int err = m_evolvePopulation.WritePopulation(filename.c_str(), m_preferences.outputPopulationSize);
-            if (err) { ReportProgress("Error writing "s + filename, 0); }
-        }
+void GAMain::SetEvaluationCache(const std::string &filename, size_t capacity)
+{
+    m_evaluationCacheFile = filename;
+    m_evaluationCacheSize = capacity;
+}
 
-        if (m_preferences.onlyKeepBestGenome) OnlyKeepLastMatching(m_bestGenomeRegex);
-        if (m_preferences.onlyKeepBestPopulation) OnlyKeepLastMatching(m_bestPopulationRegex);
+// records the MD5 of the base XML file used to produce a population file
+int GAMain::WriteMD5Record(const std::string &populationFile, const std::string &md5String)
+{
+    std::string recordFilename = populationFile + m_md5RecordSuffix;
+    std::string temporaryFilename = recordFilename + ".tmp";
+    try
+    {
+        std::ofstream recordFile;
+        recordFile.exceptions(std::ios::failbit|std::ios::badbit);
+        recordFile.open(temporaryFilename);
+        recordFile << md5String << "\n";
+        recordFile.close();
+        std::filesystem::rename(temporaryFilename, recordFilename);
     }
+    catch (...)
+    {
+        std::remove(temporaryFilename.c_str());
+        return __LINE__;
+    }
+    return 0;
+}
 
-    m_requestGenomeQueueEnabled = false;
-    ClearGenomeRequestQueue();
-    ClearScoreQueue();
-
+int GAMain::ReadMD5Record(const std::string &populationFile, std::string *md5String)
+{
+    std::ifstream recordFile(populationFile + m_md5RecordSuffix);
+    if (!recordFile.good()) return __LINE__;
+    recordFile >> *md5String;
+    if (md5String->size() != 32) return __LINE__;
     return 0;
 }
 
-void GAMain::SetServerPort(int port)
+// get the next genome to send out - either the next member of the start population or an offspring
+// returns true if the genome came from the start population
+bool GAMain::GetNextGenomeToSend(std::unique_ptr<Genome> *genome, bool fromStartPopulation, std::array<int32_t, 2> *parentRanks)
 {
-    m_tcpPort = port;
+    // if we are still working from the start population, just get the next one
+    if (fromStartPopulation && m_startQueue.size())
+    {
+        **genome = *m_startQueue.front();
+        m_startQueue.pop_front();
+        *parentRanks = {-1, -1};
+        return true;
+    }
+    // offspring bred ahead by the offspring stage are used when there are any and otherwise one is bred here
+    // it is unlikely but possible to get here before any of the genomes in start population have returned
+    if (m_evolvePopulation.GetPopulationSize() > 0)
+    {
+        if (!m_offspringProducer.Take(genome, parentRanks)) m_evolvePopulation.GetOffspring(genome->get(), parentRanks);
+    }
+    else m_startPopulation.GetOffspring(genome->get(), parentRanks);
+    return false;
+}
+
+// fill in the message used to send a genome to a client
+void GAMain::BuildDataMessage(const Genome &genome, uint64_t runID, std::vector<char> *dataMessage)
+{
+    dataMessage->resize(sizeof(DataMessage) + genome.GetGenomeLength() * sizeof(double));
+    DataMessage *dataMessagePtr = reinterpret_cast<DataMessage *>(dataMessage->data());
+    strncpy(dataMessagePtr->text, "genome", sizeof(dataMessagePtr->text));
+//    server.GetMyAddress(&dataMessagePtr->senderIP, &dataMessagePtr->senderPort);
+    dataMessagePtr->evolveIdentifier = m_evolveIdentifier;
+    dataMessagePtr->runID = uint32_t(runID); // only the low 32 bits go over the network
+    dataMessagePtr->genomeLength = uint32_t(genome.GetGenomeLength());
+    dataMessagePtr->xmlLength = uint32_t(m_baseXMLFile.GetSize());
+    std::copy(std::begin(m_md5), std::end(m_md5), std::begin(dataMessagePtr->md5));
+    std::copy_n(genome.GetGenes()->data(), genome.GetGenomeLength(), dataMessagePtr->payload.genome);
 }
 
 std::string GAMain::ConvertAddressPortToString(uint32_t address, uint16_t port)
@@ -656,15 +1606,26 @@ void GAMain::ReportProgress(const std::string &message, int logLevel)
 #endif
         std::string timeString = ToString("%04d-%02d-%02d %02d.%02d.%02d ", local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec);
 #endif
-        std::cout << timeString << message << "\n";
-        std::cout.flush();
+        // the console can be slow so the output is done by the reporting stage when it is running
+        std::function<void ()> job = [line = timeString + m_reportPrefix + message]()
+        {
+            std::unique_lock<std::mutex> lock(s_reportMutex);
+            std::cout << line << "\n";
+            std::cout.flush();
+        };
+        if (!m_reportingStage.Push(std::move(job))) job();
     }
 }
 
 void GAMain::ReportInfo(const std::string &message)
 {
-    std::cerr << message << "\n";
-    std::cerr.flush();
+    std::function<void ()> job = [line = m_reportPrefix + message]()
+    {
+        std::unique_lock<std::mutex> lock(s_reportMutex);
+        std::cerr << line << "\n";
+        std::cerr.flush();
+    };
+    if (!m_reportingStage.Push(std::move(job))) job();
 }
 
 // convert to string using printf style formatting and variable numbers of arguments
@@ -693,10 +1654,16 @@ std::string GAMain::ToString(const char * const printfFormatString, ...)
 void GAMain::handleRequestGenome(MessageASIO message)
 {
     if (message.content.size() < sizeof(RequestMessage)) return;
-    if (!m_requestGenomeQueueEnabled) return;
     if (auto sharedPtr1 = message.session.lock())
     {
         std::unique_lock<std::mutex> lock(m_requestGenomeMutex);
+        if (!m_requestGenomeQueueEnabled)
+        {
+            // checked under the lock so that a request cannot slip in after the queue has been handed back
+            lock.unlock();
+            if (m_redirectHandler) m_redirectHandler(std::move(message));
+            return;
+        }
         for (auto &&it : m_requestGenomeQueue)
         {
             // check to see whether we already have a genome request from this session
@@ -713,6 +1680,7 @@ void GAMain::handleRequestXML(MessageASIO message)
 {
     if (message.content.size() < sizeof(RequestMessage)) return;
     const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(message.content.data());
+    std::unique_lock<std::mutex> lock(m_baseXMLMutex); // the XML, MD5 and evolveIdentifier change together when the base XML is swapped
     std::vector<char> dataMessage(sizeof(DataMessage) + m_baseXMLFile.GetSize() * sizeof(char));
     DataMessage *dataMessagePtr = reinterpret_cast<DataMessage *>(dataMessage.data());
     strncpy(dataMessagePtr->text, "xml", 16);
@@ -720,7 +1688,7 @@ void GAMain::handleRequestXML(MessageASIO message)
     dataMessagePtr->senderPort = m_port;
     dataMessagePtr->runID = std::numeric_limits<uint32_t>::max();
     dataMessagePtr->evolveIdentifier = m_evolveIdentifier;
-    dataMessagePtr->genomeLength = uint32_t(m_startPopulation.GetFirstGenome()->GetGenomeLength());
+    dataMessagePtr->genomeLength = m_xmlGenomeLength;
     dataMessagePtr->xmlLength = uint32_t(m_baseXMLFile.GetSize());
     std::copy(std::begin(m_md5), std::end(m_md5), std::begin(dataMessagePtr->md5));
     std::copy_n(m_baseXMLFile.GetRawData(), m_baseXMLFile.GetSize(), dataMessagePtr->payload.xml);
@@ -764,6 +1732,7 @@ int GAMain::OnlyKeepLastMatching(const std::string &regexPattern)
         {
             ReportProgress("Removing "s + directoryContents[i], 1);
             std::filesystem::remove(directoryContents[i]);
+            std::filesystem::remove(directoryContents[i] + m_md5RecordSuffix); // does nothing if the record does not exist
         }
         catch (std::exception& e)
         {
@@ -792,8 +1761,534 @@ void GAMain::setArgParse(ArgParse *newArgParse)
 void GAMain::handleScore(MessageASIO message)
 {
     if (message.content.size() < sizeof(RequestMessage)) return;
+    std::function<void ()> job = [this, message = std::move(message)]() { IngestScore(message); };
+    if (!m_ingestStage.Push(std::move(job))) job();
+}
+
+// runs on the ingest stage so that the evolve loop only gets decoded scores for the current evolution
+void GAMain::IngestScore(const MessageASIO &message)
+{
+    RequestMessage score;
+    std::memcpy(&score, message.content.data(), sizeof(score));
+    if (m_logLevel >= 2)
+    {
+        std::string address = ConvertAddressPortToString(score.senderIP, uint16_t(score.senderPort));
+        ReportProgress(ToString("Sample %" PRIu32 " score %g from %s evolveIdentifier %" PRIu64, score.runID, score.score, address.c_str(), score.evolveIdentifier), 2);
+    }
+    if (score.evolveIdentifier != m_evolveIdentifier)
+    {
+        std::string address = ConvertAddressPortToString(score.senderIP, uint16_t(score.senderPort));
+        ReportProgress(ToString("Sample %" PRIu32 " evolveIdentier mismatch: score %g from %s evolveIdentifier %" PRIu64, score.runID, score.score, address.c_str(), score.evolveIdentifier), 1);
+        return;
+    }
     std::unique_lock<std::mutex> lock(m_scoreMutex);
-    m_scoreQueue.push_back(message);
+    // a burst of scores waits here rather than in the evolve loop, and between evolutions nothing is reading so nothing waits
+    m_scoreSpaceAvailable.wait(lock, [this]() { return m_scoreQueue.size() < m_scoreQueueCapacity || !m_scoreQueueOpen; });
+    m_scoreQueue.push_back(score);
+}
+
+void GAMain::handleHeartbeat(MessageASIO message)
+{
+    if (message.content.size() < sizeof(RequestMessage)) return;
+    std::unique_lock<std::mutex> lock(m_heartbeatMutex);
+    m_heartbeatQueue.push_back(message);
+}
+
+void GAMain::handleResume(MessageASIO message)
+{
+    if (message.content.size() < sizeof(RequestMessage)) return;
+    std::unique_lock<std::mutex> lock(m_heartbeatMutex);
+    m_heartbeatQueue.push_back(message);
+}
+
+void GAMain::handleSessionClosed(uint64_t sessionID)
+{
+    std::unique_lock<std::mutex> lock(m_closedSessionMutex);
+    m_closedSessionQueue.push_back(sessionID);
+}
+
+// admin commands are plain text: admin___<token> <command> [value]
+// the token is checked here so that nothing unauthenticated reaches the evolve loop
+void GAMain::handleAdmin(MessageASIO message)
+{
+    std::vector<std::string> tokens;
+    pystring::split(message.content.substr(8), tokens);
+    bool authorised = m_adminToken.size() && tokens.size() >= 2 && tokens[0].size() == m_adminToken.size();
+    if (authorised)
+    {
+        // compare every character so that the time taken does not reveal how much of the token was right
+        unsigned char difference = 0;
+        for (size_t i = 0; i < m_adminToken.size(); i++) difference |= static_cast<unsigned char>(tokens[0][i] ^ m_adminToken[i]);
+        authorised = (difference == 0);
+    }
+    if (!authorised)
+    {
+        ReportProgress(ToString("Admin command refused from session %" PRIu64, message.sessionID), 0);
+        std::string reply = m_reportPrefix + "error not authorised"s;
+        if (auto sharedPtr = message.session.lock()) sharedPtr->write(reply.data(), reply.size());
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_adminMutex);
+    m_adminQueue.push_back(std::move(message));
+}
+
+void GAMain::ProcessAdminCommands(const std::function<std::string ()> &statusFunction)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_adminMutex);
+        if (m_adminQueue.empty()) return;
+        std::swap(m_adminQueue, m_adminProcessQueue);
+    }
+    for (auto &&message : m_adminProcessQueue)
+    {
+        std::vector<std::string> tokens;
+        pystring::split(message.content.substr(8), tokens);
+        const std::string &command = tokens[1];
+        std::string reply = "ok"s;
+        char *end = nullptr;
+        double value = tokens.size() > 2 ? std::strtod(tokens[2].c_str(), &end) : 0;
+        bool valueOK = tokens.size() > 2 && *end == '\0';
+        if (command == "status"s)
+        {
+            reply = statusFunction();
+        }
+        else if (command == "pause"s)
+        {
+            m_dispatchPaused = true;
+        }
+        else if (command == "resume"s)
+        {
+            m_dispatchPaused = false;
+        }
+        else if (command == "stop"s)
+        {
+            m_stopRequested = true;
+        }
+        else if (command == "checkpoint"s)
+        {
+            m_checkpointRequested = true;
+        }
+        else if (command == "log"s)
+        {
+            if (valueOK) m_logLevel = int(value);
+            else reply = "error log needs a level"s;
+        }
+        else if (command == "population"s)
+        {
+            if (!valueOK || value <= m_preferences.parentsToKeep) reply = "error population needs a size greater than parentsToKeep"s;
+            else SetPopulationSize(size_t(value));
+        }
+        else if (command == "reload"s)
+        {
+            ReloadPreferences(&reply);
+        }
+        else if (command == "swap"s)
+        {
+            RequestSwap(std::vector<std::string>(tokens.begin() + 2, tokens.end()), &reply);
+        }
+        else if (command == "set"s)
+        {
+            if (tokens.size() > 3) value = std::strtod(tokens[3].c_str(), &end);
+            if (tokens.size() != 4) reply = "error set needs a name and a value"s;
+            else if (*end != '\0' || value < 0 || value > 1) reply = "error chance must be between 0 and 1"s;
+            else if (tokens[2] == "gaussianMutationChance"s) { m_preferences.gaussianMutationChance = value; m_startPopulation.SetGaussianMutationChance(value); m_evolvePopulation.SetGaussianMutationChance(value); }
+            else if (tokens[2] == "frameShiftMutationChance"s) { m_preferences.frameShiftMutationChance = value; m_startPopulation.SetFrameShiftMutationChance(value); m_evolvePopulation.SetFrameShiftMutationChance(value); }
+            else if (tokens[2] == "duplicationMutationChance"s) { m_preferences.duplicationMutationChance = value; m_startPopulation.SetDuplicationMutationChance(value); m_evolvePopulation.SetDuplicationMutationChance(value); }
+            else if (tokens[2] == "crossoverChance"s) { m_preferences.crossoverChance = value; m_startPopulation.SetCrossoverChance(value); m_evolvePopulation.SetCrossoverChance(value); }
+            else reply = "error unknown setting "s + tokens[2];
+        }
+        else
+        {
+            reply = "error unknown command "s + command;
+        }
+        std::string commandText = pystring::join(" "s, std::vector<std::string>(tokens.begin() + 1, tokens.end()));
+        ReportProgress(ToString("Admin command \"%s\" from session %" PRIu64 ": %s", commandText.c_str(), message.sessionID, reply.c_str()), 0);
+        reply = m_reportPrefix + reply;
+        if (auto sharedPtr = message.session.lock()) sharedPtr->write(reply.data(), reply.size());
+    }
+    m_adminProcessQueue.clear();
+}
+
+void GAMain::SetPopulationSize(size_t populationSize)
+{
+    m_preferences.populationSize = int(populationSize);
+    if (m_preferences.elasticPopulation)
+    {
+        // with an elastic population this is the minimum size
+        UpdateElasticPopulation();
+        return;
+    }
+    if (m_evolvePopulation.GetPopulationSize() > populationSize) m_evolvePopulation.ResizePopulation(populationSize);
+    m_populationSize = populationSize;
+    m_genomePool->ReserveBlocks(3 * m_populationSize);
+}
+
+// the new parameter file is applied completely or not at all
+int GAMain::ReloadPreferences(std::string *result, bool reportFailure)
+{
+    Preferences preferences;
+    if (preferences.ReadPreferences(m_parameterFile))
+    {
+        *result = "error reading "s + m_parameterFile + " so nothing was changed"s;
+        if (reportFailure) ReportProgress("Parameter file not reloaded: "s + *result, 0);
+        return __LINE__;
+    }
+    preferences.startingPopulation = m_preferences.startingPopulation; // only used at start up and may have been set on the command line
+
+    // find what has changed by comparing the name value lines
+    auto toMap = [](const std::string &text)
+    {
+        std::map<std::string, std::string> values;
+        std::vector<std::string> lines;
+        pystring::splitlines(text, lines);
+        for (auto &&line : lines)
+        {
+            std::vector<std::string> tokens;
+            pystring::split(line, tokens, " "s, 1);
+            if (tokens.size() == 2) values[tokens[0]] = tokens[1];
+        }
+        return values;
+    };
+    std::map<std::string, std::string> oldValues = toMap(m_preferences.GetPreferencesString());
+    std::map<std::string, std::string> newValues = toMap(preferences.GetPreferencesString());
+    std::vector<std::string> changed;
+    for (auto &&newValue : newValues)
+    {
+        auto oldValue = oldValues.find(newValue.first);
+        if (oldValue == oldValues.end() || oldValue->second != newValue.second) changed.push_back(newValue.first);
+    }
+
+    // these would invalidate the genomes that are already in the population or in flight
+    const std::vector<std::string> fixedSettings = {"genomeLength"s, "minimizeScore"s, "randomiseModel"s};
+    std::vector<std::string> rejected;
+    for (auto &&name : changed) { if (std::find(fixedSettings.begin(), fixedSettings.end(), name) != fixedSettings.end()) rejected.push_back(name); }
+    if (rejected.size())
+    {
+        *result = "error "s + pystring::join(" "s, rejected) + " cannot be changed during a run so nothing was changed"s;
+        if (reportFailure) ReportProgress("Parameter file not reloaded: "s + *result, 0);
+        return __LINE__;
+    }
+    if (preferences.parentsToKeep >= preferences.populationSize)
+    {
+        *result = "error parentsToKeep must be lower than populationSize so nothing was changed"s;
+        if (reportFailure) ReportProgress("Parameter file not reloaded: "s + *result, 0);
+        return __LINE__;
+    }
+    if (changed.empty())
+    {
+        *result = "ok nothing changed"s;
+        return 0;
+    }
+
+    for (auto population : {&m_startPopulation, &m_evolvePopulation})
+    {
+        population->SetGlobalCircularMutation(preferences.circularMutation);
+        population->SetResizeControl(preferences.resizeControl);
+        population->SetSelectionType(preferences.parentSelection);
+        population->SetParentsToKeep(preferences.parentsToKeep);
+        population->SetGamma(preferences.gamma);
+        population->SetCrossoverChance(preferences.crossoverChance);
+        population->SetCrossoverType(preferences.crossoverType);
+        population->SetMultipleGaussian(preferences.multipleGaussian);
+        population->SetGaussianMutationChance(preferences.gaussianMutationChance);
+        population->SetBounceMutation(preferences.bounceMutation);
+        population->SetFrameShiftMutationChance(preferences.frameShiftMutationChance);
+        population->SetDuplicationMutationChance(preferences.duplicationMutationChance);
+    }
+    m_hostStatistics.SetLatencySmoothing(preferences.hostLatencySmoothing);
+    m_hostStatistics.SetThroughputTimeConstant(preferences.hostThroughputTimeConstant);
+    m_dispatchSettingsChanged = true;
+    int populationSize = preferences.populationSize;
+    preferences.populationSize = m_preferences.populationSize;
+    m_preferences = preferences;
+    if (populationSize != m_preferences.populationSize) SetPopulationSize(size_t(populationSize));
+
+    *result = "ok changed "s + pystring::join(" "s, changed);
+    ReportProgress("Parameter file reloaded: "s + pystring::join(" "s, changed), 0);
+    AppendToLog("Parameter file reloaded\n"s + m_preferences.GetPreferencesString() + "\n"s);
+    return 0;
+}
+
+void GAMain::WriteCheckpoint(uint32_t returnCount)
+{
+    if (m_evolvePopulation.GetPopulationSize() == 0) return;
+    SaveBestGenome(pystring::os::path::join(m_outputFolderName, ToString(m_bestGenomeModel.c_str(), returnCount)), false);
+    SavePopulation(GetPopulationFileName(returnCount), false);
+}
+
+// the state is copied into the checkpoint buffer here and the persistence stage writes it out while dispatch carries on
+// the start queue is stored as indices into the start population and the running list as its runIDs and genomes
+void GAMain::WriteStateCheckpoint(const EvolveCounters &counters, const RunningList &runningList)
+{
+    if (!m_startPopulationLoaded)
+    {
+        ReportProgress("Checkpoint skipped because the starting population is still being read"s, 1);
+        return;
+    }
+    Checkpoint checkpoint;
+    checkpoint.Write(uint32_t(1)); // state version
+    for (auto &&value : m_md5) checkpoint.Write(value);
+    checkpoint.Write(uint32_t(m_preferences.genomeLength));
+    checkpoint.Write(m_evolveIdentifier.load());
+    checkpoint.Write(counters.submitCount);
+    checkpoint.Write(counters.returnCount);
+    checkpoint.Write(counters.bestFitness);
+    checkpoint.Write(counters.lastBestFitness);
+    checkpoint.Write(counters.stopSendingFlag);
+    checkpoint.Write(counters.eliteReevaluations);
+    checkpoint.Write(uint64_t(counters.populationSize));
+    checkpoint.WriteString(m_preferences.startingPopulation);
+
+    m_startPopulation.WriteCheckpoint(&checkpoint);
+    std::unordered_map<const Genome *, uint64_t> startIndices;
+    for (size_t i = 0; i < m_startPopulation.GetPopulationSize(); i++) startIndices[m_startPopulation.GetGenome(i)] = i;
+    std::vector<uint64_t> startQueue;
+    startQueue.reserve(m_startQueue.size());
+    for (auto &&genome : m_startQueue) startQueue.push_back(startIndices[genome]);
+    checkpoint.WriteVector(startQueue);
+    m_evolvePopulation.WriteCheckpoint(&checkpoint);
+
+    checkpoint.Write(uint64_t(runningList.GetSize()));
+    runningList.ForEach([&checkpoint](const RunningList::RunSpecifier &runSpecifier)
+    {
+        checkpoint.Write(runSpecifier.runID);
+        checkpoint.Write(runSpecifier.reevaluation);
+        runSpecifier.genome->WriteCheckpoint(&checkpoint);
+    });
+
+    std::string filename = pystring::os::path::join(m_outputFolderName, m_stateCheckpointName);
+    uint32_t returnCount = counters.returnCount;
+    std::function<void ()> job = [this, filename, returnCount, checkpoint = std::move(checkpoint)]()
+    {
+        if (checkpoint.WriteFile(filename)) ReportProgress("Error writing "s + filename, 0);
+        else ReportProgress(ToString("Checkpoint at returnCount = %" PRIu32 " written to %s (%zu bytes)", returnCount, filename.c_str(), checkpoint.GetSize()), 1);
+    };
+    if (!m_persistenceStage.PushLatest(CheckpointJob, std::move(job))) ReportProgress(ToString("Checkpoint at returnCount = %" PRIu32 " dropped", returnCount), 0);
+}
+
+// everything is checked before anything is changed so that a bad checkpoint stops the run before it starts
+// the populations are restored here and the counters and runs are picked up by the next Evolve
+int GAMain::ReadStateCheckpoint(const std::string &filename)
+{
+    Checkpoint checkpoint;
+    if (checkpoint.ReadFile(filename))
+    {
+        ReportProgress("Error reading checkpoint "s + filename, 0);
+        return __LINE__;
+    }
+    uint32_t stateVersion = 0;
+    std::vector<uint32_t> md5(m_md5.size(), 0);
+    uint32_t genomeLength = 0;
+    uint64_t evolveIdentifier = 0;
+    uint64_t populationSize = 0;
+    EvolveCounters counters;
+    std::string startingPopulation;
+    checkpoint.Read(&stateVersion);
+    for (auto &&value : md5) checkpoint.Read(&value);
+    checkpoint.Read(&genomeLength);
+    checkpoint.Read(&evolveIdentifier);
+    checkpoint.Read(&counters.submitCount);
+    checkpoint.Read(&counters.returnCount);
+    checkpoint.Read(&counters.bestFitness);
+    checkpoint.Read(&counters.lastBestFitness);
+    checkpoint.Read(&counters.stopSendingFlag);
+    checkpoint.Read(&counters.eliteReevaluations);
+    checkpoint.Read(&populationSize);
+    checkpoint.ReadString(&startingPopulation);
+    counters.populationSize = size_t(populationSize);
+    if (checkpoint.GetReadError() || stateVersion != 1)
+    {
+        ReportProgress("Error: checkpoint "s + filename + " is not a supported version"s, 0);
+        return __LINE__;
+    }
+    if (md5 != m_md5)
+    {
+        ReportProgress("Error: checkpoint "s + filename + " was written with a different base XML file"s, 0);
+        return __LINE__;
+    }
+    if (genomeLength != uint32_t(m_preferences.genomeLength))
+    {
+        ReportProgress(ToString("Error: checkpoint %s has genome length %" PRIu32 " but genomeLength is %d", filename.c_str(), genomeLength, m_preferences.genomeLength), 0);
+        return __LINE__;
+    }
+
+    StopPopulationLoader();
+    m_startQueue.clear();
+    ConfigurePopulations();
+    std::vector<uint64_t> startQueue;
+    uint64_t runCount = 0;
+    std::vector<RunningList::RunSpecifier> runs;
+    int err = m_startPopulation.ReadCheckpoint(&checkpoint);
+    if (!err && !checkpoint.ReadVector(&startQueue)) err = __LINE__;
+    if (!err) err = m_evolvePopulation.ReadCheckpoint(&checkpoint);
+    if (!err && !checkpoint.Read(&runCount)) err = __LINE__;
+    for (uint64_t i = 0; !err && i < runCount; i++)
+    {
+        RunningList::RunSpecifier run;
+        run.genome = std::make_unique<Genome>();
+        checkpoint.Read(&run.runID);
+        checkpoint.Read(&run.reevaluation);
+        err = run.genome->ReadCheckpoint(&checkpoint);
+        runs.push_back(std::move(run));
+    }
+    if (!err && (checkpoint.GetReadError() || !checkpoint.AtEnd())) err = __LINE__;
+    for (auto &&index : startQueue)
+    {
+        if (err || index >= m_startPopulation.GetPopulationSize()) { err = err ? err : __LINE__; break; }
+        m_startQueue.push_back(m_startPopulation.GetGenome(size_t(index)));
+    }
+    if (err)
+    {
+        m_startPopulation.Clear();
+        m_evolvePopulation.Clear();
+        m_startQueue.clear();
+        ReportProgress(ToString("Error: checkpoint %s is inconsistent (%d)", filename.c_str(), err), 0);
+        return __LINE__;
+    }
+
+    // the runs are sent again in the order they were first sent
+    std::sort(runs.begin(), runs.end(), [](const RunningList::RunSpecifier &lhs, const RunningList::RunSpecifier &rhs) { return lhs.runID < rhs.runID; });
+    m_resumeRuns = std::move(runs);
+    m_resumeCounters = counters;
+    m_resuming = true;
+    m_startPopulationLoaded = true;
+    m_populationLoading = false;
+    if (startingPopulation.size()) m_preferences.startingPopulation = startingPopulation;
+    m_evolveIdentifier = evolveIdentifier;
+    uint64_t lastEvolveIdentifier = s_lastEvolveIdentifier.load();
+    while (lastEvolveIdentifier < evolveIdentifier && !s_lastEvolveIdentifier.compare_exchange_weak(lastEvolveIdentifier, evolveIdentifier)) {}
+    ReportProgress(ToString("%s read: returnCount = %" PRIu32 " population %zu start queue %zu runs %zu evolveIdentifier %" PRIu64, filename.c_str(), counters.returnCount,
+                            m_evolvePopulation.GetPopulationSize(), m_startQueue.size(), m_resumeRuns.size(), evolveIdentifier), 0);
+    return 0;
+}
+
+// the persistence stage is given a snapshot that shares the genomes with the population so taking it costs almost nothing
+// and the population can carry on changing while the files are written. Files are written under a temporary name and
+// renamed when complete so that nothing reading the output folder ever sees a partly written file
+void GAMain::SaveBestGenome(const std::string &filename, bool onlyIfMissing)
+{
+    if (m_snapshotArchive.IsOpen())
+    {
+        size_t keep = m_preferences.onlyKeepBestGenome ? 1 : size_t(std::max(m_preferences.snapshotArchiveKeep, 0));
+        SaveToArchive(SnapshotArchive::BestGenome, filename, onlyIfMissing, m_evolvePopulation.GetSnapshot(1), keep);
+        return;
+    }
+    std::function<void ()> job = [this, filename, onlyIfMissing, snapshot = m_evolvePopulation.GetSnapshot(1)]()
+    {
+        if (onlyIfMissing && std::filesystem::exists(filename)) return;
+        std::string temporaryFilename = filename + ".tmp";
+        try
+        {
+            ReportProgress("Writing "s + filename, 1);
+            std::ofstream bestFile;
+            bestFile.exceptions (std::ios::failbit|std::ios::badbit);
+            bestFile.open(temporaryFilename);
+            bestFile << *snapshot.front();
+            bestFile.close();
+            std::filesystem::rename(temporaryFilename, filename);
+        }
+        catch (std::exception& e)
+        {
+            ReportProgress("Error writing "s + filename, 0);
+            ReportProgress(e.what(), 0);
+            std::remove(temporaryFilename.c_str());
+        }
+        catch (...)
+        {
+            ReportProgress("Error writing "s + filename, 0);
+            std::remove(temporaryFilename.c_str());
+        }
+    };
+    if (!m_persistenceStage.PushLatest(BestGenomeJob, std::move(job))) ReportProgress(filename + " dropped"s, 0);
+}
+
+void GAMain::SavePopulation(const std::string &filename, bool onlyIfMissing)
+{
+    size_t count = size_t(std::max(m_preferences.outputPopulationSize, 0));
+    if (m_snapshotArchive.IsOpen())
+    {
+        size_t keep = m_preferences.onlyKeepBestPopulation ? 1 : size_t(std::max(m_preferences.snapshotArchiveKeep, 0));
+        SaveToArchive(SnapshotArchive::Population, filename, onlyIfMissing, m_evolvePopulation.GetSnapshot(count), keep);
+        return;
+    }
+    std::string md5String(hexDigest(m_md5.data()));
+    bool binary = m_preferences.binaryPopulations;
+    size_t keyframeEvery = m_preferences.onlyKeepBestPopulation ? 0 : size_t(std::max(m_preferences.populationKeyframeEvery, 0));
+    std::function<void ()> job = [this, filename, onlyIfMissing, genomes = m_evolvePopulation.GetSnapshot(count), md5String, binary, keyframeEvery]()
+    {
+        if (onlyIfMissing && std::filesystem::exists(filename)) return;
+        // the population written at the end of a run is always complete
+        if (keyframeEvery > 1 && !onlyIfMissing && m_populationDelta.Encode(genomes, keyframeEvery))
+        {
+            std::string root, extension;
+            pystring::os::path::splitext(root, extension, filename);
+            std::string deltaFilename = root + m_populationDeltaExtension;
+            ReportProgress(ToString("Writing %s removed %zu inserted %zu size %zu", deltaFilename.c_str(), m_populationDelta.GetRemovedCount(), m_populationDelta.GetInsertedCount(),
+                                    m_populationDelta.GetEncodedSize()), 1);
+            if (m_populationDelta.WriteDelta(deltaFilename) == 0)
+            {
+                if (WriteMD5Record(deltaFilename, md5String)) ReportProgress("Error writing "s + deltaFilename + m_md5RecordSuffix, 0);
+                return;
+            }
+            ReportProgress("Error writing "s + deltaFilename + " so the population is written in full"s, 0);
+        }
+        ReportProgress("Writing "s + filename, 1);
+        if (binary ? BinaryPopulationFile::Write(filename, genomes) : Population::WriteGenomes(filename.c_str(), genomes)) { ReportProgress("Error writing "s + filename, 0); return; }
+        if (keyframeEvery > 1) m_populationDelta.SetKeyframe(filename, genomes);
+        if (WriteMD5Record(filename, md5String)) { ReportProgress("Error writing "s + filename + m_md5RecordSuffix, 0); }
+    };
+    if (!m_persistenceStage.PushLatest(PopulationJob, std::move(job))) ReportProgress(filename + " dropped"s, 0);
+}
+
+// snapshot archives always hold the text format
+std::string GAMain::GetPopulationFileName(uint32_t returnCount)
+{
+    bool binary = m_preferences.binaryPopulations && !m_snapshotArchive.IsOpen();
+    return pystring::os::path::join(m_outputFolderName, ToString(binary ? m_binaryPopulationModel.c_str() : m_bestPopulationModel.c_str(), returnCount));
+}
+
+// the snapshot is formatted exactly as its own file would have been and stored under that file name
+void GAMain::SaveToArchive(SnapshotArchive::Kind kind, const std::string &filename, bool onlyIfMissing, std::vector<std::shared_ptr<const Genome>> &&snapshot, size_t keep)
+{
+    std::string md5String = kind == SnapshotArchive::Population ? hexDigest(m_md5.data()) : ""s;
+    std::function<void ()> job = [this, kind, filename, onlyIfMissing, snapshot = std::move(snapshot), md5String, keep]()
+    {
+        std::string name = pystring::os::path::basename(filename);
+        if (onlyIfMissing && m_snapshotArchive.Contains(name)) return;
+        std::ostringstream contents;
+        if (kind == SnapshotArchive::Population) contents << snapshot.size() << "\n";
+        for (auto &&genome : snapshot) contents << *genome;
+        ReportProgress("Adding "s + name + " to "s + m_snapshotArchive.GetFilename(), 1);
+        if (m_snapshotArchive.Add(kind, name, md5String, contents.str(), keep)) ReportProgress("Error adding "s + name + " to "s + m_snapshotArchive.GetFilename(), 0);
+    };
+    if (!m_persistenceStage.PushLatest(kind == SnapshotArchive::Population ? PopulationJob : BestGenomeJob, std::move(job))) ReportProgress(filename + " dropped"s, 0);
+}
+
+void GAMain::AppendToLog(const std::string &text)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_pendingLogMutex);
+        m_pendingLog += text;
+    }
+    // every log job writes all the text pending when it runs so a queued one does not need another behind it
+    std::function<void ()> job = [this]()
+    {
+        std::string text;
+        {
+            std::unique_lock<std::mutex> lock(m_pendingLogMutex);
+            text.swap(m_pendingLog);
+        }
+        try
+        {
+            m_outputLogFile << text;
+            m_outputLogFile.flush();
+        }
+        catch (...)
+        {
+            ReportProgress("Error writing log file"s, 0);
+        }
+    };
+    m_persistenceStage.PushLatest(LogJob, std::move(job)); // if this fails the text is written by the next log job
 }
 
 size_t GAMain::GenomeRequestQueueSize()
@@ -815,23 +2310,132 @@ void GAMain::GetNextGenomeRequest(MessageASIO *message)
     m_requestGenomeQueue.pop_front();
 }
 
-void GAMain::GetNextScore(MessageASIO *message)
+void GAMain::GetNextScore(RequestMessage *score)
 {
-    std::unique_lock<std::mutex> lock(m_scoreMutex);
-    *message = m_scoreQueue.front();
-    m_scoreQueue.pop_front();
+    {
+        std::unique_lock<std::mutex> lock(m_scoreMutex);
+        *score = m_scoreQueue.front();
+        m_scoreQueue.pop_front();
+    }
+    m_scoreSpaceAvailable.notify_one();
+}
+
+void GAMain::OpenScoreQueue(bool open)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_scoreMutex);
+        m_scoreQueueOpen = open;
+    }
+    m_scoreSpaceAvailable.notify_all();
+}
+
+// picks the waiting request from the client with the lowest latency estimate
+// clients without an estimate are assumed to be average
+void GAMain::GetFastestGenomeRequest(MessageASIO *message)
+{
+    double meanLatency = m_hostStatistics.GetMeanLatency();
+    std::unique_lock<std::mutex> lock(m_requestGenomeMutex);
+    auto fastest = m_requestGenomeQueue.begin();
+    double fastestLatency = std::numeric_limits<double>::max();
+    for (auto it = m_requestGenomeQueue.begin(); it != m_requestGenomeQueue.end(); it++)
+    {
+        const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(it->content.data());
+        double latency;
+        if (!m_hostStatistics.GetLatency(HostStatistics::HostKey(messageContent->senderIP, messageContent->senderPort), &latency)) latency = meanLatency;
+        if (latency < fastestLatency)
+        {
+            fastestLatency = latency;
+            fastest = it;
+        }
+    }
+    if (fastest != m_requestGenomeQueue.begin()) m_fastHostSelections++;
+    *message = std::move(*fastest);
+    m_requestGenomeQueue.erase(fastest);
+}
+
+// picks the oldest waiting request from a client that holds fewer runs than it can be expected to return within a lease
+// so a client that asks for more work before returning its earlier runs does not hold up the others
+// if every waiting client is at its target the oldest request is served anyway
+void GAMain::GetPrefetchGenomeRequest(MessageASIO *message, const RunningList &runningList, double leaseDuration, double currentTime)
+{
+    std::unique_lock<std::mutex> lock(m_requestGenomeMutex);
+    auto selected = m_requestGenomeQueue.begin();
+    for (auto it = m_requestGenomeQueue.begin(); it != m_requestGenomeQueue.end(); it++)
+    {
+        const RequestMessage *messageContent = reinterpret_cast<const RequestMessage *>(it->content.data());
+        size_t prefetchTarget = m_hostStatistics.GetPrefetchTarget(HostStatistics::HostKey(messageContent->senderIP, messageContent->senderPort), leaseDuration, currentTime);
+        if (runningList.GetSessionRunCount(it->sessionID) < prefetchTarget)
+        {
+            selected = it;
+            break;
+        }
+    }
+    if (selected != m_requestGenomeQueue.begin()) m_prefetchDeferrals++;
+    *message = std::move(*selected);
+    m_requestGenomeQueue.erase(selected);
 }
 
-void GAMain::ClearGenomeRequestQueue()
+// puts a request back at the front of the queue unless the client has already sent another
+void GAMain::ReturnGenomeRequest(MessageASIO &&message)
 {
     std::unique_lock<std::mutex> lock(m_requestGenomeMutex);
-    m_requestGenomeQueue.clear();
+    for (auto &&it : m_requestGenomeQueue) { if (it.sessionID == message.sessionID) return; }
+    m_requestGenomeQueue.push_front(std::move(message));
+}
+
+// the population size follows the number of connected clients so that the number of evaluations in flight
+// stays a reasonable fraction of the population and selection pressure is maintained
+void GAMain::UpdateElasticPopulation()
+{
+    size_t minimumSize = size_t(m_preferences.populationSize);
+    size_t maximumSize = m_preferences.elasticPopulationMaximum > 0 ? size_t(m_preferences.elasticPopulationMaximum) : 10 * minimumSize;
+    size_t targetSize = size_t(std::ceil(m_preferences.elasticPopulationPerClient * double(m_activeClients)));
+    targetSize = std::clamp(targetSize, minimumSize, std::max(minimumSize, maximumSize));
+    // ignore small changes so that clients coming and going do not cause constant resizing
+    if (std::abs(double(targetSize) - double(m_populationSize)) <= 0.1 * double(m_populationSize)) return;
+    ReportProgress(ToString("Population size changed from %zu to %zu for %zu active clients", m_populationSize, targetSize, m_activeClients), 1);
+    // growing only raises the target so that the new places are filled by evaluated offspring as their scores come back
+    if (m_evolvePopulation.GetPopulationSize() > targetSize) m_evolvePopulation.ResizePopulation(targetSize);
+    m_populationSize = targetSize;
+    m_genomePool->ReserveBlocks(3 * m_populationSize);
+}
+
+void GAMain::ReportHostStatistics(double currentTime, double leaseDuration, int logLevel)
+{
+    if (logLevel > m_logLevel) return;
+    for (auto &&host : m_hostStatistics.GetHosts())
+    {
+        std::string address = ConvertAddressPortToString(uint32_t(host.first >> 32), uint16_t(host.first & 0xffffffff));
+        ReportProgress(ToString("Host %s returns %" PRIu64 " latency %g s throughput %g per s prefetch target %zu", address.c_str(), host.second.returns, host.second.latency,
+                                m_hostStatistics.GetThroughput(host.first, currentTime), m_hostStatistics.GetPrefetchTarget(host.first, leaseDuration, currentTime)), logLevel);
+    }
 }
 
 void GAMain::ClearScoreQueue()
 {
-    std::unique_lock<std::mutex> lock(m_scoreMutex);
-    m_scoreQueue.clear();
+    {
+        std::unique_lock<std::mutex> lock(m_scoreMutex);
+        m_scoreQueue.clear();
+    }
+    m_scoreSpaceAvailable.notify_all();
+}
+
+void GAMain::ClearHeartbeatQueue()
+{
+    std::unique_lock<std::mutex> lock(m_heartbeatMutex);
+    m_heartbeatQueue.clear();
+}
+
+void GAMain::ClearClosedSessionQueue()
+{
+    std::unique_lock<std::mutex> lock(m_closedSessionMutex);
+    m_closedSessionQueue.clear();
+}
+
+void GAMain::ClearAdminQueue()
+{
+    std::unique_lock<std::mutex> lock(m_adminMutex);
+    m_adminQueue.clear();
 }
 
 // returns true if characters are available to read from stdin
@@ -15,11 +15,29 @@
 #include "Population.h"
 #include "Preferences.h"
 #include "Random.h"
+#include "EvaluationCache.h"
+#include "RunningList.h"
+#include "TimerWheel.h"
+#include "LatencyTracker.h"
+#include "HostStatistics.h"
+#include "DispatchQueue.h"
+#include "PipelineStage.h"
+#include "OffspringProducer.h"
+#include "Checkpoint.h"
+#include "EvaluationJournal.h"
+#include "SnapshotArchive.h"
+#include "PopulationDelta.h"
 
 #include <string>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
 #include <fstream>
+#include <unordered_set>
+#include <filesystem>
+#include <atomic>
+#include <thread>
+#include <deque>
 #include <inttypes.h>
 
 class AsynchronousGAQtWidget;
@@ -32,12 +50,27 @@ class GAMain
 {
 public:
     GAMain();
+    ~GAMain();
 
     int LoadBaseXMLFile(const std::string &filename);
     int Process(const std::string &parameterFile, const std::string &outputDirectory, const std::string &startingPopulation);
+    static int ProcessExperiments(ArgParse *argParse, const std::string &experimentsFile, int serverPort, int logLevel, bool trustStartingFitness, const std::string &adminToken);
 
     void SetLogLevel(int logLevel) { m_logLevel = logLevel; }
     void SetServerPort(int port);
+    void SetEvaluationCache(const std::string &filename, size_t capacity);
+    void SetTrustStartingFitness(bool trustStartingFitness) { m_trustStartingFitness = trustStartingFitness; }
+    void SetSharedServer(ServerASIO *server) { m_sharedServer = server; } // the handlers are attached by the owner of the server and stdin is left to the owner too
+    void SetRedirectHandler(std::function<void (MessageASIO)> &&redirectHandler) { m_redirectHandler = std::move(redirectHandler); } // receives genome requests once the evolution has finished
+    void SetAdminToken(const std::string &adminToken) { m_adminToken = adminToken; } // admin commands are refused if this is empty
+    void SetReportPrefix(const std::string &reportPrefix) { m_reportPrefix = reportPrefix; }
+    void RequestStop() { m_stopRequested = true; }
+    void SetWaitForSwap(bool waitForSwap) { m_waitForSwap = waitForSwap; } // keep the server and clients when a run finishes until a swap or stop arrives
+    int RequestSwap(const std::vector<std::string> &arguments, std::string *result);
+    void SetResumeCheckpoint(const std::string &resumeCheckpoint) { m_resumeCheckpointFile = resumeCheckpoint; } // continue the run saved in this checkpoint rather than reading a starting population
+
+    uint64_t GetEvolveIdentifier() const { return m_evolveIdentifier; }
+    bool GetRequestGenomeQueueEnabled() const { return m_requestGenomeQueueEnabled; }
 
     static std::string ConvertAddressPortToString(uint32_t address, uint16_t port);
     static std::string ConvertAddressToString(uint32_t address);
@@ -46,6 +79,10 @@ class GAMain
     void handleRequestGenome(MessageASIO message);
     void handleRequestXML(MessageASIO message);
     void handleScore(MessageASIO message);
+    void handleHeartbeat(MessageASIO message);
+    void handleResume(MessageASIO message);
+    void handleSessionClosed(uint64_t sessionID);
+    void handleAdmin(MessageASIO message);
 
     static bool pollStdin();
 
@@ -76,53 +113,161 @@ class GAMain
         double score;
     };
 
-    struct RunSpecifier
-    {
-        Genome genome;
-        double startTime;
-        uint32_t senderIP;
-        uint32_t senderPort;
-    };
-
 
     ArgParse *argParse() const;
     void setArgParse(ArgParse *newArgParse);
 
 private:
+    enum TimerType { LeaseTimer = 0, StragglerTimer = 1 };
+
+    // the parts of the evolve loop state that are not held in members
+    struct EvolveCounters
+    {
+        uint64_t submitCount = 0;
+        uint32_t returnCount = 0;
+        double bestFitness = 0;
+        double lastBestFitness = 0;
+        bool stopSendingFlag = false;
+        uint64_t eliteReevaluations = 0;
+        size_t populationSize = 0;
+    };
+
     int Evolve();
+    int CreateOutputFolder(const std::string &outputDirectory);
+    void ConfigurePopulations();
+    int InitialisePopulations();
+    void LoadStartingPopulation(const std::string &filename, bool randomise);
+    void StopPopulationLoader();
+    int ProcessLoadedGenomes();
+    void NewEvolveIdentifier();
+    void WaitForSwap();
+    int ApplySwap();
+    void CloseRequestGenomeQueue();
+    static std::string GetTimeString();
+    double LeaseDuration(LatencyTracker *latencyTracker);
+    void ProcessHeartbeats(RunningList *runningList, double currentTime);
+    void ProcessClosedSessions(RunningList *runningList, DispatchQueue *dispatchQueue, double currentTime);
+    void UpdateElasticPopulation();
+    void ProcessAdminCommands(const std::function<std::string ()> &statusFunction);
+    void WriteCheckpoint(uint32_t returnCount);
+    void WriteStateCheckpoint(const EvolveCounters &counters, const RunningList &runningList);
+    int ReadStateCheckpoint(const std::string &filename);
+    void SaveBestGenome(const std::string &filename, bool onlyIfMissing);
+    void SavePopulation(const std::string &filename, bool onlyIfMissing);
+    std::string GetPopulationFileName(uint32_t returnCount);
+    void SaveToArchive(SnapshotArchive::Kind kind, const std::string &filename, bool onlyIfMissing, std::vector<std::shared_ptr<const Genome>> &&snapshot, size_t keep);
+    void AppendToLog(const std::string &text);
+    void SetPopulationSize(size_t populationSize);
+    int ReloadPreferences(std::string *result, bool reportFailure = true);
+    bool GetNextGenomeToSend(std::unique_ptr<Genome> *genome, bool fromStartPopulation, std::array<int32_t, 2> *parentRanks);
+    void BuildDataMessage(const Genome &genome, uint64_t runID, std::vector<char> *dataMessage);
 
     size_t GenomeRequestQueueSize();
     size_t ScoreQueueSize();
     void GetNextGenomeRequest(MessageASIO *message);
-    void GetNextScore(MessageASIO *message);
-    void ClearGenomeRequestQueue();
+    void GetFastestGenomeRequest(MessageASIO *message);
+    void GetPrefetchGenomeRequest(MessageASIO *message, const RunningList &runningList, double leaseDuration, double currentTime);
+    void ReturnGenomeRequest(MessageASIO &&message);
+    void ReportHostStatistics(double currentTime, double leaseDuration, int logLevel);
+    void IngestScore(const MessageASIO &message);
+    void GetNextScore(RequestMessage *score);
+    void OpenScoreQueue(bool open);
     void ClearScoreQueue();
+    void ClearHeartbeatQueue();
+    void ClearClosedSessionQueue();
+    void ClearAdminQueue();
 
     DataFile m_baseXMLFile;
     std::vector<uint32_t> m_md5 = {0, 0, 0, 0};
-    uint64_t m_evolveIdentifier = 0;
+    std::atomic<uint64_t> m_evolveIdentifier = {0};
+    static std::atomic<uint64_t> s_lastEvolveIdentifier; // identifiers must be unique when several evolutions share a server
 
-    int m_logLevel = 0;
+    std::atomic<int> m_logLevel = {0};
+    std::string m_reportPrefix;
+    static std::mutex s_reportMutex;
 
     void ReportProgress(const std::string &message, int logLevel);
     void ReportInfo(const std::string &message);
 
     std::deque<MessageASIO> m_requestGenomeQueue;
-    std::deque<MessageASIO> m_scoreQueue;
+    std::deque<RequestMessage> m_scoreQueue; // decoded by the ingest stage and only for the current evolution
+    size_t m_scoreQueueCapacity = 4096; // only applied while an evolution is reading the queue
+    bool m_scoreQueueOpen = false;
+    std::condition_variable m_scoreSpaceAvailable;
+    std::deque<MessageASIO> m_heartbeatQueue;
+    std::deque<MessageASIO> m_heartbeatProcessQueue;
+    std::vector<uint64_t> m_closedSessionQueue;
+    std::vector<uint64_t> m_closedSessionProcessQueue;
+    std::vector<uint64_t> m_closedSessionRunIDs;
+    uint64_t m_requeueCount = 0;
+    HostStatistics m_hostStatistics;
+    uint64_t m_fastHostSelections = 0;
+    uint64_t m_prefetchDeferrals = 0; // requests served ahead of one from a client already holding its prefetch target
+    size_t m_activeClients = 0; // distinct IP addresses heard from within the last lease duration, whatever their connection model
+    size_t m_populationSize = 0; // the current target which can differ from the preferences value with an elastic population
+    uint64_t m_resumeCount = 0;
     std::mutex m_requestGenomeMutex;
     std::mutex m_scoreMutex;
+    std::mutex m_heartbeatMutex;
+    std::mutex m_closedSessionMutex;
+    std::deque<MessageASIO> m_adminQueue;
+    std::deque<MessageASIO> m_adminProcessQueue;
+    std::mutex m_adminMutex;
+    std::string m_adminToken;
+    bool m_dispatchPaused = false;
+    bool m_checkpointRequested = false;
+    bool m_dispatchSettingsChanged = false; // the dispatch queue belongs to Evolve so it picks up reloaded settings itself
+    std::filesystem::file_time_type m_parameterFileTime;
+    std::filesystem::file_time_type m_parameterFileFailedTime;
     std::atomic<bool> m_requestGenomeQueueEnabled = {false};
+    std::atomic<bool> m_stopRequested = {false};
+    bool m_userStopped = false;
+    bool m_waitForSwap = false;
+    bool m_swapPending = false; // set by RequestSwap which is only called from the evolve thread
+    std::string m_swapBaseXMLFile;
+    std::string m_swapStartingPopulation;
+    std::string m_swapOutputDirectory;
+    std::mutex m_baseXMLMutex; // the XML is sent from the server thread
+    uint32_t m_xmlGenomeLength = 0;
+    ServerASIO *m_sharedServer = nullptr;
+    std::function<void (MessageASIO)> m_redirectHandler;
     uint64_t m_loopSleepTimeMicroSeconds = 1;
 
     Population m_startPopulation;
+    std::deque<const Genome *> m_startQueue; // members of the start population that have not been sent yet
+    std::vector<std::unique_ptr<Genome>> m_startGenomes; // held here until the whole starting population has been read
+    std::unordered_set<double> m_startFitnessValues;
+    bool m_startPopulationLoaded = false;
+    std::thread m_populationLoaderThread;
+    std::mutex m_loadedGenomesMutex;
+    std::vector<std::unique_ptr<Genome>> m_loadedGenomes; // read by the loader thread but not yet moved into the start population
+    std::atomic<bool> m_populationLoading = {false};
+    std::atomic<bool> m_populationLoaderAbort = {false};
+    std::atomic<int> m_populationLoadError = {0};
     Population m_evolvePopulation;
-    std::ofstream m_outputLogFile;
+    std::shared_ptr<GenomePool> m_genomePool = GenomePool::Create(); // the genomes in the running list and the evolve population and their control blocks
+    std::ofstream m_outputLogFile; // only written by the persistence stage while it is running
+    std::mutex m_pendingLogMutex;
+    std::string m_pendingLog; // collected here so that the log never holds up the caller and nothing is lost when its job is replaced
+    // persistence jobs are never waited for so each kind of output has a key and a newer job replaces one that is still queued
+    // which also means that the writer holds at most one pending snapshot of each kind
+    enum PersistenceJob : uint32_t { LogJob = 1, BestGenomeJob, PopulationJob, CheckpointJob, TidyJob };
+    PipelineStage m_persistenceStage;
+    PipelineStage m_reportingStage;
+    PipelineStage m_ingestStage; // scores from the network are decoded and checked here before the evolve loop sees them
+    OffspringProducer m_offspringProducer; // the evolve loop updates the population and the offspring are bred ahead from copies of it
     std::string m_outputFolderName;
     const std::string m_bestGenomeModel{"BestGenome_%012" PRIu32 ".txt"};
     const std::string m_bestPopulationModel{"Population_%012" PRIu32 ".txt"};
     const std::string m_bestGenomeRegex{"BestGenome_[0-9]+.txt"};
     const std::string m_bestPopulationRegex{"Population_[0-9]+.txt"};
+    const std::string m_binaryPopulationModel{"Population_%012" PRIu32 ".bin"};
+    const std::string m_binaryPopulationRegex{"Population_[0-9]+.bin"};
+    const std::string m_populationDeltaExtension{".delta"};
+    const std::string m_md5RecordSuffix{".md5"};
     int OnlyKeepLastMatching(const std::string &regexPattern);
+    int WriteMD5Record(const std::string &populationFile, const std::string &md5String);
+    int ReadMD5Record(const std::string &populationFile, std::string *md5String);
     std::string m_parameterFile;
 
     std::array<uint8_t, 4> m_ipAddress = {0, 0, 0, 0};
@@ -131,6 +276,28 @@ class GAMain
 
     Preferences m_preferences;
 
+    EvaluationCache m_evaluationCache;
+    std::string m_evaluationCacheFile;
+    size_t m_evaluationCacheSize = 0;
+    uint64_t m_evaluationCacheHits = 0;
+
+    EvaluationJournal m_evaluationJournal; // opened with each output folder when journalEvaluations is set
+    const std::string m_evaluationJournalName{"EvaluationJournal.bin"};
+
+    SnapshotArchive m_snapshotArchive; // opened with each output folder when snapshotArchive is set and only used by the persistence stage apart from IsOpen
+    const std::string m_snapshotArchiveName{"Snapshots.bin"};
+
+    PopulationDelta m_populationDelta; // the last population written when populationKeyframeEvery is set, only used by the persistence stage
+
+    bool m_trustStartingFitness = false;
+    bool m_startingFitnessTrusted = false;
+
+    std::string m_resumeCheckpointFile;
+    bool m_resuming = false; // the state has been read from a checkpoint and the next Evolve picks up the counters and runs
+    EvolveCounters m_resumeCounters;
+    std::vector<RunningList::RunSpecifier> m_resumeRuns;
+    const std::string m_stateCheckpointName{"Checkpoint.bin"};
+
     ArgParse *m_argParse = nullptr;
 };
 
@@ -9,9 +9,12 @@
 
 #include <iostream>
 #include <limits>
+#include <string>
+#include <charconv>
 
 #include "Genome.h"
 #include "Random.h"
+#include "Checkpoint.h"
 
 // constructor
 Genome::Genome()
@@ -28,21 +31,24 @@ Genome::Genome(const Genome &in)
     m_genomeType = in.m_genomeType;
     m_globalCircularMutationFlag = in.m_globalCircularMutationFlag;
     m_fitness = in.m_fitness;
+    // the parents are not copied because a copy is not bred from them and each weak reference would keep a parent's control block alive
 }
 
-Genome::Genome(Genome &&in)
+Genome::Genome(Genome &&in) noexcept
 {
-    m_genes = in.m_genes;
-    m_lowBounds = in.m_lowBounds;
-    m_highBounds = in.m_highBounds;
-    m_gaussianSDs = in.m_gaussianSDs;
-    m_circularMutationFlags = in.m_circularMutationFlags;
+    m_genes = std::move(in.m_genes);
+    m_lowBounds = std::move(in.m_lowBounds);
+    m_highBounds = std::move(in.m_highBounds);
+    m_gaussianSDs = std::move(in.m_gaussianSDs);
+    m_circularMutationFlags = std::move(in.m_circularMutationFlags);
     m_genomeType = in.m_genomeType;
     m_globalCircularMutationFlag = in.m_globalCircularMutationFlag;
     m_fitness = in.m_fitness;
+    m_parents = std::move(in.m_parents);
 }
 
 // define = operators
+// note: copy assignment reuses the existing vector storage so assigning to a recycled genome does not allocate
 Genome &Genome::operator=(const Genome &in)
 {
     if (&in != this)
@@ -55,22 +61,24 @@ Genome &Genome::operator=(const Genome &in)
         m_genomeType = in.m_genomeType;
         m_globalCircularMutationFlag = in.m_globalCircularMutationFlag;
         m_fitness = in.m_fitness;
+        m_parents = {}; // not copied for the same reason as in the copy constructor
     }
     return *this;
 }
 
-Genome &Genome::operator=(Genome &&in)
+Genome &Genome::operator=(Genome &&in) noexcept
 {
     if (&in != this)
     {
-        m_genes = in.m_genes;
-        m_lowBounds = in.m_lowBounds;
-        m_highBounds = in.m_highBounds;
-        m_gaussianSDs = in.m_gaussianSDs;
-        m_circularMutationFlags = in.m_circularMutationFlags;
+        m_genes = std::move(in.m_genes);
+        m_lowBounds = std::move(in.m_lowBounds);
+        m_highBounds = std::move(in.m_highBounds);
+        m_gaussianSDs = std::move(in.m_gaussianSDs);
+        m_circularMutationFlags = std::move(in.m_circularMutationFlags);
         m_genomeType = in.m_genomeType;
         m_globalCircularMutationFlag = in.m_globalCircularMutationFlag;
         m_fitness = in.m_fitness;
+        m_parents = std::move(in.m_parents);
     }
     return *this;
 }
@@ -85,6 +93,53 @@ void Genome::Clear()
     m_genomeType = IndividualRanges;
     m_globalCircularMutationFlag = false;
     m_fitness = -std::numeric_limits<double>::max();
+    m_parents = {};
+}
+
+// reuses the existing storage like copy assignment does
+void Genome::Assign(GenomeType genomeType, size_t genomeLength, const double *genes, const double *lowBounds, const double *highBounds, const double *gaussianSDs,
+                    const int32_t *circularMutationFlags, double fitness)
+{
+    m_genes.assign(genes, genes + genomeLength);
+    m_lowBounds.assign(lowBounds, lowBounds + genomeLength);
+    m_highBounds.assign(highBounds, highBounds + genomeLength);
+    m_gaussianSDs.assign(gaussianSDs, gaussianSDs + genomeLength);
+    m_circularMutationFlags.assign(circularMutationFlags, circularMutationFlags + genomeLength);
+    m_genomeType = genomeType;
+    m_globalCircularMutationFlag = false;
+    m_fitness = fitness;
+}
+
+// binary copy of everything in the genome for checkpoints
+void Genome::WriteCheckpoint(Checkpoint *checkpoint) const
+{
+    checkpoint->Write(int32_t(m_genomeType));
+    checkpoint->Write(m_globalCircularMutationFlag);
+    checkpoint->Write(m_fitness);
+    checkpoint->WriteVector(m_genes);
+    checkpoint->WriteVector(m_lowBounds);
+    checkpoint->WriteVector(m_highBounds);
+    checkpoint->WriteVector(m_gaussianSDs);
+    checkpoint->WriteVector(m_circularMutationFlags);
+}
+
+int Genome::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    int32_t genomeType = 0;
+    checkpoint->Read(&genomeType);
+    checkpoint->Read(&m_globalCircularMutationFlag);
+    checkpoint->Read(&m_fitness);
+    checkpoint->ReadVector(&m_genes);
+    checkpoint->ReadVector(&m_lowBounds);
+    checkpoint->ReadVector(&m_highBounds);
+    checkpoint->ReadVector(&m_gaussianSDs);
+    checkpoint->ReadVector(&m_circularMutationFlags);
+    if (checkpoint->GetReadError()) return __LINE__;
+    if (genomeType != IndividualRanges && genomeType != IndividualCircularMutation) return __LINE__;
+    m_genomeType = GenomeType(genomeType);
+    size_t genomeLength = m_genes.size();
+    if (m_lowBounds.size() != genomeLength || m_highBounds.size() != genomeLength || m_gaussianSDs.size() != genomeLength || m_circularMutationFlags.size() != genomeLength) return __LINE__;
+    return 0;
 }
 
 // randomise the genome
@@ -122,52 +177,127 @@ bool Genome::GetCircularMutation(int i)
     return v;
 }
 
-// output to a stream
-std::ostream& operator<<(std::ostream &out, const Genome &g)
+// the text format is written with std::to_chars which gives the shortest text that reads back to exactly the same
+// double and does not depend on the locale. Values written with the older %.17g format read back unchanged
+
+static void AppendValue(std::string *text, double value, char separator)
 {
-    char buf[256];
-    switch (g.m_genomeType)
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    text->append(buf, result.ptr);
+    text->push_back(separator);
+}
+
+static void AppendValue(std::string *text, long long value, char separator)
+{
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    text->append(buf, result.ptr);
+    text->push_back(separator);
+}
+
+static const char *SkipSpace(const char *ptr, const char *last)
+{
+    while (ptr < last && (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r' || *ptr == '\v' || *ptr == '\f')) ptr++;
+    return ptr;
+}
+
+// returns nullptr on failure and passes a failure on so that a whole record can be parsed before checking
+template<typename T> static const char *ParseValue(const char *ptr, const char *last, T *value)
+{
+    if (!ptr) return nullptr;
+    ptr = SkipSpace(ptr, last);
+    if (ptr < last && *ptr == '+') ptr++; // stream extraction accepted a leading plus sign
+    auto result = std::from_chars(ptr, last, *value);
+    if (result.ec != std::errc()) return nullptr;
+    return result.ptr;
+}
+
+void Genome::AppendText(std::string *text) const
+{
+    AppendValue(text, (long long)m_genomeType, '\n');
+    AppendValue(text, (long long)m_genes.size(), '\n');
+    for (size_t i = 0; i < m_genes.size(); i++)
     {
-    case Genome::IndividualRanges:
-        std::sprintf(buf, "%d\n", g.m_genomeType);
-        out << buf;
-        std::sprintf(buf, "%zu\n", g.m_genes.size());
-        out << buf;
-        for (size_t i = 0; i < g.m_genes.size(); i++)
+        AppendValue(text, m_genes[i], '\t');
+        AppendValue(text, m_lowBounds[i], '\t');
+        AppendValue(text, m_highBounds[i], '\t');
+        if (m_genomeType == IndividualCircularMutation)
         {
-            std::sprintf(buf, "%.17g\t%.17g\t%.17g\t%.17g\n", g.m_genes[i], g.m_lowBounds[i], g.m_highBounds[i],  g.m_gaussianSDs[i]);
-            out << buf;
+            AppendValue(text, m_gaussianSDs[i], '\t');
+            AppendValue(text, (long long)m_circularMutationFlags[i], '\n');
         }
-        std::sprintf(buf, "%.17g\t0\t0\t0\t0\n",  g.m_fitness);
-        out << buf;
-        break;
-
-    case Genome::IndividualCircularMutation:
-        std::sprintf(buf, "%d\n", g.m_genomeType);
-        out << buf;
-        std::sprintf(buf, "%zu\n", g.m_genes.size());
-        out << buf;
-        for (size_t i = 0; i < g.m_genes.size(); i++)
+        else
         {
-            std::sprintf(buf, "%.17g\t%.17g\t%.17g\t%.17g\t%d\n", g.m_genes[i], g.m_lowBounds[i], g.m_highBounds[i],  g.m_gaussianSDs[i], g.m_circularMutationFlags[i]);
-            out << buf;
+            AppendValue(text, m_gaussianSDs[i], '\n');
         }
-        std::sprintf(buf, "%.17g\t0\t0\t0\t0\n",  g.m_fitness);
-        out << buf;
-        break;
     }
+    AppendValue(text, m_fitness, '\t');
+    text->append("0\t0\t0\t0\n");
+}
+
+// parses one genome record from a buffer and returns the position after it or nullptr if the record is not valid
+const char *Genome::ParseText(const char *first, const char *last)
+{
+    int genomeType = 0;
+    size_t genomeLength = 0;
+    int dummy = 0;
+    const char *ptr = ParseValue(first, last, &genomeType);
+    ptr = ParseValue(ptr, last, &genomeLength);
+    if (!ptr || (genomeType != IndividualRanges && genomeType != IndividualCircularMutation) || genomeLength > size_t(last - ptr)) return nullptr;
+
+    Clear();
+    m_genes.resize(genomeLength);
+    m_lowBounds.resize(genomeLength);
+    m_highBounds.resize(genomeLength);
+    m_gaussianSDs.resize(genomeLength);
+    m_circularMutationFlags.resize(genomeLength);
+    m_genomeType = GenomeType(genomeType);
+    for (size_t i = 0; i < genomeLength && ptr; i++)
+    {
+        ptr = ParseValue(ptr, last, &m_genes[i]);
+        ptr = ParseValue(ptr, last, &m_lowBounds[i]);
+        ptr = ParseValue(ptr, last, &m_highBounds[i]);
+        ptr = ParseValue(ptr, last, &m_gaussianSDs[i]);
+        if (m_genomeType == IndividualCircularMutation) ptr = ParseValue(ptr, last, &m_circularMutationFlags[i]);
+    }
+    ptr = ParseValue(ptr, last, &m_fitness);
+    for (int i = 0; i < 4; i++) ptr = ParseValue(ptr, last, &dummy);
+    return ptr;
+}
+
+// output to a stream
+std::ostream& operator<<(std::ostream &out, const Genome &g)
+{
+    std::string text;
+    text.reserve(64 + g.m_genes.size() * 96);
+    g.AppendText(&text);
+    out.write(text.data(), std::streamsize(text.size()));
     return out;
 }
 
 // input from a stream
+// the tokens are converted with std::from_chars so that the values are exact and do not depend on the locale
 std::istream& operator>>(std::istream &in, Genome &g)
 {
-    int genomeType;
-    size_t genomeLength;
-    int dummy = 0;
+    std::string token;
+    auto next = [&in, &token]() -> const char *
+    {
+        if (!(in >> token)) return nullptr;
+        return token.data();
+    };
+    auto read = [&](auto *value)
+    {
+        const char *ptr = next();
+        if (ptr && ParseValue(ptr, ptr + token.size(), value) == nullptr) in.setstate(std::ios::failbit);
+    };
 
-    in >> genomeType;
-    in >> genomeLength;
+    int genomeType = 0;
+    size_t genomeLength = 0;
+    int dummy = 0;
+    read(&genomeType);
+    read(&genomeLength);
+    if (!in) return in;
 
     g.Clear();
     g.m_genes.resize(genomeLength);
@@ -180,13 +310,13 @@ std::istream& operator>>(std::istream &in, Genome &g)
     switch (g.m_genomeType)
     {
     case Genome::IndividualRanges:
-        for (size_t i = 0; i < genomeLength; i++) { in >> g.m_genes[i] >> g.m_lowBounds[i] >> g.m_highBounds[i] >> g.m_gaussianSDs[i]; }
-        in >> g.m_fitness >> dummy >> dummy >> dummy >> dummy;
+        for (size_t i = 0; i < genomeLength; i++) { read(&g.m_genes[i]); read(&g.m_lowBounds[i]); read(&g.m_highBounds[i]); read(&g.m_gaussianSDs[i]); }
+        read(&g.m_fitness); read(&dummy); read(&dummy); read(&dummy); read(&dummy);
         break;
 
     case Genome::IndividualCircularMutation:
-        for (size_t i = 0; i < genomeLength; i++) { in >> g.m_genes[i] >> g.m_lowBounds[i] >> g.m_highBounds[i] >> g.m_gaussianSDs[i] >> g.m_circularMutationFlags[i]; }
-        in >> g.m_fitness >> dummy >> dummy >> dummy >> dummy;
+        for (size_t i = 0; i < genomeLength; i++) { read(&g.m_genes[i]); read(&g.m_lowBounds[i]); read(&g.m_highBounds[i]); read(&g.m_gaussianSDs[i]); read(&g.m_circularMutationFlags[i]); }
+        read(&g.m_fitness); read(&dummy); read(&dummy); read(&dummy); read(&dummy);
         break;
     }
 
@@ -11,10 +11,15 @@
 #define GENOME_H
 
 #include <iostream>
+#include <string>
 #include <vector>
+#include <array>
+#include <memory>
 #include <limits>
+#include <cstdint>
 
 class Random;
+class Checkpoint;
 
 class Genome
 {
@@ -22,9 +27,9 @@ class Genome
 
     Genome();
     Genome(const Genome &g);
-    Genome(Genome &&g);
+    Genome(Genome &&g) noexcept;
     Genome& operator=(const Genome &g);
-    Genome& operator=(Genome &&g);
+    Genome& operator=(Genome &&g) noexcept;
 
     enum GenomeType
     {
@@ -40,14 +45,29 @@ class Genome
     double GetFitness() const { return m_fitness; }
     GenomeType GetGenomeType() const { return m_genomeType; }
     std::vector<double> *GetGenes() { return &m_genes; }
+    const std::vector<double> *GetGenes() const { return &m_genes; }
+    const std::vector<double> *GetLowBounds() const { return &m_lowBounds; }
+    const std::vector<double> *GetHighBounds() const { return &m_highBounds; }
+    const std::vector<double> *GetGaussianSDs() const { return &m_gaussianSDs; }
+    const std::vector<int> *GetCircularMutationFlags() const { return &m_circularMutationFlags; }
     bool GetCircularMutation(int i);
-    bool GetGlobalCircularMutationFlag() { return m_globalCircularMutationFlag; }
+    bool GetGlobalCircularMutationFlag() const { return m_globalCircularMutationFlag; }
+    std::shared_ptr<const Genome> GetParent(size_t i) const { return m_parents[i].lock(); } // nullptr once the parent no longer exists
 
     void Randomise(Random *random);
     void SetGene(size_t i, double value) { m_genes[i] = value; }
     void SetFitness(double fitness) { m_fitness = fitness; }
     void SetGlobalCircularMutationFlag(bool globalCircularMutationFlag) { m_globalCircularMutationFlag = globalCircularMutationFlag; }
+    void SetParents(const std::shared_ptr<const Genome> &parent1, const std::shared_ptr<const Genome> &parent2 = nullptr) { m_parents = {parent1, parent2}; }
     void Clear();
+    void Assign(GenomeType genomeType, size_t genomeLength, const double *genes, const double *lowBounds, const double *highBounds, const double *gaussianSDs,
+                const int32_t *circularMutationFlags, double fitness); // fills the genome from arrays, for example a mapped binary population
+
+    void AppendText(std::string *text) const; // the same text as operator<<
+    const char *ParseText(const char *first, const char *last); // returns the end of the record or nullptr if it is not valid
+
+    void WriteCheckpoint(Checkpoint *checkpoint) const;
+    int ReadCheckpoint(Checkpoint *checkpoint);
 
     friend constexpr auto operator<=>(const Genome& l, const Genome& r) noexcept {  return (l.m_fitness <=> r.m_fitness); }
 
@@ -64,6 +84,7 @@ class Genome
     GenomeType m_genomeType = IndividualRanges;
     bool m_globalCircularMutationFlag = false;
     double m_fitness = -std::numeric_limits<double>::max();
+    std::array<std::weak_ptr<const Genome>, 2> m_parents; // only used to store population deltas compactly so they do not keep the parents alive, moved but never copied
 };
 
 #endif // GENOME_H
@@ -0,0 +1,92 @@
+#include "GenomePool.h"
+
+#include <new>
+
+GenomePool::~GenomePool()
+{
+    for (auto &&block : m_freeBlocks) ::operator delete(block);
+}
+
+std::unique_ptr<Genome> GenomePool::Acquire()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_genomes.size())
+        {
+            std::unique_ptr<Genome> genome = std::move(m_genomes.back());
+            m_genomes.pop_back();
+            return genome;
+        }
+    }
+    return std::make_unique<Genome>();
+}
+
+void GenomePool::Release(std::unique_ptr<Genome> genome)
+{
+    if (!genome) return;
+    // letting go of the parents can free their control blocks which needs the lock
+    genome->SetParents(nullptr);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_genomes.push_back(std::move(genome));
+}
+
+std::shared_ptr<Genome> GenomePool::Share(std::unique_ptr<Genome> genome)
+{
+    Genome *genomePtr = genome.release();
+    return std::shared_ptr<Genome>(genomePtr, Recycler{this}, BlockAllocator<Genome>(shared_from_this()));
+}
+
+void GenomePool::ReserveBlocks(size_t count)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_blockSize == 0)
+    {
+        // sharing a genome is the only way to find out the block size
+        lock.unlock();
+        Share(std::make_unique<Genome>());
+        lock.lock();
+    }
+    m_freeBlocks.reserve(count);
+    m_genomes.reserve(count);
+    while (m_freeBlocks.size() < count) m_freeBlocks.push_back(::operator new(m_blockSize));
+}
+
+size_t GenomePool::GetSize()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_genomes.size();
+}
+
+size_t GenomePool::GetFreeBlockCount()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_freeBlocks.size();
+}
+
+void *GenomePool::AllocateBlock(size_t size)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_blockSize == 0) m_blockSize = size;
+        if (size == m_blockSize && m_freeBlocks.size())
+        {
+            void *block = m_freeBlocks.back();
+            m_freeBlocks.pop_back();
+            return block;
+        }
+    }
+    return ::operator new(size);
+}
+
+void GenomePool::FreeBlock(void *block, size_t size)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (size == m_blockSize)
+        {
+            m_freeBlocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
@@ -0,0 +1,69 @@
+#ifndef GENOMEPOOL_H
+#define GENOMEPOOL_H
+
+#include "Genome.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+// genomes and their shared_ptr control blocks are recycled here so that once things have warmed up a genome can go round
+// offspring production, the running list and the population without any heap allocation.
+// The population shares its genomes with snapshots so each genome it holds needs a control block, and these are carved
+// from fixed size blocks kept on a free list. When the last owner of a shared genome lets go it comes back to the pool
+// with its gene storage intact to be reused for the next offspring.
+// Genomes and blocks can be returned from any thread because snapshots are let go of on the persistence thread.
+// The pool is itself shared so that a genome that outlives its population still has somewhere to go.
+
+class GenomePool : public std::enable_shared_from_this<GenomePool>
+{
+public:
+    static std::shared_ptr<GenomePool> Create() { return std::shared_ptr<GenomePool>(new GenomePool()); }
+    ~GenomePool();
+
+    GenomePool(const GenomePool &) = delete;
+    GenomePool &operator=(const GenomePool &) = delete;
+
+    std::unique_ptr<Genome> Acquire(); // a recycled genome if there is one, its contents are whatever it last held
+    void Release(std::unique_ptr<Genome> genome);
+    std::shared_ptr<Genome> Share(std::unique_ptr<Genome> genome); // the genome is released back to the pool when the last owner lets go
+
+    // a genome's control block outlives it while its offspring still name it as a parent so the blocks in use can be up to
+    // three times the number of shared genomes and growing into that would allocate now and then for a long time.
+    // Copies of a genome do not name its parents so only bred genomes count towards this
+    void ReserveBlocks(size_t count);
+
+    size_t GetSize(); // genomes waiting to be reused
+    size_t GetFreeBlockCount();
+
+private:
+    GenomePool() = default;
+
+    struct Recycler
+    {
+        void operator()(Genome *genome) const { pool->Release(std::unique_ptr<Genome>(genome)); }
+        GenomePool *pool; // kept alive by the allocator in the same control block
+    };
+
+    template<typename T> struct BlockAllocator
+    {
+        using value_type = T;
+        BlockAllocator(const std::shared_ptr<GenomePool> &pool) : pool(pool) {}
+        template<typename U> BlockAllocator(const BlockAllocator<U> &other) : pool(other.pool) {}
+        T *allocate(size_t n) { return static_cast<T *>(pool->AllocateBlock(n * sizeof(T))); }
+        void deallocate(T *ptr, size_t n) { pool->FreeBlock(ptr, n * sizeof(T)); }
+        template<typename U> bool operator==(const BlockAllocator<U> &other) const { return pool == other.pool; }
+        std::shared_ptr<GenomePool> pool; // the copy in the control block keeps the pool alive until the block has been freed
+    };
+
+    void *AllocateBlock(size_t size);
+    void FreeBlock(void *block, size_t size);
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Genome>> m_genomes;
+    std::vector<void *> m_freeBlocks;
+    size_t m_blockSize = 0; // every control block is the same size so only that size is kept
+};
+
+#endif // GENOMEPOOL_H
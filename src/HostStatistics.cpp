@@ -0,0 +1,81 @@
+#include "HostStatistics.h"
+
+#include <cmath>
+
+HostStatistics::HostStatistics(double latencySmoothing, double throughputTimeConstant)
+{
+    m_latencySmoothing = latencySmoothing;
+    m_throughputTimeConstant = throughputTimeConstant;
+}
+
+void HostStatistics::AddReturn(uint64_t hostKey, double latency, double currentTime)
+{
+    Host &host = m_hosts[hostKey];
+    if (host.returns == 0) host.latency = latency;
+    else host.latency += m_latencySmoothing * (latency - host.latency);
+    if (host.returns) host.decayedReturns *= std::exp(-(currentTime - host.lastReturnTime) / m_throughputTimeConstant);
+    host.decayedReturns += 1;
+    host.lastReturnTime = currentTime;
+    host.lastSeenTime = currentTime;
+    host.returns++;
+}
+
+// a client is counted from its first request rather than its first return so that its connection model does not matter
+void HostStatistics::AddRequest(uint64_t hostKey, double currentTime)
+{
+    m_hosts[hostKey].lastSeenTime = currentTime;
+}
+
+bool HostStatistics::GetLatency(uint64_t hostKey, double *latency) const
+{
+    auto it = m_hosts.find(hostKey);
+    if (it == m_hosts.end() || it->second.returns == 0) return false;
+    *latency = it->second.latency;
+    return true;
+}
+
+// returns per second
+double HostStatistics::GetThroughput(uint64_t hostKey, double currentTime) const
+{
+    auto it = m_hosts.find(hostKey);
+    if (it == m_hosts.end()) return 0;
+    return it->second.decayedReturns * std::exp(-(currentTime - it->second.lastReturnTime) / m_throughputTimeConstant) / m_throughputTimeConstant;
+}
+
+size_t HostStatistics::GetPrefetchTarget(uint64_t hostKey, double leaseDuration, double currentTime) const
+{
+    double target = std::floor(GetThroughput(hostKey, currentTime) * leaseDuration);
+    return target > 1 ? size_t(target) : 1;
+}
+
+double HostStatistics::GetMeanLatency() const
+{
+    double sum = 0;
+    size_t count = 0;
+    for (auto &&host : m_hosts)
+    {
+        if (host.second.returns == 0) continue;
+        sum += host.second.latency;
+        count++;
+    }
+    return count ? sum / double(count) : 0;
+}
+
+// the hosts are keyed by IP and port and a machine running several workers, or reconnecting from a new port,
+// would otherwise be counted more than once
+size_t HostStatistics::GetActiveHostCount(double since) const
+{
+    m_activeIPs.clear();
+    for (auto &&host : m_hosts) { if (host.second.lastSeenTime >= since) m_activeIPs.insert(uint32_t(host.first >> 32)); }
+    return m_activeIPs.size();
+}
+
+// clients that have gone away would otherwise be kept for the whole run
+void HostStatistics::Prune(double olderThan)
+{
+    for (auto it = m_hosts.begin(); it != m_hosts.end();)
+    {
+        if (it->second.lastSeenTime < olderThan) it = m_hosts.erase(it);
+        else it++;
+    }
+}
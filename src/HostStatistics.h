@@ -0,0 +1,54 @@
+#ifndef HOSTSTATISTICS_H
+#define HOSTSTATISTICS_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <cstdint>
+
+// per client estimates of evaluation latency and throughput
+// the latency is an exponentially weighted moving average of the evaluation times and the throughput
+// is an exponentially decayed count of returns divided by the decay time constant so both follow changes in load
+// the prefetch target is the number of runs a client can be expected to return within a lease so a client that asks
+// for work before returning its earlier runs can hold that many without any of them being likely to expire
+
+class HostStatistics
+{
+public:
+    HostStatistics(double latencySmoothing = 0.2, double throughputTimeConstant = 300);
+
+    struct Host
+    {
+        double latency = 0;
+        double decayedReturns = 0;
+        double lastReturnTime = 0;
+        uint64_t returns = 0;
+        double lastSeenTime = 0; // last request or return
+    };
+
+    static uint64_t HostKey(uint32_t senderIP, uint32_t senderPort) { return (uint64_t(senderIP) << 32) | senderPort; }
+
+    void AddReturn(uint64_t hostKey, double latency, double currentTime);
+    void AddRequest(uint64_t hostKey, double currentTime);
+    bool GetLatency(uint64_t hostKey, double *latency) const; // false if there is no estimate for this host
+    double GetThroughput(uint64_t hostKey, double currentTime) const;
+    double GetMeanLatency() const;
+    size_t GetPrefetchTarget(uint64_t hostKey, double leaseDuration, double currentTime) const; // at least 1
+    void Clear() { m_hosts.clear(); }
+    void Prune(double olderThan); // forgets hosts that have not been seen since this time
+
+    void SetLatencySmoothing(double latencySmoothing) { m_latencySmoothing = latencySmoothing; }
+    void SetThroughputTimeConstant(double throughputTimeConstant) { m_throughputTimeConstant = throughputTimeConstant; }
+
+    size_t GetHostCount() const { return m_hosts.size(); }
+    size_t GetActiveHostCount(double since) const; // distinct IP addresses that have asked for work or returned a score since this time
+    const std::unordered_map<uint64_t, Host> &GetHosts() const { return m_hosts; }
+
+private:
+    std::unordered_map<uint64_t, Host> m_hosts;
+    mutable std::unordered_set<uint32_t> m_activeIPs; // reused by GetActiveHostCount
+    double m_latencySmoothing = 0.2;
+    double m_throughputTimeConstant = 300;
+};
+
+#endif // HOSTSTATISTICS_H
@@ -0,0 +1,42 @@
+#include "LatencyTracker.h"
+
+#include <algorithm>
+
+LatencyTracker::LatencyTracker(size_t windowSize)
+{
+    m_samples.resize(std::max(windowSize, size_t(1)));
+    m_sorted.reserve(m_samples.size());
+}
+
+void LatencyTracker::AddSample(double value)
+{
+    m_samples[m_next] = value;
+    m_next = (m_next + 1) % m_samples.size();
+    if (m_count < m_samples.size()) m_count++;
+    m_totalSamples++;
+    m_sortedValid = false;
+}
+
+double LatencyTracker::GetQuantile(double quantile)
+{
+    if (m_count == 0) return 0;
+    if (!m_sortedValid)
+    {
+        m_sorted.assign(m_samples.begin(), m_samples.begin() + m_count);
+        std::sort(m_sorted.begin(), m_sorted.end());
+        m_sortedValid = true;
+    }
+    double position = std::clamp(quantile, 0.0, 1.0) * double(m_count - 1);
+    size_t lower = size_t(position);
+    size_t upper = std::min(lower + 1, m_count - 1);
+    double fraction = position - double(lower);
+    return m_sorted[lower] + fraction * (m_sorted[upper] - m_sorted[lower]);
+}
+
+void LatencyTracker::Clear()
+{
+    m_next = 0;
+    m_count = 0;
+    m_totalSamples = 0;
+    m_sortedValid = false;
+}
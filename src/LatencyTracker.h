@@ -0,0 +1,32 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <vector>
+#include <cstddef>
+
+// keeps the most recent durations in a ring buffer so that quantiles of the recent distribution can be estimated
+// the sorted copy is only rebuilt when a quantile is requested after new samples have arrived
+
+class LatencyTracker
+{
+public:
+    LatencyTracker(size_t windowSize = 1000);
+
+    void AddSample(double value);
+    double GetQuantile(double quantile); // linear interpolation between the order statistics, 0 if there are no samples
+    void Clear();
+
+    size_t GetSampleCount() const { return m_count; }
+    size_t GetWindowSize() const { return m_samples.size(); }
+    size_t GetTotalSamples() const { return m_totalSamples; }
+
+private:
+    std::vector<double> m_samples;
+    std::vector<double> m_sorted;
+    size_t m_next = 0;
+    size_t m_count = 0;
+    size_t m_totalSamples = 0;
+    bool m_sortedValid = false;
+};
+
+#endif // LATENCYTRACKER_H
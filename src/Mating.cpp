@@ -12,7 +12,7 @@
 #include "Genome.h"
 
 #include <cmath>
-#include <memory>
+#include <cstring>
 
 Mating::Mating(Random *random)
 {
@@ -22,7 +22,7 @@ Mating::Mating(Random *random)
 
 // mate two parents producing an offspring
 // some crossover *ALWAYS* occurs
-int Mating::Mate(Genome *parent1, Genome *parent2, Genome *offspring, Mating::CrossoverType type)
+int Mating::Mate(const Genome *parent1, const Genome *parent2, Genome *offspring, Mating::CrossoverType type)
 {
 
     int i;
@@ -219,7 +219,6 @@ int Mating::MultipleGaussianMutate(Genome *genome, double mutationChance, bool b
 // mutate an individual by inserting or deleting a gene
 int Mating::FrameShiftMutate(Genome *genome, double mutationChance)
 {
-    int i;
     int location;
     int genomeLength = genome->GetGenomeLength();
 
@@ -230,18 +229,18 @@ int Mating::FrameShiftMutate(Genome *genome, double mutationChance)
     }
 
     // insertion/deletion
+    // these are overlapping block moves so use memmove
+    double *genes = genome->GetGenes()->data();
     location = m_random->RandomInt(0, genomeLength - 1);
     if (m_random->CoinFlip(0.5))
     {
         // deletion
-        for (i = location; i < genomeLength - 1; i++)
-            genome->SetGene(i, genome->GetGene(i + 1));
+        if (location < genomeLength - 1) std::memmove(genes + location, genes + location + 1, size_t(genomeLength - 1 - location) * sizeof(double));
     }
     else
     {
         // insertion
-        for (i = genomeLength - 2; i >= location; i--)
-            genome->SetGene(i + 1, genome->GetGene(i));
+        if (location < genomeLength - 1) std::memmove(genes + location + 1, genes + location, size_t(genomeLength - 1 - location) * sizeof(double));
     }
     return 1;
 }
@@ -250,7 +249,6 @@ int Mating::FrameShiftMutate(Genome *genome, double mutationChance)
 // random location
 int Mating::DuplicationMutate(Genome *genome, double mutationChance)
 {
-    int i;
     int genomeLength = genome->GetGenomeLength();
     int origin;
     int length;
@@ -267,19 +265,12 @@ int Mating::DuplicationMutate(Genome *genome, double mutationChance)
     if (genomeLength - origin == 1) length = 1;
     else length = m_random->RandomInt(1, genomeLength - origin);
 
-    // make a copy
-    std::unique_ptr<double[]> store = std::make_unique<double[]>(length);
-    for (i = 0; i < length; i++)
-        store[i] = genome->GetGene(origin + i);
-
-    // and write the copy into the genome
+    // and write a copy into the genome truncating at the end of the genome
+    // memmove copes with the overlap exactly as if the segment had been copied to a temporary store first
     insertion = m_random->RandomInt(0, genomeLength - 1);
-    for (i = 0; i < length; i++)
-    {
-        genome->SetGene(insertion, store[i]);
-        insertion++;
-        if (insertion >= genomeLength) break;
-    }
+    if (insertion + length > genomeLength) length = genomeLength - insertion;
+    double *genes = genome->GetGenes()->data();
+    std::memmove(genes + insertion, genes + origin, size_t(length) * sizeof(double));
 
     return 1;
 }
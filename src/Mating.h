@@ -26,7 +26,7 @@ class Mating
     };
 
     void SetRandom(Random *random);
-    int Mate(Genome *parent1, Genome *parent2, Genome *offspring, CrossoverType type);
+    int Mate(const Genome *parent1, const Genome *parent2, Genome *offspring, CrossoverType type);
     int GaussianMutate(Genome *genome, double mutationChance, bool bounceMutation);
     int MultipleGaussianMutate(Genome *genome, double mutationChance, bool bounceMutation);
     int FrameShiftMutate(Genome *genome, double mutationChance);
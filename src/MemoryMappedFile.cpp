@@ -0,0 +1,116 @@
+#include "MemoryMappedFile.h"
+#include "DataFile.h"
+
+#include <iostream>
+
+#if defined(WIN32) || defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile()
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    Close();
+}
+
+#if defined(WIN32) || defined(_WIN32)
+
+int MemoryMappedFile::Open(const std::string &filename, size_t size, bool readOnly)
+{
+    Close();
+    std::wstring wideFilename = DataFile::ConvertUTF8ToWide(filename);
+    HANDLE fileHandle = CreateFileW(wideFilename.c_str(), readOnly ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE), FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                    nullptr, readOnly ? OPEN_EXISTING : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) return __LINE__;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) { CloseHandle(fileHandle); return __LINE__; }
+    size_t mapSize = size_t(fileSize.QuadPart);
+    if (!readOnly && size > mapSize) mapSize = size;
+    if (mapSize == 0) { CloseHandle(fileHandle); return __LINE__; }
+    LARGE_INTEGER mapSizeLarge;
+    mapSizeLarge.QuadPart = LONGLONG(mapSize);
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, readOnly ? PAGE_READONLY : PAGE_READWRITE, DWORD(mapSizeLarge.HighPart), mapSizeLarge.LowPart, nullptr);
+    if (mappingHandle == nullptr) { CloseHandle(fileHandle); return __LINE__; }
+    void *data = MapViewOfFile(mappingHandle, readOnly ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, mapSize);
+    if (data == nullptr) { CloseHandle(mappingHandle); CloseHandle(fileHandle); return __LINE__; }
+    m_fileHandle = fileHandle;
+    m_mappingHandle = mappingHandle;
+    m_data = static_cast<char *>(data);
+    m_size = mapSize;
+    m_readOnly = readOnly;
+    m_filename = filename;
+    return 0;
+}
+
+int MemoryMappedFile::Flush()
+{
+    if (!m_data || m_readOnly) return 0;
+    if (!FlushViewOfFile(m_data, m_size)) return __LINE__;
+    if (!FlushFileBuffers(m_fileHandle)) return __LINE__;
+    return 0;
+}
+
+void MemoryMappedFile::Close()
+{
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mappingHandle) CloseHandle(m_mappingHandle);
+    if (m_fileHandle) CloseHandle(m_fileHandle);
+    m_data = nullptr;
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+    m_size = 0;
+    m_filename.clear();
+}
+
+#else
+
+int MemoryMappedFile::Open(const std::string &filename, size_t size, bool readOnly)
+{
+    Close();
+    int fileDescriptor = open(filename.c_str(), readOnly ? O_RDONLY : (O_RDWR | O_CREAT), 0644);
+    if (fileDescriptor == -1) return __LINE__;
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) == -1) { close(fileDescriptor); return __LINE__; }
+    size_t mapSize = size_t(fileStat.st_size);
+    if (!readOnly && size > mapSize)
+    {
+        if (ftruncate(fileDescriptor, off_t(size)) == -1) { close(fileDescriptor); return __LINE__; }
+        mapSize = size;
+    }
+    if (mapSize == 0) { close(fileDescriptor); return __LINE__; }
+    void *data = mmap(nullptr, mapSize, readOnly ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fileDescriptor, 0);
+    if (data == MAP_FAILED) { close(fileDescriptor); return __LINE__; }
+    m_fileDescriptor = fileDescriptor;
+    m_data = static_cast<char *>(data);
+    m_size = mapSize;
+    m_readOnly = readOnly;
+    m_filename = filename;
+    return 0;
+}
+
+int MemoryMappedFile::Flush()
+{
+    if (!m_data || m_readOnly) return 0;
+    if (msync(m_data, m_size, MS_SYNC) == -1) return __LINE__;
+    return 0;
+}
+
+void MemoryMappedFile::Close()
+{
+    if (m_data) munmap(m_data, m_size);
+    if (m_fileDescriptor != -1) close(m_fileDescriptor);
+    m_data = nullptr;
+    m_fileDescriptor = -1;
+    m_size = 0;
+    m_filename.clear();
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MEMORYMAPPEDFILE_H
+#define MEMORYMAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+// simple cross platform wrapper for a memory mapped file
+// the whole file is mapped and the functions return 0 on success and __LINE__ on error
+
+class MemoryMappedFile
+{
+public:
+    MemoryMappedFile();
+    ~MemoryMappedFile();
+
+    MemoryMappedFile(const MemoryMappedFile &) = delete;
+    MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+
+    // if readOnly is false the file is created if necessary and extended to at least size bytes
+    // if size is zero then the existing file size is used
+    int Open(const std::string &filename, size_t size, bool readOnly);
+    int Flush();
+    void Close();
+
+    char *GetData() { return m_data; }
+    const char *GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+    bool IsOpen() const { return m_data != nullptr; }
+    bool IsReadOnly() const { return m_readOnly; }
+    std::string GetFilename() const { return m_filename; }
+
+private:
+    char *m_data = nullptr;
+    size_t m_size = 0;
+    bool m_readOnly = true;
+    std::string m_filename;
+#if defined(WIN32) || defined(_WIN32)
+    void *m_fileHandle = nullptr;
+    void *m_mappingHandle = nullptr;
+#else
+    int m_fileDescriptor = -1;
+#endif
+};
+
+#endif // MEMORYMAPPEDFILE_H
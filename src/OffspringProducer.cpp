@@ -0,0 +1,168 @@
+#include "OffspringProducer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+OffspringProducer::~OffspringProducer()
+{
+    Stop();
+}
+
+void OffspringProducer::Start(const std::string &name, size_t capacity, const std::shared_ptr<GenomePool> &genomePool)
+{
+    Stop();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_name = name;
+    m_capacity = std::max(capacity, size_t(1));
+    m_genomePool = genomePool;
+    m_pendingValid = false;
+    m_parentsValid = false;
+    m_stopping = false;
+    m_running = true;
+    m_produced = 0;
+    m_taken = 0;
+    m_misses = 0;
+    m_published = 0;
+    m_thread = std::thread(&OffspringProducer::Run, this);
+}
+
+void OffspringProducer::Stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (auto &&offspring : m_ready) m_genomePool->Release(std::move(offspring.genome));
+    m_ready.clear();
+    // the copies hold the genomes of the population so they are let go of now rather than when the producer is next used
+    m_parents.Clear();
+    m_pending.Clear();
+    m_pendingValid = false;
+    m_parentsValid = false;
+    m_running = false;
+}
+
+bool OffspringProducer::Publish(const Population &population)
+{
+    if (population.GetPopulationSize() == 0)
+    {
+        Clear(); // nothing to breed from until there is a population again
+        return true;
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running) return true;
+        if (m_pendingValid) return false;
+        m_pending = population;
+        m_pendingValid = true;
+    }
+    m_workAvailable.notify_one();
+    return true;
+}
+
+bool OffspringProducer::Take(std::unique_ptr<Genome> *offspring, std::array<int32_t, 2> *parentRanks)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_ready.empty())
+        {
+            if (m_running) m_misses++;
+            return false;
+        }
+        m_genomePool->Release(std::move(*offspring));
+        *offspring = std::move(m_ready.front().genome);
+        *parentRanks = m_ready.front().parentRanks;
+        m_ready.pop_front();
+        m_taken++;
+    }
+    m_workAvailable.notify_one();
+    return true;
+}
+
+void OffspringProducer::Clear()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running) return;
+    for (auto &&offspring : m_ready) m_genomePool->Release(std::move(offspring.genome));
+    m_ready.clear();
+    m_pendingValid = false;
+    m_parentsValid = false; // the copy itself is replaced on the producer thread when the next one is published
+    m_generation++;
+}
+
+size_t OffspringProducer::GetDepth()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_ready.size();
+}
+
+uint64_t OffspringProducer::GetProduced()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_produced;
+}
+
+uint64_t OffspringProducer::GetTaken()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_taken;
+}
+
+uint64_t OffspringProducer::GetMisses()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+uint64_t OffspringProducer::GetPublished()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_published;
+}
+
+std::string OffspringProducer::GetStatusString()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "%s depth %zu of %zu produced %" PRIu64 " taken %" PRIu64 " misses %" PRIu64 " populations %" PRIu64,
+                  m_name.c_str(), m_ready.size(), m_capacity, m_produced, m_taken, m_misses, m_published);
+    return buffer;
+}
+
+void OffspringProducer::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_workAvailable.wait(lock, [this]() { return m_stopping || m_pendingValid || (m_parentsValid && m_ready.size() < m_capacity); });
+        if (m_stopping) break;
+        if (m_pendingValid)
+        {
+            // swapping keeps the storage of both copies so that the next publish can reuse it
+            std::swap(m_parents, m_pending);
+            m_pendingValid = false;
+            m_parentsValid = true;
+            m_published++;
+            continue;
+        }
+        // the parents are only replaced on this thread so they can be bred from without the lock
+        uint64_t generation = m_generation;
+        lock.unlock();
+        Offspring offspring;
+        offspring.genome = m_genomePool->Acquire();
+        m_parents.GetOffspring(offspring.genome.get(), &offspring.parentRanks, &m_random);
+        lock.lock();
+        if (generation != m_generation || !m_parentsValid)
+        {
+            m_genomePool->Release(std::move(offspring.genome));
+            continue;
+        }
+        m_ready.push_back(std::move(offspring));
+        m_produced++;
+    }
+}
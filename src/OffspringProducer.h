@@ -0,0 +1,97 @@
+#ifndef OFFSPRINGPRODUCER_H
+#define OFFSPRINGPRODUCER_H
+
+#include "Population.h"
+#include "Random.h"
+#include "GenomePool.h"
+
+#include <string>
+#include <deque>
+#include <array>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// breeds offspring on its own thread so that mating and mutation are taken off the evolve loop
+// the thread that owns the population is the only one that changes it and it publishes a copy after each change. The copy
+// shares the genomes, which the population never changes in place while they are shared, and the producer breeds from the
+// latest copy it has picked up with its own random number generator, so offspring can be a few insertions behind.
+// Ready offspring wait in a bounded queue and when it is empty the caller breeds its own rather than waiting.
+
+class OffspringProducer
+{
+public:
+    OffspringProducer() = default;
+    ~OffspringProducer();
+
+    OffspringProducer(const OffspringProducer &) = delete;
+    OffspringProducer &operator=(const OffspringProducer &) = delete;
+
+    void Start(const std::string &name, size_t capacity, const std::shared_ptr<GenomePool> &genomePool);
+    void Stop(); // the ready offspring go back to the genome pool
+
+    // returns false without copying if the last copy has not been picked up yet so the caller should try again later
+    bool Publish(const Population &population);
+    bool Take(std::unique_ptr<Genome> *offspring, std::array<int32_t, 2> *parentRanks); // false if nothing is ready
+    void Clear(); // discards the ready offspring and the parents when the population is replaced
+
+    bool IsRunning() const { return m_running; }
+    const std::string &GetName() const { return m_name; }
+    size_t GetCapacity() const { return m_capacity; }
+    size_t GetDepth();
+    uint64_t GetProduced();
+    uint64_t GetTaken();
+    uint64_t GetMisses(); // takes that found nothing ready
+    uint64_t GetPublished(); // copies of the population picked up by the producer
+    std::string GetStatusString();
+
+private:
+    struct Offspring
+    {
+        std::unique_ptr<Genome> genome;
+        std::array<int32_t, 2> parentRanks;
+    };
+
+    void Run();
+
+    std::string m_name;
+    size_t m_capacity = 0;
+    std::shared_ptr<GenomePool> m_genomePool;
+    Population m_parents; // only used by the producer thread
+    Population m_pending; // the latest published copy, reused so that publishing does not allocate once it has grown
+    bool m_pendingValid = false;
+    bool m_parentsValid = false;
+    uint64_t m_generation = 0; // changed by Clear so that an offspring bred from the old parents is not kept
+    Random m_random;
+    std::deque<Offspring> m_ready;
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::thread m_thread;
+    std::atomic<bool> m_running = false; // also read without the lock by IsRunning
+    bool m_stopping = false;
+    uint64_t m_produced = 0;
+    uint64_t m_taken = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_published = 0;
+};
+
+class StopOffspringProducerGuard
+{
+public:
+    StopOffspringProducerGuard(OffspringProducer *offspringProducer)
+    {
+        m_offspringProducer = offspringProducer;
+    }
+    ~StopOffspringProducerGuard()
+    {
+        if (m_offspringProducer) m_offspringProducer->Stop();
+    }
+private:
+    OffspringProducer *m_offspringProducer = nullptr;
+};
+
+#endif // OFFSPRINGPRODUCER_H
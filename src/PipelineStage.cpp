@@ -0,0 +1,163 @@
+#include "PipelineStage.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+PipelineStage::~PipelineStage()
+{
+    Stop();
+}
+
+void PipelineStage::Start(const std::string &name, size_t capacity)
+{
+    Stop();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_name = name;
+    m_capacity = std::max(capacity, size_t(1));
+    m_stopping = false;
+    m_running = true;
+    m_maxDepth = 0;
+    m_processed = 0;
+    m_stalls = 0;
+    m_drops = 0;
+    m_replaced = 0;
+    m_thread = std::thread(&PipelineStage::Run, this);
+}
+
+void PipelineStage::Stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_running = false;
+}
+
+void PipelineStage::Flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running) return;
+    m_spaceAvailable.wait(lock, [this]() { return (m_queue.empty() && !m_busy) || !m_running; });
+}
+
+bool PipelineStage::Push(std::function<void ()> &&job, bool wait)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running || m_stopping) return false;
+        if (m_queue.size() >= m_capacity)
+        {
+            if (!wait)
+            {
+                m_drops++;
+                return false;
+            }
+            m_stalls++;
+            m_spaceAvailable.wait(lock, [this]() { return m_queue.size() < m_capacity; });
+        }
+        m_queue.push_back({std::move(job), 0});
+        m_maxDepth = std::max(m_maxDepth, m_queue.size());
+    }
+    m_jobAvailable.notify_one();
+    return true;
+}
+
+bool PipelineStage::PushLatest(uint32_t key, std::function<void ()> &&job)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running || m_stopping) return false;
+        auto queued = std::find_if(m_queue.begin(), m_queue.end(), [key](const Job &item) { return item.key == key && key != 0; });
+        if (queued != m_queue.end())
+        {
+            // the job keeps the place of the one it replaces so there is nothing new for the thread to pick up
+            queued->function = std::move(job);
+            m_replaced++;
+            return true;
+        }
+        if (m_queue.size() >= m_capacity)
+        {
+            m_drops++;
+            return false;
+        }
+        m_queue.push_back({std::move(job), key});
+        m_maxDepth = std::max(m_maxDepth, m_queue.size());
+    }
+    m_jobAvailable.notify_one();
+    return true;
+}
+
+size_t PipelineStage::GetDepth()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_queue.size();
+}
+
+size_t PipelineStage::GetMaxDepth()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_maxDepth;
+}
+
+uint64_t PipelineStage::GetProcessed()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_processed;
+}
+
+uint64_t PipelineStage::GetStalls()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_stalls;
+}
+
+uint64_t PipelineStage::GetDrops()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_drops;
+}
+
+uint64_t PipelineStage::GetReplaced()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_replaced;
+}
+
+std::string PipelineStage::GetStatusString()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "%s depth %zu max %zu of %zu processed %" PRIu64 " stalls %" PRIu64 " drops %" PRIu64 " replaced %" PRIu64,
+                  m_name.c_str(), m_queue.size(), m_maxDepth, m_capacity, m_processed, m_stalls, m_drops, m_replaced);
+    return buffer;
+}
+
+void PipelineStage::Run()
+{
+    while (true)
+    {
+        std::function<void ()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty()) break; // only reached when stopping
+            job = std::move(m_queue.front().function);
+            m_queue.pop_front();
+            m_busy = true;
+        }
+        m_spaceAvailable.notify_all();
+        job();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_busy = false;
+            m_processed++;
+        }
+        m_spaceAvailable.notify_all();
+    }
+    m_spaceAvailable.notify_all();
+}
@@ -0,0 +1,92 @@
+#ifndef PIPELINESTAGE_H
+#define PIPELINESTAGE_H
+
+#include <string>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// runs jobs in order on its own thread so that slow work such as file output is taken off the evolve loop
+// the queue is bounded so that a stage that cannot keep up pushes back on its producer rather than using unlimited memory
+// a job gets everything it needs when it is pushed so that it never touches state that the producer is still changing
+// jobs that only need the latest version of something written can be given a key so that a newer job replaces a queued
+// one with the same key instead of waiting behind it, and then the producer never has to wait at all
+
+class PipelineStage
+{
+public:
+    PipelineStage() = default;
+    ~PipelineStage();
+
+    PipelineStage(const PipelineStage &) = delete;
+    PipelineStage &operator=(const PipelineStage &) = delete;
+
+    void Start(const std::string &name, size_t capacity);
+    void Stop(); // runs everything that is still queued and then joins the thread
+    void Flush(); // waits until everything pushed so far has run
+
+    // returns false if the stage is not running so that the caller can do the job itself
+    // when the queue is full this waits for space if wait is true, otherwise the job is dropped and false is returned
+    bool Push(std::function<void ()> &&job, bool wait = true);
+    // never waits - replaces a queued job with the same key that has not started yet, otherwise it is added to the queue
+    // or dropped if the queue is full. Returns false if the job was dropped or the stage is not running
+    bool PushLatest(uint32_t key, std::function<void ()> &&job);
+
+    bool IsRunning() const { return m_running; }
+    const std::string &GetName() const { return m_name; }
+    size_t GetCapacity() const { return m_capacity; }
+    size_t GetDepth();
+    size_t GetMaxDepth();
+    uint64_t GetProcessed();
+    uint64_t GetStalls(); // pushes that had to wait for space
+    uint64_t GetDrops();
+    uint64_t GetReplaced(); // queued jobs replaced by a newer job with the same key
+    std::string GetStatusString();
+
+private:
+    struct Job
+    {
+        std::function<void ()> function;
+        uint32_t key = 0; // zero is never replaced
+    };
+
+    void Run();
+
+    std::string m_name;
+    size_t m_capacity = 0;
+    std::deque<Job> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_spaceAvailable;
+    std::thread m_thread;
+    std::atomic<bool> m_running = false; // also read without the lock by IsRunning
+    bool m_stopping = false;
+    bool m_busy = false;
+    size_t m_maxDepth = 0;
+    uint64_t m_processed = 0;
+    uint64_t m_stalls = 0;
+    uint64_t m_drops = 0;
+    uint64_t m_replaced = 0;
+};
+
+class StopPipelineStageGuard
+{
+public:
+    StopPipelineStageGuard(PipelineStage *pipelineStage)
+    {
+        m_pipelineStage = pipelineStage;
+    }
+    ~StopPipelineStageGuard()
+    {
+        if (m_pipelineStage) m_pipelineStage->Stop();
+    }
+private:
+    PipelineStage *m_pipelineStage = nullptr;
+};
+
+#endif // PIPELINESTAGE_H
@@ -11,6 +11,10 @@
 #include "Population.h"
 #include "Random.h"
 #include "Mating.h"
+#include "Checkpoint.h"
+#include "BinaryPopulationFile.h"
+#include "PopulationDelta.h"
+#include "MemoryMappedFile.h"
 
 #include <iostream>
 #include <fstream>
@@ -18,6 +22,37 @@
 #include <cmath>
 #include <limits>
 #include <algorithm>
+#include <unordered_map>
+#include <filesystem>
+#include <system_error>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <thread>
+
+static const size_t s_textBatchBytes = size_t(16) << 20; // roughly how much text each thread formats or parses at a time
+
+static const char *SkipSpace(const char *ptr, const char *last)
+{
+    while (ptr < last && (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r' || *ptr == '\v' || *ptr == '\f')) ptr++;
+    return ptr;
+}
+
+// runs work(begin, end) on slices of [0, count) using the hardware threads, or on this thread when there is little to do
+static void ParallelFor(size_t count, size_t minimumPerThread, const std::function<void (size_t begin, size_t end)> &work)
+{
+    size_t threadCount = std::min(size_t(std::max(std::thread::hardware_concurrency(), 1u)), std::max(count / std::max(minimumPerThread, size_t(1)), size_t(1)));
+    if (threadCount <= 1)
+    {
+        work(0, count);
+        return;
+    }
+    std::vector<std::thread> threads;
+    size_t sliceSize = (count + threadCount - 1) / threadCount;
+    for (size_t begin = sliceSize; begin < count; begin += sliceSize) threads.emplace_back(work, begin, std::min(begin + sliceSize, count));
+    work(0, std::min(sliceSize, count));
+    for (auto &&thread : threads) thread.join();
+}
 
 //#define DEBUG_POPULATION
 
@@ -79,27 +114,32 @@ Population::Population()
 }
 
 // choose a parent from a population
-Genome *Population::ChooseParent(size_t *parentRank)
+const Genome *Population::ChooseParent(size_t *parentRank)
+{
+    return ChooseParent(parentRank, &m_random);
+}
+
+const Genome *Population::ChooseParent(size_t *parentRank, Random *random) const
 {
     switch(m_selectionType)
     {
     // this type biases random choice to higher ranked individuals using the gamma function
     // this assumes a sorted genome
     case GammaBasedSelection:
-        *parentRank = size_t(m_random.GammaBiasedRandomInt(0, int(m_population.size() - 1), m_gamma));
+        *parentRank = size_t(random->GammaBiasedRandomInt(0, int(m_population.size() - 1), m_gamma));
         return m_population[*parentRank].get();
 
     // in this version we do uniform selection and just choose a parent
     // at random
     case UniformSelection:
-        *parentRank = size_t(m_random.RandomInt(0, int(m_population.size() - 1)));
+        *parentRank = size_t(random->RandomInt(0, int(m_population.size() - 1)));
         return m_population[*parentRank].get();
 
     // this type biases random choice to higher ranked individuals
     // this assumes a sorted genome
     // note - the distribution is the same as the old RankBasedSelection
     case SqrtBasedSelection:
-        *parentRank = size_t(m_random.SqrtBiasedRandomInt(0, int(m_population.size() - 1)));
+        *parentRank = size_t(random->SqrtBiasedRandomInt(0, int(m_population.size() - 1)));
         return m_population[*parentRank].get();
     }
     return nullptr;
@@ -112,13 +152,18 @@ Genome *Population::ChooseParent(size_t *parentRank)
 // the key is the numeric value of the fitness so there are rare cases when
 // different genomes with the same fitness will not be accepted
 int Population::InsertGenome(std::unique_ptr<Genome> genome, size_t targetPopulationSize)
+{
+    return InsertGenome(Share(std::move(genome)), targetPopulationSize);
+}
+
+int Population::InsertGenome(std::shared_ptr<Genome> genome, size_t targetPopulationSize)
 {
     size_t originalSize = m_population.size();
     if (targetPopulationSize == 0) targetPopulationSize = originalSize; // not trying to change the size of the population
 
-    std::vector<std::unique_ptr<Genome>>::iterator iter;
-    if (m_minimizeScore) { iter = std::lower_bound(m_population.begin(), m_population.end(), genome, [](const std::unique_ptr<Genome> &lhs, const std::unique_ptr<Genome> &rhs) -> bool { return lhs->GetFitness() > rhs->GetFitness(); }); }
-    else { iter = std::lower_bound(m_population.begin(), m_population.end(), genome, [](const std::unique_ptr<Genome> &lhs, const std::unique_ptr<Genome> &rhs) -> bool { return lhs->GetFitness() < rhs->GetFitness(); }); }
+    std::vector<std::shared_ptr<Genome>>::iterator iter;
+    if (m_minimizeScore) { iter = std::lower_bound(m_population.begin(), m_population.end(), genome.get(), [](const std::shared_ptr<Genome> &lhs, const Genome *rhs) -> bool { return lhs->GetFitness() > rhs->GetFitness(); }); }
+    else { iter = std::lower_bound(m_population.begin(), m_population.end(), genome.get(), [](const std::shared_ptr<Genome> &lhs, const Genome *rhs) -> bool { return lhs->GetFitness() < rhs->GetFitness(); }); }
     // lower_bound
     // if a searching element exists: std::lower_bound() returns iterator to the element itself
     if (iter != m_population.end() && iter->get()->GetFitness() == genome->GetFitness())
@@ -242,9 +287,9 @@ int Population::InsertGenome(std::unique_ptr<Genome> genome, size_t targetPopula
         std::cerr << "InsertGenome reducing m_ageList size; size=" << m_ageList.size() << "\n";
 #endif
 
-        std::vector<std::unique_ptr<Genome>>::iterator iter3;
-        if (m_minimizeScore) { iter3 = std::lower_bound(m_population.begin(), m_population.end(), genomeToDelete, [](const std::unique_ptr<Genome> &lhs, const Genome *rhs) -> bool { return lhs->GetFitness() > rhs->GetFitness(); }); }
-        else { iter3 = std::lower_bound(m_population.begin(), m_population.end(), genomeToDelete, [](const std::unique_ptr<Genome> &lhs, const Genome *rhs) -> bool { return lhs->GetFitness() < rhs->GetFitness(); }); }
+        std::vector<std::shared_ptr<Genome>>::iterator iter3;
+        if (m_minimizeScore) { iter3 = std::lower_bound(m_population.begin(), m_population.end(), genomeToDelete, [](const std::shared_ptr<Genome> &lhs, const Genome *rhs) -> bool { return lhs->GetFitness() > rhs->GetFitness(); }); }
+        else { iter3 = std::lower_bound(m_population.begin(), m_population.end(), genomeToDelete, [](const std::shared_ptr<Genome> &lhs, const Genome *rhs) -> bool { return lhs->GetFitness() < rhs->GetFitness(); }); }
         // lower_bound
         // if a searching element exists: std::lower_bound() returns iterator to the element itself
         if (*iter3 && (*iter3)->GetFitness() == genomeToDelete->GetFitness())
@@ -273,7 +318,33 @@ int Population::InsertGenome(std::unique_ptr<Genome> genome, size_t targetPopula
 // randomise the population
 void Population::Randomise()
 {
-    for (auto &&iter : m_population) (*iter).Randomise(&m_random);
+    for (size_t i = 0; i < m_population.size(); i++) GetUnsharedGenome(i)->Randomise(&m_random);
+}
+
+// remove the genome with matching genes from the population and the internal lists
+// the search starts from the best end because this is used for re-evaluating the elite
+std::shared_ptr<const Genome> Population::RemoveGenome(const std::vector<double> &genes)
+{
+    for (size_t i = m_population.size(); i > 0; i--)
+    {
+        if (*m_population[i - 1]->GetGenes() != genes) continue;
+        std::shared_ptr<const Genome> genome = std::move(m_population[i - 1]);
+        m_population.erase(m_population.begin() + ptrdiff_t(i - 1));
+        auto immortalIter = std::find(m_immortalList.begin(), m_immortalList.end(), genome.get());
+        if (immortalIter != m_immortalList.end()) m_immortalList.erase(immortalIter);
+        auto ageIter = std::find(m_ageList.begin(), m_ageList.end(), genome.get());
+        if (ageIter != m_ageList.end()) m_ageList.erase(ageIter);
+        return genome;
+    }
+    return nullptr;
+}
+
+// remove all the genomes so that the population can be filled again
+void Population::Clear()
+{
+    m_population.clear();
+    m_immortalList.clear();
+    m_ageList.clear();
 }
 
 // reset the population size to a new value - needs at least one valid genome in population
@@ -290,6 +361,7 @@ void Population::ResizePopulation(size_t size)
             for (size_t i = m_population.size(); i < size; i++)
             {
                 auto g = std::make_unique<Genome>(*ChooseParent(&parentRank));
+                g->SetParents(m_population[parentRank]);
                 g->Randomise(&m_random);
                 if (m_minimizeScore) {g->SetFitness(std::nextafter(m_population.front()->GetFitness(), std::numeric_limits<double>::max()));}
                 else { g->SetFitness(std::nextafter(m_population.front()->GetFitness(), -std::numeric_limits<double>::max())); }
@@ -302,6 +374,7 @@ void Population::ResizePopulation(size_t size)
             for (size_t i = m_population.size(); i < size; i++)
             {
                 auto g = std::make_unique<Genome>(*ChooseParent(&parentRank));
+                g->SetParents(m_population[parentRank]);
                 Mating mating(&m_random);
                 int mutationCount = 0;
                 while (mutationCount == 0)
@@ -320,13 +393,13 @@ void Population::ResizePopulation(size_t size)
     else
     {
         size_t delta = m_population.size() - size;
-        std::vector<std::unique_ptr<Genome>> population;
+        std::vector<std::shared_ptr<Genome>> population;
         std::swap(population, m_population);
         m_immortalList.clear();
         m_ageList.clear();
         for (size_t i = 0; i < size; i++)
         {
-            InsertGenome(std::move(population[delta + size]), size);
+            InsertGenome(std::move(population[delta + i]), size);
         }
     }
 }
@@ -334,72 +407,259 @@ void Population::ResizePopulation(size_t size)
 // set the circular flags for the genomes in the population
 void Population::SetGlobalCircularMutation(bool circularMutation)
 {
-    for (auto &&iter : m_population) { iter->SetGlobalCircularMutationFlag(circularMutation); }
+    for (size_t i = 0; i < m_population.size(); i++)
+    {
+        if (m_population[i]->GetGlobalCircularMutationFlag() != circularMutation) GetUnsharedGenome(i)->SetGlobalCircularMutationFlag(circularMutation);
+    }
+}
+
+// the fittest genomes first without copying them
+// the population does not change a genome in place while a snapshot still holds it (see GetUnsharedGenome)
+// so a snapshot stays consistent however long it is kept
+std::vector<std::shared_ptr<const Genome>> Population::GetSnapshot(size_t nBest) const
+{
+    if (nBest > m_population.size()) nBest = m_population.size();
+    std::vector<std::shared_ptr<const Genome>> snapshot;
+    snapshot.reserve(nBest);
+    for (auto iter = m_population.rbegin(); iter != m_population.rbegin() + ptrdiff_t(nBest); ++iter) snapshot.push_back(*iter);
+    return snapshot;
+}
+
+// copy on write: a genome that is also held by a snapshot is replaced by a private copy before it is changed
+Genome *Population::GetUnsharedGenome(size_t i)
+{
+    if (m_population[i].use_count() > 1)
+    {
+        std::shared_ptr<Genome> shared = m_population[i];
+        m_population[i] = Share(std::make_unique<Genome>(*shared)); // not make_shared because the parent link would keep the whole allocation alive
+        m_population[i]->SetParents(shared);
+        std::replace(m_immortalList.begin(), m_immortalList.end(), shared.get(), m_population[i].get());
+        std::replace(m_ageList.begin(), m_ageList.end(), shared.get(), m_population[i].get());
+    }
+    return m_population[i].get();
+}
+
+// without a pool this allocates the control block as the shared_ptr conversion would
+std::shared_ptr<Genome> Population::Share(std::unique_ptr<Genome> genome)
+{
+    if (m_genomePool) return m_genomePool->Share(std::move(genome));
+    return std::shared_ptr<Genome>(std::move(genome));
 }
 
 // output a subpopulation as a new population
 // note: outputs population with fittest first
 int Population::WritePopulation(const char *filename, size_t nBest)
 {
-    if (nBest > m_population.size()) nBest = m_population.size();
+    return WriteGenomes(filename, GetSnapshot(nBest));
+}
 
+// write a snapshot in the same format as WritePopulation
+// the file is written under a temporary name and then renamed so a reader never sees a partly written population
+int Population::WriteGenomes(const char *filename, const std::vector<std::shared_ptr<const Genome>> &genomes)
+{
+    std::string temporaryFilename = std::string(filename) + ".tmp";
     try
     {
         std::ofstream outFile;
         outFile.exceptions (std::ios::failbit|std::ios::badbit);
-        outFile.open(filename);
-        outFile << nBest << "\n";
-        size_t count = 0;
-        for (auto iter = m_population.rbegin(); iter != m_population.rend(); ++iter)
+        outFile.open(temporaryFilename);
+        outFile << genomes.size() << "\n";
+        // the text is formatted in parallel a batch at a time and then written in order
+        size_t genomeLength = genomes.size() ? genomes.front()->GetGenomeLength() : 0;
+        size_t batchSize = std::max(size_t(std::thread::hardware_concurrency()) * 16, s_textBatchBytes / (64 + 96 * genomeLength));
+        for (size_t batchStart = 0; batchStart < genomes.size(); batchStart += batchSize)
         {
-            outFile << **iter;
-            count++;
-            if (count >= nBest) break;
+            size_t batchEnd = std::min(batchStart + batchSize, genomes.size());
+            std::vector<std::string> texts(batchEnd - batchStart);
+            ParallelFor(batchEnd - batchStart, 64, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++) genomes[batchStart + i]->AppendText(&texts[i]);
+            });
+            for (auto &&text : texts) outFile.write(text.data(), std::streamsize(text.size()));
         }
         outFile.close();
     }
     catch (std::exception& e)
     {
         std::cerr << e.what() << "\n";
+        std::remove(temporaryFilename.c_str());
+        return __LINE__;
     }
     catch (...)
     {
+        std::remove(temporaryFilename.c_str());
         return __LINE__;
     }
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryFilename, filename, errorCode);
+    if (errorCode) return __LINE__;
+    return 0;
+}
+
+// the orderings are stored as indices into the fitness sorted list
+void Population::WriteCheckpoint(Checkpoint *checkpoint) const
+{
+    checkpoint->Write(uint64_t(m_population.size()));
+    std::unordered_map<const Genome *, uint64_t> indices;
+    indices.reserve(m_population.size());
+    for (size_t i = 0; i < m_population.size(); i++)
+    {
+        m_population[i]->WriteCheckpoint(checkpoint);
+        indices[m_population[i].get()] = i;
+    }
+    std::vector<uint64_t> immortalIndices, ageIndices;
+    immortalIndices.reserve(m_immortalList.size());
+    ageIndices.reserve(m_ageList.size());
+    for (auto &&genome : m_immortalList) immortalIndices.push_back(indices[genome]);
+    for (auto &&genome : m_ageList) ageIndices.push_back(indices[genome]);
+    checkpoint->WriteVector(immortalIndices);
+    checkpoint->WriteVector(ageIndices);
+    m_random.WriteCheckpoint(checkpoint);
+}
+
+int Population::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Clear();
+    uint64_t populationSize = 0;
+    if (!checkpoint->Read(&populationSize)) return __LINE__;
+    for (uint64_t i = 0; i < populationSize; i++)
+    {
+        auto genome = std::make_shared<Genome>();
+        if (genome->ReadCheckpoint(checkpoint)) { Clear(); return __LINE__; }
+        m_population.push_back(std::move(genome));
+    }
+    std::vector<uint64_t> immortalIndices, ageIndices;
+    checkpoint->ReadVector(&immortalIndices);
+    checkpoint->ReadVector(&ageIndices);
+    if (checkpoint->GetReadError() || immortalIndices.size() + ageIndices.size() != m_population.size()) { Clear(); return __LINE__; }
+    for (auto &&index : immortalIndices)
+    {
+        if (index >= m_population.size()) { Clear(); return __LINE__; }
+        m_immortalList.push_back(m_population[size_t(index)].get());
+    }
+    for (auto &&index : ageIndices)
+    {
+        if (index >= m_population.size()) { Clear(); return __LINE__; }
+        m_ageList.push_back(m_population[size_t(index)].get());
+    }
+    if (m_random.ReadCheckpoint(checkpoint)) { Clear(); return __LINE__; }
     return 0;
 }
 
 // read a population (requires unique fitnesses)
 int Population::ReadPopulation(const char *filename)
 {
-    std::ifstream inFile;
-    inFile.exceptions (std::ios::failbit|std::ios::badbit|std::ios::eofbit);
-    try
+    Clear();
+    return ReadGenomes(filename, [this](std::unique_ptr<Genome> genome, size_t populationSize)
     {
-        inFile.open(filename);
-
-        m_population.clear();
-        m_immortalList.clear();
-        m_ageList.clear();
-        Random random;
+        InsertGenome(std::move(genome), populationSize);
+        return true;
+    });
+}
 
-        size_t populationSize;
-        inFile >> populationSize;
-        for (size_t i = 0; i < populationSize; i++)
+// read the genomes one at a time so that the caller can use them before the whole file has been parsed
+// the handler gets the population size from the file header and can return false to stop reading
+// binary population files are recognised from their header and are read through a memory mapping
+// and a population delta is rebuilt from its keyframe before any genomes are handed over
+int Population::ReadGenomes(const char *filename, const std::function<bool (std::unique_ptr<Genome> genome, size_t populationSize)> &genomeHandler)
+{
+    if (PopulationDelta::IsPopulationDeltaFile(filename))
+    {
+        std::vector<std::shared_ptr<const Genome>> genomes;
+        if (PopulationDelta::ReadSnapshot(filename, &genomes)) return __LINE__;
+        for (auto &&genome : genomes)
         {
-            auto genome = std::make_unique<Genome>();
-            inFile >> *genome;
-            InsertGenome(std::move(genome), populationSize);
+            if (!genomeHandler(std::make_unique<Genome>(*genome), genomes.size())) break;
         }
-        inFile.close();
+        return 0;
     }
-    catch (std::exception& e)
+
+    if (BinaryPopulationFile::IsBinaryPopulationFile(filename))
     {
-        std::cerr << e.what() << "\n";
+        BinaryPopulationFile binaryFile;
+        if (binaryFile.Open(filename)) return __LINE__;
+        for (size_t i = 0; i < binaryFile.GetPopulationSize(); i++)
+        {
+            auto genome = std::make_unique<Genome>();
+            binaryFile.GetGenome(i, genome.get());
+            if (!genomeHandler(std::move(genome), binaryFile.GetPopulationSize())) break;
+        }
+        return 0;
     }
-    catch (...)
+
+    MemoryMappedFile file;
+    if (file.Open(filename, 0, true)) return __LINE__;
+    const char *ptr = file.GetData();
+    const char *last = ptr + file.GetSize();
+    size_t populationSize = 0;
+    auto result = std::from_chars(SkipSpace(ptr, last), last, populationSize);
+    if (result.ec != std::errc()) return __LINE__;
+    ptr = result.ptr;
+
+    // the records are found by counting lines (a record is its genome length plus 3 lines) and each batch of records
+    // is then parsed in parallel. The batches start small so that a caller that only wants the first few genomes does
+    // not wait for a large part of the file. Anything that does not look like the usual layout is parsed one record
+    // at a time which copes with any whitespace
+    size_t read = 0;
+    size_t batchBytes = size_t(1) << 20;
+    std::vector<const char *> starts;
+    std::vector<const char *> ends;
+    std::vector<std::unique_ptr<Genome>> genomes;
+    while (read < populationSize)
     {
-        return __LINE__;
+        starts.clear();
+        const char *batchEnd = ptr;
+        while (read + starts.size() < populationSize && batchEnd < last && size_t(batchEnd - ptr) < batchBytes)
+        {
+            const char *recordStart = SkipSpace(batchEnd, last);
+            int genomeType = 0;
+            size_t genomeLength = 0;
+            auto typeResult = std::from_chars(recordStart, last, genomeType);
+            if (typeResult.ec != std::errc()) break;
+            auto lengthResult = std::from_chars(SkipSpace(typeResult.ptr, last), last, genomeLength);
+            if (lengthResult.ec != std::errc() || genomeLength > size_t(last - recordStart)) break;
+            const char *recordEnd = lengthResult.ptr;
+            for (size_t line = 0; line < genomeLength + 2 && recordEnd; line++)
+            {
+                recordEnd = static_cast<const char *>(std::memchr(recordEnd, '\n', size_t(last - recordEnd)));
+                if (recordEnd) recordEnd++;
+            }
+            starts.push_back(recordStart);
+            batchEnd = recordEnd ? recordEnd : last; // the last record may not end with a newline
+        }
+        batchBytes = std::min(batchBytes * 4, s_textBatchBytes * std::max(size_t(std::thread::hardware_concurrency()), size_t(1)));
+
+        genomes.resize(starts.size());
+        ends.assign(starts.size(), nullptr);
+        ParallelFor(starts.size(), 64, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                if (!genomes[i]) genomes[i] = std::make_unique<Genome>();
+                ends[i] = genomes[i]->ParseText(starts[i], last);
+            }
+        });
+        // a record that did not finish where the next one was found to start means the line counting went wrong
+        size_t good = 0;
+        while (good < starts.size() && ends[good] && SkipSpace(ends[good], last) == (good + 1 < starts.size() ? starts[good + 1] : SkipSpace(batchEnd, last))) good++;
+        for (size_t i = 0; i < good; i++)
+        {
+            if (!genomeHandler(std::move(genomes[i]), populationSize)) return 0;
+        }
+        read += good;
+        if (good) ptr = ends[good - 1];
+        if (good == starts.size() && good) continue;
+
+        auto genome = std::make_unique<Genome>();
+        const char *recordEnd = genome->ParseText(ptr, last);
+        if (!recordEnd)
+        {
+            std::cerr << "Error reading genome " << read << " of " << populationSize << " from " << filename << "\n";
+            break;
+        }
+        ptr = recordEnd;
+        read++;
+        if (!genomeHandler(std::move(genome), populationSize)) return 0;
     }
     return 0;
 }
@@ -407,24 +667,40 @@ int Population::ReadPopulation(const char *filename)
 Genome Population::GetOffspring()
 {
     Genome offspring;
-    Genome *parent1, *parent2;
-    Mating mating(&m_random);
+    GetOffspring(&offspring);
+    return offspring;
+}
+
+// this version writes into an existing genome so that it can reuse the genome's storage
+void Population::GetOffspring(Genome *offspring, std::array<int32_t, 2> *parentRanks)
+{
+    GetOffspring(offspring, parentRanks, &m_random);
+}
+
+// the population itself is not changed so this can be used on another thread with its own random number generator
+void Population::GetOffspring(Genome *offspring, std::array<int32_t, 2> *parentRanks, Random *random) const
+{
+    const Genome *parent1, *parent2;
+    Mating mating(random);
     int mutationCount = 0;
     size_t parent1Rank, parent2Rank;
     while (mutationCount == 0) // this means we always get some mutation (no point in getting unmutated offspring)
     {
-        parent1 = ChooseParent(&parent1Rank);
-        offspring = *parent1;
-        if (m_random.CoinFlip(m_crossoverChance))
+        parent1 = ChooseParent(&parent1Rank, random);
+        parent2Rank = std::numeric_limits<size_t>::max();
+        *offspring = *parent1;
+        offspring->SetParents(m_population[parent1Rank]);
+        if (random->CoinFlip(m_crossoverChance))
         {
-            parent2 = ChooseParent(&parent2Rank);
-            mutationCount += mating.Mate(parent1, parent2, &offspring, m_crossoverType);
+            parent2 = ChooseParent(&parent2Rank, random);
+            mutationCount += mating.Mate(parent1, parent2, offspring, m_crossoverType);
+            offspring->SetParents(m_population[parent1Rank], m_population[parent2Rank]);
         }
-        if (m_multipleGaussian)  mutationCount += mating.MultipleGaussianMutate(&offspring, m_gaussianMutationChance, m_bounceMutation);
-        else mutationCount += mating.GaussianMutate(&offspring, m_gaussianMutationChance, m_bounceMutation);
+        if (m_multipleGaussian)  mutationCount += mating.MultipleGaussianMutate(offspring, m_gaussianMutationChance, m_bounceMutation);
+        else mutationCount += mating.GaussianMutate(offspring, m_gaussianMutationChance, m_bounceMutation);
 
-        mutationCount += mating.FrameShiftMutate(&offspring, m_frameShiftMutationChance);
-        mutationCount += mating.DuplicationMutate(&offspring, m_duplicationMutationChance);
+        mutationCount += mating.FrameShiftMutate(offspring, m_frameShiftMutationChance);
+        mutationCount += mating.DuplicationMutate(offspring, m_duplicationMutationChance);
     }
-    return offspring;
+    if (parentRanks) *parentRanks = {int32_t(parent1Rank), parent2Rank == std::numeric_limits<size_t>::max() ? -1 : int32_t(parent2Rank)};
 }
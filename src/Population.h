@@ -13,8 +13,14 @@
 #include "Genome.h"
 #include "Random.h"
 #include "Mating.h"
+#include "GenomePool.h"
 
 #include <memory>
+#include <functional>
+#include <array>
+#include <cstdint>
+
+class Checkpoint;
 
 enum SelectionType
 {
@@ -34,11 +40,14 @@ class Population
 public:
     Population();
 
-    Genome *GetFirstGenome() { return m_population.begin()->get(); }
-    Genome *GetLastGenome() { return m_population.rbegin()->get(); }
-    Genome *GetGenome(size_t i) { return m_population[i].get(); }
-    size_t GetPopulationSize() { return m_population.size(); }
+    const Genome *GetFirstGenome() const { return m_population.begin()->get(); }
+    const Genome *GetLastGenome() const { return m_population.rbegin()->get(); }
+    const Genome *GetGenome(size_t i) const { return m_population[i].get(); } // the genome may also be held by a snapshot so use GetUnsharedGenome to change it
+    Genome *GetUnsharedGenome(size_t i);
+    size_t GetPopulationSize() const { return m_population.size(); }
     Genome GetOffspring();
+    void GetOffspring(Genome *offspring, std::array<int32_t, 2> *parentRanks = nullptr); // the ranks are indices into the population and -1 when there is no second parent
+    void GetOffspring(Genome *offspring, std::array<int32_t, 2> *parentRanks, Random *random) const;
 
     void SetSelectionType(SelectionType type) { m_selectionType = type; }
     void SetParentsToKeep(size_t parentsToKeep) { m_parentsToKeep = parentsToKeep; if (m_parentsToKeep < 0) m_parentsToKeep = 0; }
@@ -54,18 +63,31 @@ class Population
     void SetDuplicationMutationChance(double duplicationMutationChance) { m_duplicationMutationChance = duplicationMutationChance; }
 
     void SetMinimizeScore(bool minimizeScore) { m_minimizeScore = minimizeScore; }
+    void SetGenomePool(const std::shared_ptr<GenomePool> &genomePool) { m_genomePool = genomePool; } // optional, supplies the shared_ptr control blocks
 
-    Genome *ChooseParent(size_t *parentRank);
+    const Genome *ChooseParent(size_t *parentRank);
+    const Genome *ChooseParent(size_t *parentRank, Random *random) const;
     void Randomise();
-    int InsertGenome(std::unique_ptr<Genome> genome, size_t targetPopulationSize);
+    int InsertGenome(std::shared_ptr<Genome> genome, size_t targetPopulationSize);
+    int InsertGenome(std::unique_ptr<Genome> genome, size_t targetPopulationSize); // shared through the genome pool if there is one
+    std::shared_ptr<const Genome> RemoveGenome(const std::vector<double> &genes); // returns nullptr if no genome has these genes
     void ResizePopulation(size_t size);
+    void Clear();
 
     int ReadPopulation(const char *filename);
+    static int ReadGenomes(const char *filename, const std::function<bool (std::unique_ptr<Genome> genome, size_t populationSize)> &genomeHandler);
     int WritePopulation(const char *filename, size_t nBest);
+    std::vector<std::shared_ptr<const Genome>> GetSnapshot(size_t nBest) const; // fittest first, shares the genomes rather than copying them
+    static int WriteGenomes(const char *filename, const std::vector<std::shared_ptr<const Genome>> &genomes);
+
+    // the genomes, the age and immortal orderings and the random number state but not the settings which come from the preferences
+    void WriteCheckpoint(Checkpoint *checkpoint) const;
+    int ReadCheckpoint(Checkpoint *checkpoint);
 
 protected:
+    std::shared_ptr<Genome> Share(std::unique_ptr<Genome> genome);
 
-    std::vector<std::unique_ptr<Genome>> m_population; // list of genomes sorted by fitness
+    std::vector<std::shared_ptr<Genome>> m_population; // list of genomes sorted by fitness, shared with any snapshots
     std::vector<Genome *> m_immortalList; // sorted vector
     std::vector<Genome *> m_ageList; // apparently a vector will be faster than a deque on a modern cpu
 
@@ -83,6 +105,7 @@ class Population
 
     bool m_minimizeScore = false;
 
+    std::shared_ptr<GenomePool> m_genomePool;
     Random m_random;
 };
 
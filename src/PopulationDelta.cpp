@@ -0,0 +1,377 @@
+#include "PopulationDelta.h"
+#include "Population.h"
+#include "Genome.h"
+
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <unordered_map>
+#include <numeric>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cstdio>
+
+static const char s_deltaMagic[8] = {'A', 'G', 'A', '4', 'P', 'O', 'P', 'D'};
+static const uint32_t s_deltaVersion = 1;
+static const uint32_t s_noReference = std::numeric_limits<uint32_t>::max();
+static const size_t s_maxChainLength = 65536; // also stops a damaged folder sending the reader round in a loop
+
+// the bounds, SDs and circular flags of a genome that cannot borrow them from its parent
+static void WriteSchema(Checkpoint *buffer, const Genome &genome)
+{
+    std::vector<int> flags(genome.GetCircularMutationFlags()->begin(), genome.GetCircularMutationFlags()->end());
+    flags.resize(genome.GetGenomeLength()); // only genomes read from a file are guaranteed to have the flags
+    buffer->Write(int32_t(genome.GetGenomeType()));
+    buffer->WriteVector(*genome.GetLowBounds());
+    buffer->WriteVector(*genome.GetHighBounds());
+    buffer->WriteVector(*genome.GetGaussianSDs());
+    buffer->WriteVector(flags);
+}
+
+static bool ReadSchema(Checkpoint *buffer, int32_t *genomeType, std::vector<double> *lowBounds, std::vector<double> *highBounds, std::vector<double> *gaussianSDs, std::vector<int> *flags)
+{
+    buffer->Read(genomeType);
+    buffer->ReadVector(lowBounds);
+    buffer->ReadVector(highBounds);
+    buffer->ReadVector(gaussianSDs);
+    buffer->ReadVector(flags);
+    if (buffer->GetReadError()) return false;
+    if (*genomeType != Genome::IndividualRanges && *genomeType != Genome::IndividualCircularMutation) return false;
+    size_t genomeLength = lowBounds->size();
+    return highBounds->size() == genomeLength && gaussianSDs->size() == genomeLength && flags->size() == genomeLength;
+}
+
+static bool SameSchema(const Genome &lhs, const Genome &rhs)
+{
+    return lhs.GetGenomeType() == rhs.GetGenomeType() && *lhs.GetLowBounds() == *rhs.GetLowBounds() && *lhs.GetHighBounds() == *rhs.GetHighBounds() &&
+           *lhs.GetGaussianSDs() == *rhs.GetGaussianSDs() && *lhs.GetCircularMutationFlags() == *rhs.GetCircularMutationFlags();
+}
+
+// genes are compared bit for bit because the delta has to rebuild exactly the same values
+static size_t CountSameGenes(const Genome &lhs, const Genome &rhs)
+{
+    if (lhs.GetGenomeLength() != rhs.GetGenomeLength()) return 0;
+    const double *lhsGenes = lhs.GetGenes()->data(), *rhsGenes = rhs.GetGenes()->data();
+    size_t count = 0;
+    for (size_t i = 0; i < lhs.GetGenomeLength(); i++) count += std::memcmp(lhsGenes + i, rhsGenes + i, sizeof(double)) == 0;
+    return count;
+}
+
+void PopulationDelta::Clear()
+{
+    m_previousFilename.clear();
+    m_previous.clear();
+    m_encoded.clear();
+    m_buffer.Clear();
+    m_deltaCount = 0;
+    m_removedCount = 0;
+    m_insertedCount = 0;
+}
+
+void PopulationDelta::SetKeyframe(const std::string &filename, const std::vector<std::shared_ptr<const Genome>> &genomes)
+{
+    Clear();
+    m_previousFilename = filename;
+    m_previous = genomes;
+}
+
+// the population shares genomes with its snapshots rather than copying them so a genome that is still present is the
+// same object as before, and the population never reorders the genomes it keeps so only the removed and inserted
+// positions need to be stored
+bool PopulationDelta::Encode(const std::vector<std::shared_ptr<const Genome>> &genomes, size_t keyframeEvery)
+{
+    m_buffer.Clear();
+    m_encoded.clear();
+    m_removedCount = 0;
+    m_insertedCount = 0;
+    if (m_previousFilename.empty() || m_deltaCount + 1 >= keyframeEvery) return false;
+    if (m_previous.size() >= s_noReference / 2 || genomes.size() >= s_noReference / 2) return false;
+
+    // indices below m_previous.size() are genomes in the previous snapshot and the rest are the genomes being inserted
+    std::unordered_map<const Genome *, uint32_t> index;
+    index.reserve(m_previous.size() + genomes.size());
+    for (size_t i = 0; i < m_previous.size(); i++) index.emplace(m_previous[i].get(), uint32_t(i));
+    std::vector<char> kept(m_previous.size(), 0);
+    std::vector<uint32_t> inserted; // positions in the new snapshot
+    uint32_t lastKept = s_noReference;
+    for (size_t i = 0; i < genomes.size(); i++)
+    {
+        auto found = index.find(genomes[i].get());
+        if (found == index.end() || kept[found->second]) { inserted.push_back(uint32_t(i)); continue; }
+        if (lastKept != s_noReference && found->second < lastKept) return false; // reordered so a keyframe is needed
+        lastKept = found->second;
+        kept[found->second] = 1;
+    }
+    if (inserted.size() * 2 > genomes.size()) return false; // most of the population is new
+    uint32_t previousSize = uint32_t(m_previous.size());
+    for (size_t j = 0; j < inserted.size(); j++) index.emplace(genomes[inserted[j]].get(), previousSize + uint32_t(j));
+
+    // the reference is whichever parent shares more genes, provided it is somewhere the reader will have it
+    std::vector<uint32_t> references(inserted.size(), s_noReference);
+    for (size_t j = 0; j < inserted.size(); j++)
+    {
+        const Genome &genome = *genomes[inserted[j]];
+        size_t bestCount = 0;
+        for (size_t k = 0; k < 2; k++)
+        {
+            std::shared_ptr<const Genome> parent = genome.GetParent(k);
+            if (!parent || parent->GetGenomeLength() != genome.GetGenomeLength()) continue;
+            auto found = index.find(parent.get());
+            if (found == index.end() || found->second == previousSize + uint32_t(j)) continue;
+            size_t count = CountSameGenes(genome, *parent);
+            if (references[j] == s_noReference || count > bestCount) { references[j] = found->second; bestCount = count; }
+        }
+        // genomes without a parent, such as those from the start population, can still share the bounds
+        if (references[j] == s_noReference && previousSize && m_previous.front()->GetGenomeLength() == genome.GetGenomeLength()) references[j] = 0;
+    }
+
+    // an inserted genome has to be stored after the inserted genome it refers to
+    std::vector<uint32_t> order, recordNumbers(inserted.size(), s_noReference), chain;
+    std::vector<char> visited(inserted.size(), 0);
+    order.reserve(inserted.size());
+    for (uint32_t j = 0; j < inserted.size(); j++)
+    {
+        chain.clear();
+        uint32_t k = j;
+        while (!visited[k])
+        {
+            visited[k] = 1;
+            chain.push_back(k);
+            if (references[k] == s_noReference || references[k] < previousSize) break;
+            k = references[k] - previousSize;
+        }
+        for (auto iter = chain.rbegin(); iter != chain.rend(); ++iter)
+        {
+            uint32_t reference = references[*iter];
+            if (reference != s_noReference && reference >= previousSize && recordNumbers[reference - previousSize] == s_noReference) references[*iter] = s_noReference; // only possible in a loop
+            recordNumbers[*iter] = uint32_t(order.size());
+            order.push_back(*iter);
+        }
+    }
+
+    std::vector<uint32_t> removed;
+    for (uint32_t i = 0; i < previousSize; i++) { if (!kept[i]) removed.push_back(i); }
+    m_buffer.WriteString(std::filesystem::path(m_previousFilename).filename().string());
+    m_buffer.Write(uint64_t(previousSize));
+    m_buffer.Write(uint64_t(genomes.size()));
+    m_buffer.WriteVector(removed);
+    m_buffer.Write(uint64_t(order.size()));
+    std::vector<uint8_t> changedMask;
+    std::vector<double> changedGenes;
+    for (uint32_t j : order)
+    {
+        const Genome &genome = *genomes[inserted[j]];
+        uint32_t reference = references[j];
+        const Genome *referenceGenome = nullptr;
+        if (reference != s_noReference && reference >= previousSize)
+        {
+            referenceGenome = genomes[inserted[reference - previousSize]].get();
+            reference = previousSize + recordNumbers[reference - previousSize];
+        }
+        else if (reference != s_noReference)
+        {
+            referenceGenome = m_previous[reference].get();
+        }
+        m_buffer.Write(inserted[j]);
+        m_buffer.Write(reference);
+        m_buffer.Write(genome.GetFitness());
+        if (!referenceGenome)
+        {
+            WriteSchema(&m_buffer, genome);
+            m_buffer.WriteVector(*genome.GetGenes());
+            continue;
+        }
+        bool sameSchema = SameSchema(genome, *referenceGenome);
+        m_buffer.Write(uint8_t(sameSchema));
+        if (!sameSchema) WriteSchema(&m_buffer, genome);
+        changedMask.assign((genome.GetGenomeLength() + 7) / 8, 0);
+        changedGenes.clear();
+        const double *genes = genome.GetGenes()->data(), *referenceGenes = referenceGenome->GetGenes()->data();
+        for (size_t i = 0; i < genome.GetGenomeLength(); i++)
+        {
+            if (std::memcmp(genes + i, referenceGenes + i, sizeof(double)) == 0) continue;
+            changedMask[i / 8] |= uint8_t(1 << (i % 8));
+            changedGenes.push_back(genome.GetGene(i));
+        }
+        m_buffer.WriteVector(changedMask);
+        m_buffer.WriteVector(changedGenes);
+    }
+    m_encoded = genomes;
+    m_removedCount = removed.size();
+    m_insertedCount = inserted.size();
+    return true;
+}
+
+// written under a temporary name and renamed like the other population files
+int PopulationDelta::WriteDelta(const std::string &filename)
+{
+    if (m_buffer.GetSize() == 0) return __LINE__;
+    Header header = {};
+    std::memcpy(header.magic, s_deltaMagic, sizeof(header.magic));
+    header.version = s_deltaVersion;
+    header.size = m_buffer.GetSize();
+    header.checksum = Checkpoint::Checksum(m_buffer.GetData(), m_buffer.GetSize());
+    std::string temporaryFilename = filename + ".tmp";
+    {
+        std::ofstream outFile(temporaryFilename, std::ios::binary | std::ios::trunc);
+        if (!outFile) return __LINE__;
+        outFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        outFile.write(m_buffer.GetData(), std::streamsize(m_buffer.GetSize()));
+        outFile.close();
+        if (!outFile) { std::remove(temporaryFilename.c_str()); return __LINE__; }
+    }
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryFilename, filename, errorCode);
+    if (errorCode) { std::remove(temporaryFilename.c_str()); return __LINE__; }
+    m_previousFilename = filename;
+    m_previous = std::move(m_encoded);
+    m_encoded.clear();
+    m_buffer.Clear();
+    m_deltaCount++;
+    return 0;
+}
+
+// the chain of deltas is followed back to the keyframe, which can be in either population file format
+int PopulationDelta::ReadSnapshot(const std::string &filename, std::vector<std::shared_ptr<const Genome>> *genomes)
+{
+    std::vector<Checkpoint> deltas;
+    std::string name = filename;
+    while (IsPopulationDeltaFile(name))
+    {
+        if (deltas.size() >= s_maxChainLength) return __LINE__;
+        std::string previousFilename;
+        deltas.emplace_back();
+        if (ReadDelta(name, &deltas.back(), &previousFilename)) return __LINE__;
+        name = (std::filesystem::path(name).parent_path() / previousFilename).string();
+    }
+
+    genomes->clear();
+    size_t expected = 0;
+    int err = Population::ReadGenomes(name.c_str(), [genomes, &expected](std::unique_ptr<Genome> genome, size_t populationSize)
+    {
+        expected = populationSize;
+        genomes->push_back(std::move(genome));
+        return true;
+    });
+    if (err || genomes->size() != expected) return __LINE__;
+    for (auto iter = deltas.rbegin(); iter != deltas.rend(); ++iter)
+    {
+        if (ApplyDelta(&(*iter), genomes)) return __LINE__;
+    }
+    return 0;
+}
+
+bool PopulationDelta::IsPopulationDeltaFile(const std::string &filename)
+{
+    char magic[sizeof(s_deltaMagic)] = {};
+    std::ifstream inFile(filename, std::ios::binary);
+    if (!inFile.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, s_deltaMagic, sizeof(magic)) == 0;
+}
+
+// reads and checks the whole file and leaves the buffer positioned after the name of the previous snapshot
+int PopulationDelta::ReadDelta(const std::string &filename, Checkpoint *buffer, std::string *previousFilename)
+{
+    std::ifstream inFile(filename, std::ios::binary);
+    if (!inFile) return __LINE__;
+    Header header = {};
+    if (!inFile.read(reinterpret_cast<char *>(&header), sizeof(header))) return __LINE__;
+    if (std::memcmp(header.magic, s_deltaMagic, sizeof(header.magic)) != 0 || header.version != s_deltaVersion) return __LINE__;
+    std::error_code errorCode;
+    uintmax_t fileSize = std::filesystem::file_size(filename, errorCode);
+    if (errorCode || fileSize != sizeof(header) + header.size) return __LINE__;
+    std::vector<char> data(size_t(header.size));
+    if (!inFile.read(data.data(), std::streamsize(data.size()))) return __LINE__;
+    if (Checkpoint::Checksum(data.data(), data.size()) != header.checksum) return __LINE__;
+    buffer->Assign(data.data(), data.size());
+    if (!buffer->ReadString(previousFilename) || previousFilename->empty()) return __LINE__;
+    return 0;
+}
+
+int PopulationDelta::ApplyDelta(Checkpoint *buffer, std::vector<std::shared_ptr<const Genome>> *genomes)
+{
+    uint64_t previousSize = 0, populationSize = 0, insertedCount = 0;
+    std::vector<uint32_t> removed;
+    buffer->Read(&previousSize);
+    buffer->Read(&populationSize);
+    buffer->ReadVector(&removed);
+    buffer->Read(&insertedCount);
+    if (buffer->GetReadError() || previousSize != genomes->size() || removed.size() > previousSize) return __LINE__;
+    if (insertedCount > populationSize || populationSize - insertedCount != previousSize - removed.size()) return __LINE__;
+    for (size_t i = 0; i < removed.size(); i++)
+    {
+        if (removed[i] >= previousSize || (i && removed[i] <= removed[i - 1])) return __LINE__;
+    }
+
+    std::vector<std::shared_ptr<const Genome>> references = std::move(*genomes);
+    std::vector<uint32_t> positions;
+    std::vector<double> lowBounds, highBounds, gaussianSDs, genes;
+    std::vector<int> flags;
+    std::vector<uint8_t> changedMask;
+    std::vector<double> changedGenes;
+    int32_t genomeType = 0;
+    for (uint64_t k = 0; k < insertedCount; k++)
+    {
+        uint32_t position = 0, reference = 0;
+        double fitness = 0;
+        buffer->Read(&position);
+        buffer->Read(&reference);
+        buffer->Read(&fitness);
+        if (buffer->GetReadError() || position >= populationSize || (reference != s_noReference && reference >= references.size())) return __LINE__;
+        auto genome = std::make_shared<Genome>();
+        if (reference == s_noReference)
+        {
+            if (!ReadSchema(buffer, &genomeType, &lowBounds, &highBounds, &gaussianSDs, &flags) || !buffer->ReadVector(&genes) || genes.size() != lowBounds.size()) return __LINE__;
+            genome->Assign(Genome::GenomeType(genomeType), genes.size(), genes.data(), lowBounds.data(), highBounds.data(), gaussianSDs.data(), flags.data(), fitness);
+        }
+        else
+        {
+            const Genome &referenceGenome = *references[reference];
+            size_t genomeLength = referenceGenome.GetGenomeLength();
+            uint8_t sameSchema = 0;
+            if (!buffer->Read(&sameSchema)) return __LINE__;
+            if (sameSchema) *genome = referenceGenome;
+            else if (!ReadSchema(buffer, &genomeType, &lowBounds, &highBounds, &gaussianSDs, &flags) || lowBounds.size() != genomeLength) return __LINE__;
+            else genome->Assign(Genome::GenomeType(genomeType), genomeLength, referenceGenome.GetGenes()->data(), lowBounds.data(), highBounds.data(), gaussianSDs.data(), flags.data(), fitness);
+            buffer->ReadVector(&changedMask);
+            buffer->ReadVector(&changedGenes);
+            if (buffer->GetReadError() || changedMask.size() != (genomeLength + 7) / 8) return __LINE__;
+            size_t changed = 0;
+            for (size_t i = 0; i < genomeLength; i++)
+            {
+                if ((changedMask[i / 8] & (1 << (i % 8))) == 0) continue;
+                if (changed >= changedGenes.size()) return __LINE__;
+                genome->SetGene(i, changedGenes[changed++]);
+            }
+            if (changed != changedGenes.size()) return __LINE__;
+        }
+        genome->SetFitness(fitness);
+        positions.push_back(position);
+        references.push_back(std::move(genome));
+    }
+    if (!buffer->AtEnd()) return __LINE__;
+
+    // the inserted genomes go to their positions and the survivors fill the gaps in their previous order
+    std::vector<size_t> insertedOrder(positions.size());
+    std::iota(insertedOrder.begin(), insertedOrder.end(), size_t(0));
+    std::sort(insertedOrder.begin(), insertedOrder.end(), [&positions](size_t lhs, size_t rhs) { return positions[lhs] < positions[rhs]; });
+    for (size_t i = 1; i < insertedOrder.size(); i++)
+    {
+        if (positions[insertedOrder[i]] == positions[insertedOrder[i - 1]]) return __LINE__;
+    }
+    genomes->reserve(size_t(populationSize));
+    size_t nextInserted = 0, nextRemoved = 0, nextPrevious = 0;
+    for (size_t position = 0; position < populationSize; position++)
+    {
+        if (nextInserted < insertedOrder.size() && positions[insertedOrder[nextInserted]] == position)
+        {
+            genomes->push_back(references[size_t(previousSize) + insertedOrder[nextInserted++]]);
+            continue;
+        }
+        while (nextRemoved < removed.size() && removed[nextRemoved] == nextPrevious) { nextRemoved++; nextPrevious++; }
+        if (nextPrevious >= previousSize) return __LINE__;
+        genomes->push_back(references[nextPrevious++]);
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef POPULATIONDELTA_H
+#define POPULATIONDELTA_H
+
+#include "Checkpoint.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+class Genome;
+
+// population snapshots stored as the change from the previous snapshot
+// consecutive snapshots usually differ by only a few genomes so a delta lists the positions of the genomes that have
+// left and of the ones that have arrived, and each new genome is stored as just the genes that differ from the nearer
+// of its parents when that parent is in the previous snapshot or earlier in the same delta. Every so often the
+// snapshot is written in full as an ordinary population file (the keyframe) and each delta names the file it follows
+// in the same folder so any snapshot can be rebuilt by reading the keyframe and applying the deltas in turn
+
+class PopulationDelta
+{
+public:
+    // the writer keeps the last snapshot written and is used for one folder at a time
+    void Clear();
+    void SetKeyframe(const std::string &filename, const std::vector<std::shared_ptr<const Genome>> &genomes);
+    bool Encode(const std::vector<std::shared_ptr<const Genome>> &genomes, size_t keyframeEvery); // false when a keyframe should be written instead
+    int WriteDelta(const std::string &filename); // writes the last Encode and makes it the previous snapshot
+
+    size_t GetRemovedCount() const { return m_removedCount; }
+    size_t GetInsertedCount() const { return m_insertedCount; }
+    size_t GetEncodedSize() const { return m_buffer.GetSize(); }
+
+    static int ReadSnapshot(const std::string &filename, std::vector<std::shared_ptr<const Genome>> *genomes);
+    static bool IsPopulationDeltaFile(const std::string &filename);
+
+private:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t size;
+        uint64_t checksum;
+    };
+
+    static int ReadDelta(const std::string &filename, Checkpoint *buffer, std::string *previousFilename);
+    static int ApplyDelta(Checkpoint *buffer, std::vector<std::shared_ptr<const Genome>> *genomes);
+
+    std::string m_previousFilename;
+    std::vector<std::shared_ptr<const Genome>> m_previous;
+    std::vector<std::shared_ptr<const Genome>> m_encoded;
+    Checkpoint m_buffer;
+    size_t m_deltaCount = 0;
+    size_t m_removedCount = 0;
+    size_t m_insertedCount = 0;
+};
+
+#endif // POPULATIONDELTA_H
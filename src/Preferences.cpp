@@ -22,10 +22,12 @@ int Preferences::ReadPreferences(const std::string &filename)
 {
 
     std::string paramsBuffer;
+    DataFile params; // local so that Preferences can be copied
 
     try
     {
         if (params.ReadFile(filename)) throw __LINE__;
+        params.BuildIndex(); // there are a lot of attributes to look up
 
         // essential parameters
         if (params.RetrieveAttribute("genomeLength", &genomeLength)) throw __LINE__;
@@ -72,6 +74,37 @@ int Preferences::ReadPreferences(const std::string &filename)
 
         // optional parameters
         params.RetrieveAttribute("startingPopulation", &startingPopulation);
+        params.RetrieveAttribute("leaseQuantile", &leaseQuantile);
+        params.RetrieveAttribute("leaseMultiplier", &leaseMultiplier);
+        params.RetrieveAttribute("leaseMinimum", &leaseMinimum);
+        params.RetrieveAttribute("leaseMinimumSamples", &leaseMinimumSamples);
+        params.RetrieveAttribute("heartbeatExtension", &heartbeatExtension);
+        params.RetrieveAttribute("stragglerQuantile", &stragglerQuantile);
+        params.RetrieveAttribute("requeueClosedSessions", &requeueClosedSessions);
+        params.RetrieveAttribute("hostLatencySmoothing", &hostLatencySmoothing);
+        params.RetrieveAttribute("hostThroughputTimeConstant", &hostThroughputTimeConstant);
+        params.RetrieveAttribute("maxInFlightMultiple", &maxInFlightMultiple);
+        params.RetrieveAttribute("elasticPopulation", &elasticPopulation);
+        params.RetrieveAttribute("elasticPopulationPerClient", &elasticPopulationPerClient);
+        params.RetrieveAttribute("elasticPopulationMaximum", &elasticPopulationMaximum);
+        params.RetrieveAttribute("eliteReevaluationEvery", &eliteReevaluationEvery);
+        params.RetrieveAttribute("eliteReevaluationCount", &eliteReevaluationCount);
+        params.RetrieveAttribute("drainTimeLimit", &drainTimeLimit);
+        params.RetrieveAttribute("checkpointEvery", &checkpointEvery);
+        params.RetrieveAttribute("journalEvaluations", &journalEvaluations);
+        params.RetrieveAttribute("binaryPopulations", &binaryPopulations);
+        params.RetrieveAttribute("snapshotArchive", &snapshotArchive);
+        params.RetrieveAttribute("snapshotArchiveKeep", &snapshotArchiveKeep);
+        params.RetrieveAttribute("populationKeyframeEvery", &populationKeyframeEvery);
+        params.RetrieveAttribute("offspringPrefetch", &offspringPrefetch);
+        if (params.RetrieveAttribute("dispatchWeights", &paramsBuffer) == false)
+        {
+            if (ReadDoubleList(paramsBuffer, &dispatchWeights, dispatchWeights.size())) throw __LINE__;
+        }
+        if (params.RetrieveAttribute("dispatchMaximumAges", &paramsBuffer) == false)
+        {
+            if (ReadDoubleList(paramsBuffer, &dispatchMaximumAges, dispatchMaximumAges.size())) throw __LINE__;
+        }
 
     }
 
@@ -84,6 +117,18 @@ int Preferences::ReadPreferences(const std::string &filename)
     return 0;
 }
 
+// reads a whitespace separated list of exactly count numbers
+int Preferences::ReadDoubleList(const std::string &text, std::vector<double> *values, size_t count)
+{
+    std::istringstream in(text);
+    std::vector<double> list;
+    double value;
+    while (in >> value) list.push_back(value);
+    if (!in.eof() || list.size() != count) return __LINE__;
+    *values = list;
+    return 0;
+}
+
 // output to a string
 std::string Preferences::GetPreferencesString()
 {
@@ -108,6 +153,35 @@ std::string Preferences::GetPreferencesString()
     out << "startingPopulation \"" << startingPopulation << "\"\n";
     out << "outputPopulationSize " << outputPopulationSize << "\n";
     out << "watchDogTimerLimit " << watchDogTimerLimit << "\n";
+    out << "leaseQuantile " << leaseQuantile << "\n";
+    out << "leaseMultiplier " << leaseMultiplier << "\n";
+    out << "leaseMinimum " << leaseMinimum << "\n";
+    out << "leaseMinimumSamples " << leaseMinimumSamples << "\n";
+    out << "heartbeatExtension " << heartbeatExtension << "\n";
+    out << "stragglerQuantile " << stragglerQuantile << "\n";
+    out << "requeueClosedSessions " << requeueClosedSessions << "\n";
+    out << "hostLatencySmoothing " << hostLatencySmoothing << "\n";
+    out << "hostThroughputTimeConstant " << hostThroughputTimeConstant << "\n";
+    out << "maxInFlightMultiple " << maxInFlightMultiple << "\n";
+    out << "elasticPopulation " << elasticPopulation << "\n";
+    out << "elasticPopulationPerClient " << elasticPopulationPerClient << "\n";
+    out << "elasticPopulationMaximum " << elasticPopulationMaximum << "\n";
+    out << "dispatchWeights \"";
+    for (size_t i = 0; i < dispatchWeights.size(); i++) out << (i ? " " : "") << dispatchWeights[i];
+    out << "\"\n";
+    out << "dispatchMaximumAges \"";
+    for (size_t i = 0; i < dispatchMaximumAges.size(); i++) out << (i ? " " : "") << dispatchMaximumAges[i];
+    out << "\"\n";
+    out << "eliteReevaluationEvery " << eliteReevaluationEvery << "\n";
+    out << "eliteReevaluationCount " << eliteReevaluationCount << "\n";
+    out << "drainTimeLimit " << drainTimeLimit << "\n";
+    out << "checkpointEvery " << checkpointEvery << "\n";
+    out << "journalEvaluations " << journalEvaluations << "\n";
+    out << "binaryPopulations " << binaryPopulations << "\n";
+    out << "snapshotArchive " << snapshotArchive << "\n";
+    out << "snapshotArchiveKeep " << snapshotArchiveKeep << "\n";
+    out << "populationKeyframeEvery " << populationKeyframeEvery << "\n";
+    out << "offspringPrefetch " << offspringPrefetch << "\n";
     out << "circularMutation " << circularMutation << "\n";
     out << "bounceMutation " << bounceMutation << "\n";
     out << "minimizeScore " << minimizeScore << "\n";
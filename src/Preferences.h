@@ -15,6 +15,8 @@
 #include "Mating.h"
 #include "Random.h"
 
+#include <vector>
+
 class Preferences
 {
 public:
@@ -22,8 +24,8 @@ class Preferences
 
     int ReadPreferences(const std::string &filename);
     std::string GetPreferencesString();
+    static int ReadDoubleList(const std::string &text, std::vector<double> *values, size_t count);
 
-    DataFile params;
     int genomeLength = 0;
     int populationSize = 0;
     int maxReproductions = 0;
@@ -32,6 +34,7 @@ class Preferences
     double duplicationMutationChance = 0;
     double crossoverChance = 0;
     int parentsToKeep = 0;
+    // the files from these three are written and the console is updated on their own pipeline stage threads
     int saveBestEvery = 0;
     int savePopEvery = 0;
     int outputStatsEvery = 0;
@@ -51,6 +54,31 @@ class Preferences
     bool bounceMutation = true;
     bool minimizeScore = false;
     ResizeControl resizeControl = MutateResize;
+    double leaseQuantile = 0.95;
+    double leaseMultiplier = 3;
+    double leaseMinimum = 10;
+    int leaseMinimumSamples = 20;
+    double heartbeatExtension = 60;
+    double stragglerQuantile = 0; // runs older than this quantile of the evaluation times are sent to a second client, 0 turns speculative duplicates off
+    bool requeueClosedSessions = false; // send runs to another client as soon as the session that took them closes, only for clients that keep their connection open while evaluating
+    double hostLatencySmoothing = 0.2;
+    double hostThroughputTimeConstant = 300;
+    double maxInFlightMultiple = 0;
+    bool elasticPopulation = false;
+    double elasticPopulationPerClient = 2;
+    int elasticPopulationMaximum = 0;
+    std::vector<double> dispatchWeights = {8, 4, 2, 1, 0}; // requeue, straggler, elite, start population, offspring
+    std::vector<double> dispatchMaximumAges = {0, 0, 0, 0, 0}; // 0 means no age guarantee
+    int eliteReevaluationEvery = 0;
+    int eliteReevaluationCount = 1;
+    double drainTimeLimit = 0; // time allowed for in flight evaluations to return at the end of a run, 0 uses the current lease duration and negative skips the drain
+    int checkpointEvery = 0; // returns between binary checkpoints of the whole run that can be used with --resume, 0 turns them off
+    bool journalEvaluations = false; // write every returned evaluation to a binary journal in the output folder
+    bool binaryPopulations = false; // write population files in the memory mapped binary format (Population_*.bin), both formats are always readable
+    bool snapshotArchive = false; // store the best genomes and populations in one indexed file in the output folder rather than one file each
+    int snapshotArchiveKeep = 0; // snapshots of each kind kept in the archive, 0 keeps them all (onlyKeepBestGenome and onlyKeepBestPopulation keep 1)
+    int populationKeyframeEvery = 0; // population files between full keyframes with the ones in between written as deltas (Population_*.delta), 0 writes them all in full
+    int offspringPrefetch = 16; // offspring bred ahead on their own thread from a copy of the population, 0 breeds each one in the evolve loop when it is needed
 };
 
 #endif // PREFERENCES_H
@@ -8,8 +8,10 @@
  */
 
 #include "Random.h"
+#include "Checkpoint.h"
 
 #include <cmath>
+#include <sstream>
 
 Random::Random()
 {
@@ -109,12 +111,10 @@ bool Random::CoinFlip(double chanceOfReturningTrue)
 // certain.)
 double Random::RandomUnitGaussian()
 {
-    static bool cached = false;
-    static double cachevalue;
-    if (cached == true)
+    if (m_gaussianCached == true)
     {
-        cached = false;
-        return cachevalue;
+        m_gaussianCached = false;
+        return m_gaussianCacheValue;
     }
 
     double rsquare, factor, var1, var2;
@@ -132,9 +132,31 @@ double Random::RandomUnitGaussian()
     else
         factor = 0.0;  // should not happen, but might due to roundoff
 
-    cachevalue = var1 * factor;
-    cached = true;
+    m_gaussianCacheValue = var1 * factor;
+    m_gaussianCached = true;
 
     return (var2 * factor);
 }
 
+// the generator state is saved in its standard text form so that it does not depend on the library internals
+void Random::WriteCheckpoint(Checkpoint *checkpoint) const
+{
+    std::ostringstream state;
+    state << m_randomNumberGenerator;
+    checkpoint->WriteString(state.str());
+    checkpoint->Write(m_gaussianCached);
+    checkpoint->Write(m_gaussianCacheValue);
+}
+
+int Random::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    std::string stateString;
+    checkpoint->ReadString(&stateString);
+    checkpoint->Read(&m_gaussianCached);
+    checkpoint->Read(&m_gaussianCacheValue);
+    if (checkpoint->GetReadError()) return __LINE__;
+    std::istringstream state(stateString);
+    state >> m_randomNumberGenerator;
+    if (state.fail()) return __LINE__;
+    return 0;
+}
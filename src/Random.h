@@ -13,6 +13,8 @@
 #include <random>
 #include <array>
 
+class Checkpoint;
+
 class Random
 {
 public:
@@ -26,10 +28,15 @@ class Random
     double RandomUnitGaussian();
     int GammaBiasedRandomInt(int lowBound, int highBound, double gamma);
 
+    void WriteCheckpoint(Checkpoint *checkpoint) const;
+    int ReadCheckpoint(Checkpoint *checkpoint);
+
 private:
     std::mt19937_64 m_randomNumberGenerator;
     std::vector<int> m_cumulativeRank;
     std::array<int, 2> m_cumulativeRankBounds = {std::numeric_limits<int>::max(), std::numeric_limits<int>::min()};
+    bool m_gaussianCached = false; // per generator rather than static so that the sequence can be checkpointed
+    double m_gaussianCacheValue = 0;
 };
 
 #endif // RANDOM_H
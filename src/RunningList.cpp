@@ -0,0 +1,204 @@
+#include "RunningList.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+RunningList::RunningList(size_t initialCapacity)
+{
+    m_slots.resize(std::bit_ceil(std::max(initialCapacity, size_t(16))));
+    m_mask = m_slots.size() - 1;
+}
+
+RunningList::RunSpecifier *RunningList::Insert(uint64_t runID, std::unique_ptr<Genome> genome, uint64_t sessionID)
+{
+    if ((m_size + 1) * 2 > m_slots.size()) Grow(); // keep the load factor below 0.5 so that probe sequences stay short
+    size_t index = runID & m_mask;
+    while (m_slots[index].inUse) index = (index + 1) & m_mask;
+    RunSpecifier *slot = &m_slots[index];
+    slot->runID = runID;
+    slot->genome = std::move(genome);
+    slot->startTime = 0;
+    slot->leaseExpiry = 0;
+    slot->senderIP = 0;
+    slot->senderPort = 0;
+    slot->sessionID = sessionID;
+    slot->awaitingDispatch = false;
+    slot->reevaluation = false;
+    slot->fromStartPopulation = false;
+    slot->parentRanks = {-1, -1};
+    slot->duplicateTime = 0;
+    slot->duplicateIP = 0;
+    slot->duplicatePort = 0;
+    slot->duplicateSessionID = 0;
+    slot->inUse = true;
+    m_size++;
+    AddToSession(sessionID, runID);
+    return slot;
+}
+
+RunningList::RunSpecifier *RunningList::Find(uint64_t runID)
+{
+    size_t index = FindSlot(runID, std::numeric_limits<uint64_t>::max());
+    if (index == std::numeric_limits<size_t>::max()) return nullptr;
+    return &m_slots[index];
+}
+
+// the table is never larger than 2^32 so the home slot of the full runID and the wire runID are the same
+// and matching the low 32 bits is unique as long as fewer than 2^32 runs are outstanding
+RunningList::RunSpecifier *RunningList::FindWireRunID(uint32_t wireRunID)
+{
+    size_t index = FindSlot(wireRunID, std::numeric_limits<uint32_t>::max());
+    if (index == std::numeric_limits<size_t>::max()) return nullptr;
+    return &m_slots[index];
+}
+
+std::unique_ptr<Genome> RunningList::Take(uint64_t runID)
+{
+    size_t index = FindSlot(runID, std::numeric_limits<uint64_t>::max());
+    if (index == std::numeric_limits<size_t>::max()) return nullptr;
+    std::unique_ptr<Genome> genome = std::move(m_slots[index].genome);
+    RemoveSlot(index);
+    return genome;
+}
+
+void RunningList::Erase(uint64_t runID)
+{
+    size_t index = FindSlot(runID, std::numeric_limits<uint64_t>::max());
+    if (index == std::numeric_limits<size_t>::max()) return;
+    ReleaseGenome(std::move(m_slots[index].genome));
+    RemoveSlot(index);
+}
+
+void RunningList::Clear()
+{
+    for (auto &&slot : m_slots)
+    {
+        if (slot.inUse) ReleaseGenome(std::move(slot.genome));
+        slot = RunSpecifier();
+    }
+    m_size = 0;
+    while (m_sessionRuns.size()) m_sessionNodePool.push_back(m_sessionRuns.extract(m_sessionRuns.begin()));
+}
+
+void RunningList::SetSessionID(RunSpecifier *runSpecifier, uint64_t sessionID)
+{
+    if (runSpecifier->sessionID == sessionID) return;
+    RemoveFromSession(runSpecifier->sessionID, runSpecifier->runID);
+    runSpecifier->sessionID = sessionID;
+    AddToSession(sessionID, runSpecifier->runID);
+}
+
+void RunningList::SetDuplicateSessionID(RunSpecifier *runSpecifier, uint64_t sessionID)
+{
+    if (runSpecifier->duplicateSessionID == sessionID) return;
+    RemoveFromSession(runSpecifier->duplicateSessionID, runSpecifier->runID);
+    runSpecifier->duplicateSessionID = sessionID;
+    AddToSession(sessionID, runSpecifier->runID);
+}
+
+void RunningList::CloseSession(uint64_t sessionID, std::vector<uint64_t> *runIDs)
+{
+    auto iter = m_sessionRuns.find(sessionID);
+    if (iter == m_sessionRuns.end()) return;
+    for (auto &&runID : iter->second)
+    {
+        size_t index = FindSlot(runID, std::numeric_limits<uint64_t>::max());
+        if (index == std::numeric_limits<size_t>::max()) continue;
+        if (m_slots[index].sessionID == sessionID) m_slots[index].sessionID = 0;
+        if (m_slots[index].duplicateSessionID == sessionID) m_slots[index].duplicateSessionID = 0;
+        runIDs->push_back(runID);
+    }
+    m_sessionNodePool.push_back(m_sessionRuns.extract(iter));
+}
+
+size_t RunningList::GetSessionRunCount(uint64_t sessionID) const
+{
+    if (sessionID == 0) return 0;
+    auto iter = m_sessionRuns.find(sessionID);
+    return iter == m_sessionRuns.end() ? 0 : iter->second.size();
+}
+
+void RunningList::AddToSession(uint64_t sessionID, uint64_t runID)
+{
+    if (sessionID == 0) return;
+    auto iter = m_sessionRuns.find(sessionID);
+    if (iter == m_sessionRuns.end())
+    {
+        if (m_sessionNodePool.empty())
+        {
+            iter = m_sessionRuns.emplace(sessionID, std::vector<uint64_t>()).first;
+        }
+        else
+        {
+            auto node = std::move(m_sessionNodePool.back());
+            m_sessionNodePool.pop_back();
+            node.key() = sessionID;
+            node.mapped().clear();
+            iter = m_sessionRuns.insert(std::move(node)).position;
+        }
+    }
+    iter->second.push_back(runID);
+}
+
+void RunningList::RemoveFromSession(uint64_t sessionID, uint64_t runID)
+{
+    if (sessionID == 0) return;
+    auto iter = m_sessionRuns.find(sessionID);
+    if (iter == m_sessionRuns.end()) return;
+    auto runIter = std::find(iter->second.begin(), iter->second.end(), runID);
+    if (runIter != iter->second.end())
+    {
+        *runIter = iter->second.back();
+        iter->second.pop_back();
+    }
+    if (iter->second.empty()) m_sessionNodePool.push_back(m_sessionRuns.extract(iter));
+}
+
+size_t RunningList::FindSlot(uint64_t runID, uint64_t compareMask) const
+{
+    size_t index = runID & m_mask;
+    while (m_slots[index].inUse)
+    {
+        if ((m_slots[index].runID & compareMask) == (runID & compareMask)) return index;
+        index = (index + 1) & m_mask;
+    }
+    return std::numeric_limits<size_t>::max();
+}
+
+// linear probing deletion by shifting later members of the probe sequence back so that no tombstones are needed
+void RunningList::RemoveSlot(size_t index)
+{
+    RemoveFromSession(m_slots[index].sessionID, m_slots[index].runID);
+    RemoveFromSession(m_slots[index].duplicateSessionID, m_slots[index].runID);
+    m_slots[index] = RunSpecifier();
+    m_size--;
+    size_t hole = index;
+    size_t next = index;
+    while (true)
+    {
+        next = (next + 1) & m_mask;
+        if (!m_slots[next].inUse) break;
+        size_t home = m_slots[next].runID & m_mask;
+        // the entry can move into the hole unless its home slot lies cyclically in (hole, next]
+        bool homeBetween = (hole <= next) ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (homeBetween) continue;
+        m_slots[hole] = std::move(m_slots[next]);
+        m_slots[next] = RunSpecifier();
+        hole = next;
+    }
+}
+
+void RunningList::Grow()
+{
+    std::vector<RunSpecifier> oldSlots(m_slots.size() * 2);
+    std::swap(oldSlots, m_slots);
+    m_mask = m_slots.size() - 1;
+    for (auto &&slot : oldSlots)
+    {
+        if (!slot.inUse) continue;
+        size_t index = slot.runID & m_mask;
+        while (m_slots[index].inUse) index = (index + 1) & m_mask;
+        m_slots[index] = std::move(slot);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef RUNNINGLIST_H
+#define RUNNINGLIST_H
+
+#include "Genome.h"
+#include "GenomePool.h"
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <array>
+#include <unordered_map>
+
+// this is the list of genomes that have been sent out for evaluation
+// it is an open addressing table indexed by the runID so that insert, lookup and erase are O(1)
+// without any per entry allocation. Because runIDs are issued sequentially the home slots behave
+// like a ring buffer and collisions only happen when very old runs are still outstanding.
+// The genomes are owned by the list and come from and go back to a genome pool, usually the one shared with the population,
+// so that nothing is copied or allocated.
+// The runs held by each session are indexed as well so that a closed session does not need a scan of the whole list.
+
+class RunningList
+{
+public:
+    struct RunSpecifier
+    {
+        uint64_t runID = 0;
+        std::unique_ptr<Genome> genome;
+        double startTime = 0;
+        double leaseExpiry = 0; // extended by heartbeats from the client
+        uint32_t senderIP = 0;
+        uint32_t senderPort = 0;
+        uint64_t sessionID = 0; // 0 when the session holding the run has closed, only changed through RunningList so that the session index stays correct
+        bool awaitingDispatch = false; // true while the run is queued to be sent to another client
+        bool reevaluation = false; // true if this is a re-evaluation of an elite genome
+        bool fromStartPopulation = false;
+        std::array<int32_t, 2> parentRanks = {-1, -1}; // only kept for the evaluation journal
+        double duplicateTime = 0; // set when a speculative duplicate has been sent to another client
+        uint32_t duplicateIP = 0;
+        uint32_t duplicatePort = 0;
+        uint64_t duplicateSessionID = 0; // also only changed through RunningList
+        bool inUse = false;
+    };
+
+    RunningList(size_t initialCapacity = 1024);
+
+    // note: pointers returned by Insert and Find are invalidated by any subsequent Insert or Erase
+    RunSpecifier *Insert(uint64_t runID, std::unique_ptr<Genome> genome, uint64_t sessionID = 0);
+    RunSpecifier *Find(uint64_t runID);
+    RunSpecifier *FindWireRunID(uint32_t wireRunID); // the network protocol only carries the low 32 bits of the runID
+    std::unique_ptr<Genome> Take(uint64_t runID); // removes the entry and passes ownership of the genome to the caller
+    void Erase(uint64_t runID); // removes the entry and returns the genome to the pool
+    void Clear();
+
+    void SetSessionID(RunSpecifier *runSpecifier, uint64_t sessionID);
+    void SetDuplicateSessionID(RunSpecifier *runSpecifier, uint64_t sessionID);
+    void CloseSession(uint64_t sessionID, std::vector<uint64_t> *runIDs); // removes the session from its runs and appends their runIDs
+    size_t GetSessionRunCount(uint64_t sessionID) const; // runs sent to the session including duplicates
+
+    void SetGenomePool(const std::shared_ptr<GenomePool> &genomePool) { m_genomePool = genomePool; }
+    std::unique_ptr<Genome> AcquireGenome() { return m_genomePool->Acquire(); }
+    void ReleaseGenome(std::unique_ptr<Genome> genome) { m_genomePool->Release(std::move(genome)); }
+
+    size_t GetSize() const { return m_size; }
+    size_t GetCapacity() const { return m_slots.size(); }
+    size_t GetPoolSize() const { return m_genomePool->GetSize(); }
+
+    // iterate over the entries in use - the list must not be modified in the function
+    template<typename Function> void ForEach(Function function) const
+    {
+        for (auto &&slot : m_slots) { if (slot.inUse) function(slot); }
+    }
+
+private:
+    size_t FindSlot(uint64_t runID, uint64_t compareMask) const;
+    void RemoveSlot(size_t index);
+    void Grow();
+    void AddToSession(uint64_t sessionID, uint64_t runID);
+    void RemoveFromSession(uint64_t sessionID, uint64_t runID);
+
+    std::vector<RunSpecifier> m_slots;
+    std::shared_ptr<GenomePool> m_genomePool = GenomePool::Create();
+    std::unordered_map<uint64_t, std::vector<uint64_t>> m_sessionRuns;
+    std::vector<std::unordered_map<uint64_t, std::vector<uint64_t>>::node_type> m_sessionNodePool; // reused so that a new session does not allocate
+    size_t m_mask = 0;
+    size_t m_size = 0;
+};
+
+#endif // RUNNINGLIST_H
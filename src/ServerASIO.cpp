@@ -6,10 +6,11 @@ using namespace std::string_literals;
 
 uint64_t ServerASIO::m_sessionID = 0;
 
-SessionASIO::SessionASIO(asio::ip::tcp::socket &&socket, std::map<std::string, std::function<void (MessageASIO)> > *dispatcher, uint64_t sessionID) :
+SessionASIO::SessionASIO(asio::ip::tcp::socket &&socket, std::map<std::string, std::function<void (MessageASIO)> > *dispatcher, std::function<void (uint64_t)> *closeHandler, uint64_t sessionID) :
     m_socket(std::move(socket))
 {
     m_dispatcher = dispatcher;
+    m_closeHandler = closeHandler;
     m_sessionID = sessionID;
     m_socket.set_option(asio::ip::tcp::tcp::no_delay(true));
     m_socket.set_option(asio::socket_base::linger(false, 0));
@@ -25,10 +26,10 @@ void SessionASIO::write(const char *data, size_t size)
     // need to do prepare and commit for streambuf, the asio::async_write does the consume
     // the input data may need to be mutex locked for this to work
     if (!data || !size) return;
-    std::string encoded = encode(data, size);
-    auto view = m_outgoing.prepare(encoded.size());
-    std::memcpy(view.data(), encoded.data(), encoded.size());
-    m_outgoing.commit(encoded.size());
+    // encode straight into the output buffer which keeps its storage between writes
+    auto view = m_outgoing.prepare(size * 2 + 1);
+    size_t encodedSize = encode(data, size, static_cast<char *>(view.data()));
+    m_outgoing.commit(encodedSize);
     try
     {
         // note: shared_from_this() is required here to guarantee that the SessionASIO does not vanish before the handler is used (using this on its own causes a crash)
@@ -72,6 +73,10 @@ void SessionASIO::on_read(asio::error_code error, std::size_t bytesTransferred)
         dispatch(str);
         read();
     }
+    else
+    {
+        close();
+    }
 }
 
 void SessionASIO::on_write(asio::error_code error, std::size_t bytesTransferred)
@@ -80,6 +85,18 @@ void SessionASIO::on_write(asio::error_code error, std::size_t bytesTransferred)
     {
         m_totalBytesSent += bytesTransferred;
     }
+    else
+    {
+        close();
+    }
+}
+
+// the owner is told about a lost connection once whether it shows up on the read or the write
+void SessionASIO::close()
+{
+    if (m_closed) return;
+    m_closed = true;
+    if (m_closeHandler && *m_closeHandler) (*m_closeHandler)(m_sessionID);
 }
 
 void SessionASIO::dispatch(std::string const& line)
@@ -93,32 +110,40 @@ void SessionASIO::dispatch(std::string const& line)
         MessageASIO message;
         message.session = shared_from_this();
         message.content = decodedLine;
+        message.sessionID = m_sessionID;
         entry(message);
     }
 }
 
 std::string SessionASIO::encode(const char *input, size_t size)
 {
-    std::string output;
-    output.reserve(size * 2 + 1);
+    std::string output(size * 2 + 1, '\0');
+    output.resize(encode(input, size, output.data()));
+    return output;
+}
+
+// output must have space for size * 2 + 1 characters and the encoded size is returned
+size_t SessionASIO::encode(const char *input, size_t size, char *output)
+{
+    char *ptr = output;
     for (size_t i = 0; i < size; i++)
     {
         if (input[i] == '\0')
         {
-            output.push_back('\xff');
-            output.push_back('\x1');
+            *ptr++ = '\xff';
+            *ptr++ = '\x1';
             continue;
         }
         if (input[i] == '\xff')
         {
-            output.push_back('\xff');
-            output.push_back('\x2');
+            *ptr++ = '\xff';
+            *ptr++ = '\x2';
             continue;
         }
-        output.push_back(input[i]);
+        *ptr++ = input[i];
     }
-    output.push_back('\0');
-    return output;
+    *ptr++ = '\0';
+    return size_t(ptr - output);
 }
 
 std::string SessionASIO::decode(const char *input, size_t size)
@@ -225,6 +250,16 @@ void ServerASIO::attach(const std::string &command, std::function<void (MessageA
     m_dispatcher.emplace(command, std::move(function));
 }
 
+void ServerASIO::setCloseHandler(std::function<void (uint64_t)> &&function)
+{
+    m_closeHandler = std::move(function);
+}
+
+void ServerASIO::post(std::function<void ()> &&function)
+{
+    asio::post(m_ioContext, std::move(function));
+}
+
 void ServerASIO::accept()
 {
     if (!m_acceptor.has_value())
@@ -252,7 +287,7 @@ void ServerASIO::acceptHandler(const asio::error_code &errorCode)
     if (!errorCode)
     {
         m_sessionID++;
-        auto session = std::make_shared<SessionASIO>(std::move(*m_socket), &m_dispatcher, m_sessionID);
+        auto session = std::make_shared<SessionASIO>(std::move(*m_socket), &m_dispatcher, &m_closeHandler, m_sessionID);
         session->start();
         accept();
     }
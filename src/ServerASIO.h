@@ -17,31 +17,38 @@ struct MessageASIO
 {
     std::weak_ptr<SessionASIO> session;
     std::string content;
+    uint64_t sessionID = 0;
 };
 
 class SessionASIO : public std::enable_shared_from_this<SessionASIO>
 {
 public:
-    SessionASIO(asio::ip::tcp::socket &&socket, std::map<std::string, std::function<void (MessageASIO)>> *dispatcher, uint64_t sessionID);
+    SessionASIO(asio::ip::tcp::socket &&socket, std::map<std::string, std::function<void (MessageASIO)>> *dispatcher, std::function<void (uint64_t)> *closeHandler, uint64_t sessionID);
 
     void start();
     void write(const char *data, size_t size);
 
+    uint64_t sessionID() const { return m_sessionID; }
+
 private:
     void read();
     void on_read(asio::error_code error, std::size_t bytesTransferred);
     void on_write(asio::error_code error, std::size_t bytesTransferred);
     void dispatch(const std::string &line);
+    void close();
 
     static std::string encode(const char *input, size_t size);
+    static size_t encode(const char *input, size_t size, char *output);
     static std::string decode(const char *input, size_t size);
 
     asio::ip::tcp::socket m_socket;
     std::map<std::string, std::function<void (MessageASIO)> > *m_dispatcher;
+    std::function<void (uint64_t)> *m_closeHandler;
     asio::streambuf m_incoming;
     asio::streambuf m_outgoing;
 
     uint64_t m_sessionID = 0;
+    bool m_closed = false;
     size_t m_totalBytesSent = 0;
     size_t m_totalBytesReceived = 0;
 };
@@ -56,6 +63,8 @@ class ServerASIO
     void start();
     void stop();
     void attach(const std::string &command, std::function<void (MessageASIO)> &&function);
+    void setCloseHandler(std::function<void (uint64_t)> &&function); // called with the sessionID when a connection is lost
+    void post(std::function<void ()> &&function); // runs the function on the server thread
 
     void getLocalAddress(std::array<uint8_t, 4> *ipAddress, uint16_t *port);
 
@@ -68,6 +77,7 @@ class ServerASIO
     std::optional<asio::ip::tcp::tcp::acceptor> m_acceptor;
     std::optional<asio::ip::tcp::tcp::socket> m_socket;
     std::map<std::string, std::function<void (MessageASIO)> > m_dispatcher;
+    std::function<void (uint64_t)> m_closeHandler;
 
     static uint64_t m_sessionID;
 };
@@ -0,0 +1,395 @@
+#include "SnapshotArchive.h"
+#include "Checkpoint.h"
+
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+
+static const char s_archiveMagic[8] = {'A', 'G', 'A', '4', 'S', 'N', 'A', 'P'};
+static const char s_indexMagic[8] = {'A', 'G', 'A', '4', 'S', 'I', 'D', 'X'};
+static const char s_entryMagic[4] = {'S', 'N', 'P', 'E'};
+static const char s_tombstoneMagic[4] = {'S', 'N', 'P', 'T'};
+static const uint32_t s_archiveVersion = 2; // version 2 added tombstones and version 1 archives can still be read
+
+SnapshotArchive::~SnapshotArchive()
+{
+    Close();
+}
+
+void SnapshotArchive::Clear()
+{
+    m_open = false;
+    if (m_file.is_open()) m_file.close();
+    m_file.clear();
+    m_filename.clear();
+    m_entries.clear();
+    m_dataEnd = 0;
+    m_liveBytes = 0;
+    m_deadBytes = 0;
+    m_createdTime = 0;
+    m_version = 0;
+    m_readOnly = false;
+    m_recovered = false;
+    m_indexWritten = false;
+}
+
+int SnapshotArchive::Open(const std::string &filename, bool readOnly)
+{
+    Close();
+    std::error_code errorCode;
+    if (!std::filesystem::exists(filename, errorCode))
+    {
+        if (readOnly) return __LINE__;
+        FileHeader header = {};
+        std::memcpy(header.magic, s_archiveMagic, sizeof(header.magic));
+        header.version = s_archiveVersion;
+        header.createdTime = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        std::ofstream outFile(filename, std::ios::binary | std::ios::trunc);
+        if (!outFile) return __LINE__;
+        outFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        m_dataEnd = sizeof(header);
+        uint64_t fileSize = 0;
+        if (WriteIndex(&outFile, m_entries, m_dataEnd, &fileSize)) return __LINE__;
+        outFile.close();
+        if (!outFile) return __LINE__;
+    }
+
+    std::ifstream inFile(filename, std::ios::binary);
+    if (!inFile) return __LINE__;
+    FileHeader header = {};
+    if (!inFile.read(reinterpret_cast<char *>(&header), sizeof(header))) return __LINE__;
+    if (std::memcmp(header.magic, s_archiveMagic, sizeof(header.magic)) != 0 || header.version < 1 || header.version > s_archiveVersion) return __LINE__;
+    uint64_t fileSize = std::filesystem::file_size(filename, errorCode);
+    if (errorCode) return __LINE__;
+    if (ReadIndex(&inFile, fileSize))
+    {
+        m_entries.clear();
+        m_liveBytes = 0;
+        inFile.clear();
+        if (Recover(&inFile, fileSize)) { Clear(); return __LINE__; }
+    }
+    else
+    {
+        m_indexWritten = true;
+    }
+    m_createdTime = header.createdTime;
+    m_deadBytes = m_dataEnd - sizeof(FileHeader) - m_liveBytes;
+    m_version = header.version;
+    m_readOnly = readOnly;
+    m_filename = filename;
+    m_open = true;
+    return 0;
+}
+
+// the index goes after the last entry and anything beyond it, such as part of an entry that failed to write, is cut off
+int SnapshotArchive::Close()
+{
+    int err = 0;
+    if (m_open && !m_readOnly && !m_indexWritten)
+    {
+        uint64_t fileSize = 0;
+        if (StartAppending() || WriteIndex(&m_file, m_entries, m_dataEnd, &fileSize)) err = __LINE__;
+        m_file.close();
+        if (!err && !m_file) err = __LINE__;
+        std::error_code errorCode;
+        if (!err) std::filesystem::resize_file(m_filename, fileSize, errorCode);
+        if (!err && errorCode) err = __LINE__;
+    }
+    Clear();
+    return err;
+}
+
+// the first add after opening or compacting cuts off the index so that a crash before the archive is closed
+// cannot leave an index that is missing the newer entries, and the archive is recovered by walking the entries instead
+int SnapshotArchive::StartAppending()
+{
+    if (m_file.is_open()) return 0;
+    std::error_code errorCode;
+    std::filesystem::resize_file(m_filename, m_dataEnd, errorCode);
+    if (errorCode) return __LINE__;
+    m_indexWritten = false;
+    m_file.clear();
+    m_file.open(m_filename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!m_file) return __LINE__;
+    if (m_version != s_archiveVersion)
+    {
+        // tombstones may be written from now on so a reader that does not know about them has to refuse the file
+        m_file.seekp(std::streamoff(offsetof(FileHeader, version)));
+        m_file.write(reinterpret_cast<const char *>(&s_archiveVersion), sizeof(s_archiveVersion));
+        if (!m_file) { m_file.close(); return __LINE__; }
+        m_version = s_archiveVersion;
+    }
+    return 0;
+}
+
+// the new entry is written after the last one followed by a tombstone for each snapshot that is dropped
+// and the in memory index is only changed once they are all written so a failed add changes nothing
+// a crash part way through loses at most the new entry or brings back the snapshots it would have dropped
+int SnapshotArchive::Add(Kind kind, const std::string &name, const std::string &md5, const std::string &contents, size_t keep)
+{
+    if (!m_open || m_readOnly) return __LINE__;
+    if (StartAppending()) return __LINE__;
+
+    std::vector<size_t> dropped;
+    if (keep)
+    {
+        size_t count = size_t(std::count_if(m_entries.begin(), m_entries.end(), [kind](const Entry &e) { return e.kind == kind; })) + 1;
+        for (size_t i = 0; i < m_entries.size() && count > keep; i++)
+        {
+            if (m_entries[i].kind != kind) continue;
+            dropped.push_back(i);
+            count--;
+        }
+    }
+
+    EntryHeader header = {};
+    std::memcpy(header.magic, s_entryMagic, sizeof(header.magic));
+    header.kind = kind;
+    header.nameLength = uint32_t(name.size());
+    header.md5Length = uint32_t(md5.size());
+    header.contentsSize = contents.size();
+    size_t entrySize = sizeof(header) + name.size() + md5.size() + contents.size();
+    size_t tombstoneSize = sizeof(EntryHeader) + sizeof(uint64_t);
+    std::string record;
+    record.reserve(entrySize + dropped.size() * tombstoneSize);
+    record.append(sizeof(header), '\0').append(name).append(md5).append(contents);
+    header.checksum = Checkpoint::Checksum(record.data() + sizeof(header), record.size() - sizeof(header));
+    std::memcpy(record.data(), &header, sizeof(header));
+    for (auto &&index : dropped)
+    {
+        EntryHeader tombstone = {};
+        std::memcpy(tombstone.magic, s_tombstoneMagic, sizeof(tombstone.magic));
+        tombstone.kind = m_entries[index].kind;
+        tombstone.contentsSize = sizeof(uint64_t);
+        tombstone.checksum = Checkpoint::Checksum(reinterpret_cast<const char *>(&m_entries[index].offset), sizeof(uint64_t));
+        record.append(reinterpret_cast<const char *>(&tombstone), sizeof(tombstone));
+        record.append(reinterpret_cast<const char *>(&m_entries[index].offset), sizeof(uint64_t));
+    }
+
+    m_file.seekp(std::streamoff(m_dataEnd));
+    m_file.write(record.data(), std::streamsize(record.size()));
+    m_file.flush();
+    if (!m_file)
+    {
+        m_file.clear(); // the next add writes over whatever got as far as the file
+        return __LINE__;
+    }
+
+    for (size_t i = dropped.size(); i > 0; i--)
+    {
+        m_liveBytes -= m_entries[dropped[i - 1]].size;
+        m_deadBytes += m_entries[dropped[i - 1]].size + tombstoneSize;
+        m_entries.erase(m_entries.begin() + ptrdiff_t(dropped[i - 1]));
+    }
+    m_entries.push_back({m_dataEnd, entrySize, kind, name, md5});
+    m_liveBytes += entrySize;
+    m_dataEnd += record.size();
+
+    if (m_deadBytes > m_liveBytes && m_deadBytes > m_minCompactBytes)
+    {
+        if (Compact()) return __LINE__; // the snapshot was added and the archive carries on uncompacted
+    }
+    return 0;
+}
+
+bool SnapshotArchive::Contains(const std::string &name) const
+{
+    return std::any_of(m_entries.begin(), m_entries.end(), [&name](const Entry &e) { return e.name == name; });
+}
+
+int SnapshotArchive::ReadContents(size_t i, std::string *contents) const
+{
+    if (i >= m_entries.size()) return __LINE__;
+    const Entry &entry = m_entries[i];
+    std::ifstream inFile(m_filename, std::ios::binary);
+    if (!inFile) return __LINE__;
+    inFile.seekg(std::streamoff(entry.offset));
+    EntryHeader header = {};
+    if (!inFile.read(reinterpret_cast<char *>(&header), sizeof(header))) return __LINE__;
+    if (sizeof(header) + header.nameLength + header.md5Length + header.contentsSize != entry.size) return __LINE__;
+    std::string payload(size_t(entry.size - sizeof(header)), '\0');
+    if (!inFile.read(payload.data(), std::streamsize(payload.size()))) return __LINE__;
+    if (Checkpoint::Checksum(payload.data(), payload.size()) != header.checksum) return __LINE__;
+    contents->assign(payload, header.nameLength + header.md5Length, std::string::npos);
+    return 0;
+}
+
+int SnapshotArchive::Extract(size_t i, const std::string &folder) const
+{
+    if (i >= m_entries.size()) return __LINE__;
+    const Entry &entry = m_entries[i];
+    if (entry.name.empty() || entry.name.find_first_of("/\\:") != std::string::npos || entry.name == "." || entry.name == "..") return __LINE__;
+    std::string contents;
+    if (ReadContents(i, &contents)) return __LINE__;
+    std::vector<std::pair<std::string, std::string>> files = {{entry.name, contents}};
+    if (entry.md5.size()) files.push_back({entry.name + ".md5", entry.md5 + "\n"});
+    for (auto &&file : files)
+    {
+        std::filesystem::path path = std::filesystem::path(folder) / file.first;
+        std::string temporaryFilename = path.string() + ".tmp";
+        {
+            std::ofstream outFile(temporaryFilename, std::ios::binary | std::ios::trunc);
+            if (!outFile) return __LINE__;
+            outFile.write(file.second.data(), std::streamsize(file.second.size()));
+            outFile.close();
+            if (!outFile) { std::remove(temporaryFilename.c_str()); return __LINE__; }
+        }
+        std::error_code errorCode;
+        std::filesystem::rename(temporaryFilename, path, errorCode);
+        if (errorCode) return __LINE__;
+    }
+    return 0;
+}
+
+int SnapshotArchive::ReadIndex(std::istream *file, uint64_t fileSize)
+{
+    if (fileSize < sizeof(FileHeader) + sizeof(Trailer)) return __LINE__;
+    Trailer trailer = {};
+    file->seekg(std::streamoff(fileSize - sizeof(Trailer)));
+    if (!file->read(reinterpret_cast<char *>(&trailer), sizeof(trailer))) return __LINE__;
+    if (std::memcmp(trailer.magic, s_indexMagic, sizeof(trailer.magic)) != 0) return __LINE__;
+    if (trailer.indexOffset < sizeof(FileHeader) || trailer.indexSize > fileSize || trailer.indexOffset + trailer.indexSize + sizeof(Trailer) != fileSize) return __LINE__;
+    std::vector<char> index(size_t(trailer.indexSize));
+    file->seekg(std::streamoff(trailer.indexOffset));
+    if (!file->read(index.data(), std::streamsize(index.size()))) return __LINE__;
+    if (Checkpoint::Checksum(index.data(), index.size()) != trailer.indexChecksum) return __LINE__;
+
+    Checkpoint buffer;
+    buffer.Assign(index.data(), index.size());
+    uint64_t count = 0;
+    buffer.Read(&count);
+    for (uint64_t i = 0; i < count && !buffer.GetReadError(); i++)
+    {
+        Entry entry = {};
+        buffer.Read(&entry.offset);
+        buffer.Read(&entry.size);
+        buffer.Read(&entry.kind);
+        buffer.ReadString(&entry.name);
+        buffer.ReadString(&entry.md5);
+        if (entry.offset < sizeof(FileHeader) || entry.size > trailer.indexOffset || entry.offset + entry.size > trailer.indexOffset) return __LINE__;
+        m_liveBytes += entry.size;
+        m_entries.push_back(std::move(entry));
+    }
+    if (buffer.GetReadError() || !buffer.AtEnd()) return __LINE__;
+    m_dataEnd = trailer.indexOffset;
+    return 0;
+}
+
+// walks the entry headers from the start and stops at the first one that is incomplete or fails its checksum
+// a tombstone removes the earlier entry it names
+int SnapshotArchive::Recover(std::istream *file, uint64_t fileSize)
+{
+    uint64_t offset = sizeof(FileHeader);
+    std::string payload;
+    while (fileSize - offset >= sizeof(EntryHeader))
+    {
+        EntryHeader header = {};
+        file->seekg(std::streamoff(offset));
+        if (!file->read(reinterpret_cast<char *>(&header), sizeof(header))) break;
+        bool tombstone = std::memcmp(header.magic, s_tombstoneMagic, sizeof(header.magic)) == 0;
+        if (!tombstone && std::memcmp(header.magic, s_entryMagic, sizeof(header.magic)) != 0) break;
+        uint64_t payloadSize = uint64_t(header.nameLength) + header.md5Length + header.contentsSize;
+        if (payloadSize > fileSize - offset - sizeof(header)) break;
+        payload.resize(size_t(payloadSize));
+        if (!file->read(payload.data(), std::streamsize(payload.size()))) break;
+        if (Checkpoint::Checksum(payload.data(), payload.size()) != header.checksum) break;
+        if (tombstone)
+        {
+            uint64_t droppedOffset = 0;
+            if (payloadSize != sizeof(droppedOffset)) break;
+            std::memcpy(&droppedOffset, payload.data(), sizeof(droppedOffset));
+            auto iter = std::find_if(m_entries.begin(), m_entries.end(), [droppedOffset](const Entry &e) { return e.offset == droppedOffset; });
+            if (iter != m_entries.end())
+            {
+                m_liveBytes -= iter->size;
+                m_entries.erase(iter);
+            }
+            offset += sizeof(header) + payloadSize;
+            continue;
+        }
+        Entry entry = {offset, sizeof(header) + payloadSize, header.kind, payload.substr(0, header.nameLength), payload.substr(header.nameLength, header.md5Length)};
+        offset += entry.size;
+        m_liveBytes += entry.size;
+        m_entries.push_back(std::move(entry));
+    }
+    m_dataEnd = offset;
+    m_recovered = true;
+    return 0;
+}
+
+// the index goes immediately after the last entry
+int SnapshotArchive::WriteIndex(std::ostream *file, const std::vector<Entry> &entries, uint64_t dataEnd, uint64_t *fileSize)
+{
+    Checkpoint buffer;
+    buffer.Write(uint64_t(entries.size()));
+    for (auto &&entry : entries)
+    {
+        buffer.Write(entry.offset);
+        buffer.Write(entry.size);
+        buffer.Write(entry.kind);
+        buffer.WriteString(entry.name);
+        buffer.WriteString(entry.md5);
+    }
+    Trailer trailer = {};
+    trailer.indexOffset = dataEnd;
+    trailer.indexSize = buffer.GetSize();
+    trailer.indexChecksum = Checkpoint::Checksum(buffer.GetData(), buffer.GetSize());
+    std::memcpy(trailer.magic, s_indexMagic, sizeof(trailer.magic));
+    file->seekp(std::streamoff(dataEnd));
+    file->write(buffer.GetData(), std::streamsize(buffer.GetSize()));
+    file->write(reinterpret_cast<const char *>(&trailer), sizeof(trailer));
+    if (!*file) return __LINE__;
+    *fileSize = dataEnd + buffer.GetSize() + sizeof(trailer);
+    return 0;
+}
+
+// copies the live entries into a new file with a full index which then replaces the old one
+// if anything fails the old file is left as it was and the archive carries on using it
+int SnapshotArchive::Compact()
+{
+    std::string temporaryFilename = m_filename + ".tmp";
+    std::vector<Entry> entries = m_entries;
+    uint64_t dataEnd = sizeof(FileHeader);
+    if (m_file.is_open() && !m_file.flush()) return __LINE__;
+    {
+        std::ifstream inFile(m_filename, std::ios::binary);
+        std::ofstream outFile(temporaryFilename, std::ios::binary | std::ios::trunc);
+        if (!inFile || !outFile) return __LINE__;
+        FileHeader header = {};
+        std::memcpy(header.magic, s_archiveMagic, sizeof(header.magic));
+        header.version = s_archiveVersion;
+        header.createdTime = m_createdTime;
+        outFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        std::vector<char> buffer;
+        for (auto &&entry : entries)
+        {
+            buffer.resize(size_t(entry.size));
+            inFile.seekg(std::streamoff(entry.offset));
+            if (!inFile.read(buffer.data(), std::streamsize(buffer.size()))) { outFile.close(); std::remove(temporaryFilename.c_str()); return __LINE__; }
+            outFile.write(buffer.data(), std::streamsize(buffer.size()));
+            entry.offset = dataEnd;
+            dataEnd += entry.size;
+        }
+        uint64_t fileSize = 0;
+        int err = WriteIndex(&outFile, entries, dataEnd, &fileSize);
+        outFile.close();
+        if (err || !outFile) { std::remove(temporaryFilename.c_str()); return __LINE__; }
+    }
+    // the next add opens the new file and cuts off its index
+    m_file.close();
+    m_file.clear();
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryFilename, m_filename, errorCode);
+    if (errorCode) { std::remove(temporaryFilename.c_str()); return __LINE__; }
+    m_entries = std::move(entries);
+    m_dataEnd = dataEnd;
+    m_deadBytes = 0;
+    m_version = s_archiveVersion;
+    m_indexWritten = true;
+    return 0;
+}
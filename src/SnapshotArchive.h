@@ -0,0 +1,110 @@
+#ifndef SNAPSHOTARCHIVE_H
+#define SNAPSHOTARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// a single file holding the best genome and population snapshots of a run
+// each snapshot is stored as the text that would have gone into its own file, under that file's name, so that
+// extracting it gives exactly what the separate files used to contain. New snapshots are appended after the last one
+// so adding one only writes that snapshot. An index of the live snapshots and a fixed size trailer are written after
+// the last entry when the archive is closed or compacted, so opening a closed archive only needs to read the end of the file.
+// Without an index, after a crash or while the archive is still being written, the snapshots are found by walking their headers.
+// keeping only the last few snapshots of a kind drops them from the index and appends a tombstone naming each one
+// so that the walk does not bring them back, and the file is compacted once the dropped snapshots and tombstones
+// take up more space than the live ones
+
+class SnapshotArchive
+{
+public:
+    enum Kind : uint32_t { BestGenome = 0, Population = 1 };
+
+    struct Entry
+    {
+        uint64_t offset; // start of the entry header in the file
+        uint64_t size; // header, name, md5 and contents
+        uint32_t kind;
+        std::string name;
+        std::string md5; // MD5 of the base XML file for populations, empty otherwise
+    };
+
+    SnapshotArchive() = default;
+    ~SnapshotArchive();
+
+    SnapshotArchive(const SnapshotArchive &) = delete;
+    SnapshotArchive &operator=(const SnapshotArchive &) = delete;
+
+    // a missing archive is created unless readOnly is set
+    int Open(const std::string &filename, bool readOnly = false);
+    int Close(); // writes the index if anything has been added
+
+    // keep is the number of snapshots of this kind to keep including the new one, 0 keeps them all
+    // a failed add leaves the archive as it was
+    int Add(Kind kind, const std::string &name, const std::string &md5, const std::string &contents, size_t keep);
+
+    bool IsOpen() const { return m_open; } // can be checked from other threads
+    const std::string &GetFilename() const { return m_filename; }
+    size_t GetSize() const { return m_entries.size(); }
+    const Entry &GetEntry(size_t i) const { return m_entries[i]; }
+    bool Contains(const std::string &name) const;
+    int ReadContents(size_t i, std::string *contents) const;
+    int Extract(size_t i, const std::string &folder) const; // writes the snapshot file and its md5 record if it has one
+    void SetMinCompactBytes(uint64_t bytes) { m_minCompactBytes = bytes; }
+    bool GetRecovered() const { return m_recovered; }
+    uint64_t GetDeadBytes() const { return m_deadBytes; }
+
+private:
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        double createdTime; // seconds since the epoch
+    };
+
+    struct EntryHeader
+    {
+        char magic[4];
+        uint32_t kind;
+        uint32_t nameLength;
+        uint32_t md5Length;
+        uint64_t contentsSize;
+        uint64_t checksum; // name, md5 and contents
+    };
+
+    struct Trailer
+    {
+        uint64_t indexOffset;
+        uint64_t indexSize;
+        uint64_t indexChecksum;
+        char magic[8];
+    };
+
+    int ReadIndex(std::istream *file, uint64_t fileSize);
+    int Recover(std::istream *file, uint64_t fileSize);
+    static int WriteIndex(std::ostream *file, const std::vector<Entry> &entries, uint64_t dataEnd, uint64_t *fileSize);
+    int StartAppending();
+    int Compact();
+    void Clear();
+
+    std::string m_filename;
+    std::fstream m_file; // kept open between adds once appending has started
+    std::vector<Entry> m_entries;
+    uint64_t m_dataEnd = 0; // new entries go here, over the old index
+    uint64_t m_liveBytes = 0;
+    uint64_t m_deadBytes = 0;
+    double m_createdTime = 0;
+    uint32_t m_version = 0;
+    bool m_readOnly = false;
+    bool m_recovered = false;
+    bool m_indexWritten = false; // the file ends with an index that matches the entries
+    std::atomic<bool> m_open = false;
+    uint64_t m_minCompactBytes = uint64_t(1) << 20;
+};
+
+#endif // SNAPSHOTARCHIVE_H
@@ -0,0 +1,83 @@
+#include "TimerWheel.h"
+
+#include <cmath>
+#include <algorithm>
+
+TimerWheel::TimerWheel(double resolution)
+{
+    m_resolution = resolution;
+}
+
+void TimerWheel::Initialise(double currentTime)
+{
+    Clear();
+    m_currentTick = uint64_t(std::max(0.0, std::floor(currentTime / m_resolution)));
+}
+
+void TimerWheel::Clear()
+{
+    for (auto &&level : m_wheels)
+        for (auto &&slot : level) slot.clear();
+    m_size = 0;
+}
+
+void TimerWheel::Schedule(uint64_t id, uint32_t type, double expiryTime)
+{
+    double tick = std::ceil(expiryTime / m_resolution);
+    Timer timer;
+    timer.id = id;
+    timer.type = type;
+    timer.expiryTick = tick > double(m_currentTick) ? uint64_t(tick) : m_currentTick + 1; // timers never fire in the current tick
+    Place(timer);
+    m_size++;
+}
+
+// a timer goes in the lowest level where it shares all the higher order bits with the current tick
+// so that it is always cascaded down before it is due
+void TimerWheel::Place(const Timer &timer)
+{
+    uint64_t tick = timer.expiryTick;
+    uint64_t maxTick = m_currentTick | ((uint64_t(1) << (kSlotBits * kLevels)) - 1);
+    if (tick > maxTick) tick = maxTick; // very long timers are parked at the end of the top level and placed again when they come round
+    for (int level = 0; level < kLevels; level++)
+    {
+        int shift = kSlotBits * (level + 1);
+        if (level == kLevels - 1 || (tick >> shift) == (m_currentTick >> shift))
+        {
+            m_wheels[level][(tick >> (kSlotBits * level)) & kSlotMask].push_back(timer);
+            return;
+        }
+    }
+}
+
+void TimerWheel::Advance(double currentTime, std::vector<Timer> *expired)
+{
+    uint64_t targetTick = uint64_t(std::max(0.0, std::floor(currentTime / m_resolution)));
+    while (m_currentTick < targetTick)
+    {
+        m_currentTick++;
+
+        // cascade from the highest level that has just wrapped so that each level can refill the one below
+        int cascadeLevel = 0;
+        while (cascadeLevel < kLevels - 1 && (m_currentTick & ((uint64_t(1) << (kSlotBits * (cascadeLevel + 1))) - 1)) == 0) cascadeLevel++;
+        for (int level = cascadeLevel; level > 0; level--)
+        {
+            std::vector<Timer> &slot = m_wheels[level][(m_currentTick >> (kSlotBits * level)) & kSlotMask];
+            if (slot.empty()) continue;
+            m_cascade.swap(slot);
+            for (auto &&timer : m_cascade) Place(timer);
+            m_cascade.clear();
+        }
+
+        std::vector<Timer> &slot = m_wheels[0][m_currentTick & kSlotMask];
+        if (slot.empty()) continue;
+        m_cascade.swap(slot);
+        for (auto &&timer : m_cascade)
+        {
+            if (timer.expiryTick > m_currentTick) { Place(timer); continue; }
+            expired->push_back(timer);
+            m_size--;
+        }
+        m_cascade.clear();
+    }
+}
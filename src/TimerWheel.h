@@ -0,0 +1,49 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// hierarchical timing wheel
+// scheduling a timer is O(1) and advancing the wheel costs O(number of expired timers) plus a small
+// amount of cascading work. Timers cannot be cancelled so the owner should check whether a timer
+// that fires is still relevant (lazy cancellation).
+
+class TimerWheel
+{
+public:
+    TimerWheel(double resolution = 0.1);
+
+    struct Timer
+    {
+        uint64_t id;
+        uint32_t type;
+        uint64_t expiryTick;
+    };
+
+    void Initialise(double currentTime);
+    void Schedule(uint64_t id, uint32_t type, double expiryTime);
+    void Advance(double currentTime, std::vector<Timer> *expired); // expired timers are appended to the list
+    void Clear();
+
+    size_t GetSize() const { return m_size; }
+    double GetResolution() const { return m_resolution; }
+
+private:
+    static const int kLevels = 4;
+    static const int kSlotBits = 8;
+    static const uint64_t kSlots = 1 << kSlotBits;
+    static const uint64_t kSlotMask = kSlots - 1;
+
+    void Place(const Timer &timer);
+
+    std::array<std::array<std::vector<Timer>, kSlots>, kLevels> m_wheels;
+    std::vector<Timer> m_cascade;
+    double m_resolution = 0.1;
+    uint64_t m_currentTick = 0;
+    size_t m_size = 0;
+};
+
+#endif // TIMERWHEEL_H
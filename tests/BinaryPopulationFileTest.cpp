@@ -0,0 +1,102 @@
+#include "../src/BinaryPopulationFile.h"
+#include "../src/Population.h"
+#include "../src/Genome.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+// checks that a population written in the binary format reads back bit for bit, both in place and through
+// Population which recognises the format itself, and that a damaged file is refused
+static bool Same(const Genome &lhs, const Genome &rhs)
+{
+    return lhs.GetGenomeType() == rhs.GetGenomeType() && lhs.GetFitness() == rhs.GetFitness() && *lhs.GetGenes() == *rhs.GetGenes() && *lhs.GetLowBounds() == *rhs.GetLowBounds() &&
+           *lhs.GetHighBounds() == *rhs.GetHighBounds() && *lhs.GetGaussianSDs() == *rhs.GetGaussianSDs() && *lhs.GetCircularMutationFlags() == *rhs.GetCircularMutationFlags();
+}
+
+static std::vector<std::shared_ptr<const Genome>> ReadAll(const std::string &filename)
+{
+    std::vector<std::shared_ptr<const Genome>> genomes;
+    Population::ReadGenomes(filename.c_str(), [&genomes](std::unique_ptr<Genome> genome, size_t) { genomes.push_back(std::move(genome)); return true; });
+    return genomes;
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    const size_t populationSize = 100;
+    const size_t genomeLength = 13;
+    std::string textFile = "BinaryPopulationFileTest.txt";
+    std::string binaryFile = "BinaryPopulationFileTest.bin";
+    {
+        // the last genome uses circular mutation so the file needs two schemas
+        std::ofstream outFile(textFile);
+        outFile.precision(17);
+        outFile << populationSize << "\n";
+        for (size_t i = 0; i < populationSize; i++)
+        {
+            bool circular = i == populationSize - 1;
+            outFile << (circular ? "-2\n" : "-1\n") << genomeLength << "\n";
+            for (size_t j = 0; j < genomeLength; j++) outFile << (double(i * 7 + j) / 3.0) << "\t-1\t100\t0.1" << (circular ? "\t1\n" : "\n");
+            outFile << (1000.0 - double(i) / 7.0) << "\t0\t0\t0\t0\n";
+        }
+    }
+
+    std::vector<std::shared_ptr<const Genome>> textGenomes = ReadAll(textFile);
+    if (textGenomes.size() != populationSize) errors++;
+    if (BinaryPopulationFile::Write(binaryFile, textGenomes)) errors++;
+    if (!BinaryPopulationFile::IsBinaryPopulationFile(binaryFile) || BinaryPopulationFile::IsBinaryPopulationFile(textFile)) errors++;
+
+    BinaryPopulationFile file;
+    if (file.Open(binaryFile) || file.GetPopulationSize() != populationSize || file.GetGenomeLength() != genomeLength || file.GetSchemaCount() != 2) errors++;
+    Genome genome;
+    for (size_t i = 0; i < file.GetPopulationSize() && i < textGenomes.size(); i++)
+    {
+        if (file.GetGenes(i)[genomeLength - 1] != textGenomes[i]->GetGene(genomeLength - 1) || file.GetFitness(i) != textGenomes[i]->GetFitness()) errors++;
+        file.GetGenome(i, &genome);
+        if (!Same(genome, *textGenomes[i])) errors++;
+    }
+    file.Close();
+
+    std::vector<std::shared_ptr<const Genome>> binaryGenomes = ReadAll(binaryFile);
+    if (binaryGenomes.size() != populationSize) errors++;
+    for (size_t i = 0; i < binaryGenomes.size() && i < textGenomes.size(); i++) { if (!Same(*binaryGenomes[i], *textGenomes[i])) errors++; }
+
+    Population textPopulation, binaryPopulation;
+    if (textPopulation.ReadPopulation(textFile.c_str()) || binaryPopulation.ReadPopulation(binaryFile.c_str())) errors++;
+    if (textPopulation.GetPopulationSize() != binaryPopulation.GetPopulationSize()) errors++;
+    for (size_t i = 0; i < textPopulation.GetPopulationSize() && i < binaryPopulation.GetPopulationSize(); i++) { if (!Same(*textPopulation.GetGenome(i), *binaryPopulation.GetGenome(i))) errors++; }
+
+    // the shortest text written back reads to the same doubles as the original 17 digit text
+    std::string roundTripFile = "BinaryPopulationFileTest_roundtrip.txt";
+    if (Population::WriteGenomes(roundTripFile.c_str(), binaryGenomes)) errors++;
+    std::vector<std::shared_ptr<const Genome>> roundTripGenomes = ReadAll(roundTripFile);
+    if (roundTripGenomes.size() != populationSize) errors++;
+    for (size_t i = 0; i < roundTripGenomes.size() && i < textGenomes.size(); i++) { if (!Same(*roundTripGenomes[i], *textGenomes[i])) errors++; }
+
+    // irregular layout is still read, just not in parallel
+    {
+        std::ofstream outFile(roundTripFile, std::ios::trunc);
+        outFile << "2\n-1 2 +0.5 0 1 0.1 0.25 0 1 0.1\n7 0 0 0 0\n-1\n2\n1\t0\t1\t0.1\r\n2\t0\t1\t0.1\r\n8\t0\t0\t0\t0\n";
+    }
+    std::vector<std::shared_ptr<const Genome>> irregularGenomes = ReadAll(roundTripFile);
+    if (irregularGenomes.size() != 2 || irregularGenomes[0]->GetGene(0) != 0.5 || irregularGenomes[1]->GetFitness() != 8) errors++;
+    std::remove(roundTripFile.c_str());
+
+    // a file that has been cut short is refused rather than read past its end
+    std::vector<char> contents;
+    {
+        std::ifstream inFile(binaryFile, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(inFile), std::istreambuf_iterator<char>());
+    }
+    std::ofstream(binaryFile, std::ios::binary | std::ios::trunc).write(contents.data(), std::streamsize(contents.size() - 8));
+    if (file.Open(binaryFile) == 0) errors++;
+    if (ReadAll(binaryFile).size()) errors++;
+
+    std::remove(textFile.c_str());
+    std::remove(binaryFile.c_str());
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
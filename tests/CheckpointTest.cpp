@@ -0,0 +1,128 @@
+#include "../src/Checkpoint.h"
+#include "../src/Population.h"
+#include "../src/Genome.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <numeric>
+#include <cstdio>
+#include <filesystem>
+
+// checks that a population restored from a checkpoint carries on exactly as the original would have,
+// that a corrupt or truncated checkpoint file is refused and that a snapshot is not changed by later evolution
+static void Configure(Population *population)
+{
+    population->SetSelectionType(SqrtBasedSelection);
+    population->SetParentsToKeep(5);
+    population->SetCrossoverChance(0.5);
+    population->SetCrossoverType(Mating::OnePoint);
+    population->SetGaussianMutationChance(0.1);
+    population->SetMultipleGaussian(true);
+}
+
+static void Evolve(Population *population, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        auto offspring = std::make_unique<Genome>();
+        population->GetOffspring(offspring.get());
+        offspring->SetFitness(std::accumulate(offspring->GetGenes()->begin(), offspring->GetGenes()->end(), 0.0));
+        population->InsertGenome(std::move(offspring), 0);
+    }
+}
+
+static bool Same(Population *lhs, Population *rhs)
+{
+    if (lhs->GetPopulationSize() != rhs->GetPopulationSize()) return false;
+    for (size_t i = 0; i < lhs->GetPopulationSize(); i++)
+    {
+        if (lhs->GetGenome(i)->GetFitness() != rhs->GetGenome(i)->GetFitness()) return false;
+        if (*lhs->GetGenome(i)->GetGenes() != *rhs->GetGenome(i)->GetGenes()) return false;
+    }
+    return true;
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    const size_t populationSize = 100;
+    const size_t genomeLength = 20;
+
+    std::string populationFile = "CheckpointTest_population.txt";
+    {
+        std::ofstream outFile(populationFile);
+        outFile << populationSize << "\n";
+        for (size_t i = 0; i < populationSize; i++)
+        {
+            outFile << "-1\n" << genomeLength << "\n";
+            for (size_t j = 0; j < genomeLength; j++) outFile << (double((i + j) % 17) / 17.0) << "\t-1\t1\t0.1\n";
+            outFile << double(i) << "\t0\t0\t0\t0\n";
+        }
+    }
+    Population original;
+    Configure(&original);
+    if (original.ReadPopulation(populationFile.c_str())) errors++;
+    std::remove(populationFile.c_str());
+    Evolve(&original, 1000);
+
+    // round trip through a file and then both populations are given the same work
+    std::string checkpointFile = "CheckpointTest_checkpoint.bin";
+    Checkpoint checkpoint;
+    original.WriteCheckpoint(&checkpoint);
+    checkpoint.Write(uint32_t(12345));
+    if (checkpoint.WriteFile(checkpointFile)) errors++;
+    Checkpoint readCheckpoint;
+    if (readCheckpoint.ReadFile(checkpointFile)) errors++;
+    Population restored;
+    Configure(&restored);
+    if (restored.ReadCheckpoint(&readCheckpoint)) errors++;
+    uint32_t marker = 0;
+    if (!readCheckpoint.Read(&marker) || marker != 12345 || !readCheckpoint.AtEnd()) errors++;
+    if (!Same(&original, &restored)) errors++;
+    Evolve(&original, 1000);
+    Evolve(&restored, 1000);
+    if (!Same(&original, &restored)) errors++;
+    std::cout << "Checkpoint size " << checkpoint.GetSize() << " bytes\n";
+
+    // reading past the end fails and keeps failing
+    if (readCheckpoint.Read(&marker) || !readCheckpoint.GetReadError()) errors++;
+
+    // a changed byte or a short file is refused
+    std::string contents;
+    {
+        std::ifstream inFile(checkpointFile, std::ios::binary);
+        std::stringstream buffer;
+        buffer << inFile.rdbuf();
+        contents = buffer.str();
+    }
+    std::string corrupt = contents;
+    corrupt[corrupt.size() / 2] ^= 1;
+    std::ofstream(checkpointFile, std::ios::binary | std::ios::trunc) << corrupt;
+    if (readCheckpoint.ReadFile(checkpointFile) == 0) errors++;
+    std::ofstream(checkpointFile, std::ios::binary | std::ios::trunc) << contents.substr(0, contents.size() - 8);
+    if (readCheckpoint.ReadFile(checkpointFile) == 0) errors++;
+    std::remove(checkpointFile.c_str());
+    if (readCheckpoint.ReadFile(checkpointFile) == 0) errors++;
+
+    // a snapshot keeps the genomes it was taken with even when they are evicted or changed in the population
+    std::vector<std::shared_ptr<const Genome>> snapshot = original.GetSnapshot(populationSize);
+    std::vector<Genome> copies;
+    for (auto &&genome : snapshot) copies.push_back(*genome);
+    Evolve(&original, 1000);
+    original.SetGlobalCircularMutation(!snapshot.front()->GetGlobalCircularMutationFlag());
+    for (size_t i = 0; i < snapshot.size(); i++)
+    {
+        if (*snapshot[i]->GetGenes() != *copies[i].GetGenes() || snapshot[i]->GetFitness() != copies[i].GetFitness()) errors++;
+        if (snapshot[i]->GetGlobalCircularMutationFlag() != copies[i].GetGlobalCircularMutationFlag()) errors++;
+    }
+    if (snapshot.front()->GetFitness() < snapshot.back()->GetFitness()) errors++;
+    Population written;
+    if (Population::WriteGenomes(populationFile.c_str(), snapshot) || std::filesystem::exists(populationFile + ".tmp")) errors++;
+    if (written.ReadPopulation(populationFile.c_str()) || written.GetPopulationSize() != snapshot.size() || written.GetLastGenome()->GetFitness() != snapshot.front()->GetFitness()) errors++;
+    std::remove(populationFile.c_str());
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
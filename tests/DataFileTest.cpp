@@ -0,0 +1,71 @@
+#include "../src/DataFile.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// checks that the Retrieve calls give the same answers with and without the index, including repeated parameters
+// read in order, names that only appear inside longer tokens and data that are changed after the index was built
+static int Compare(DataFile *file)
+{
+    int errors = 0;
+    const std::vector<std::string> parameters = {"alpha", "beta", "gamma", "missing", "lph", "<GA", "12", "delta"};
+    for (auto &&parameter : parameters)
+    {
+        std::string plain, indexed;
+        file->ClearIndex();
+        bool plainResult = file->RetrieveParameter(parameter.c_str(), &plain);
+        file->BuildIndex();
+        bool indexedResult = file->RetrieveParameter(parameter.c_str(), &indexed);
+        if (plainResult != indexedResult || plain != indexed) { std::cerr << "parameter " << parameter << " differs\n"; errors++; }
+    }
+
+    // each repeat is found after the previous one
+    for (int pass = 0; pass < 2; pass++)
+    {
+        if (pass == 0) file->ClearIndex();
+        else file->BuildIndex();
+        std::vector<double> values;
+        double value = 0;
+        if (file->RetrieveParameter("gamma", &value) == false) values.push_back(value);
+        while (file->RetrieveParameter("gamma", &value, false) == false) values.push_back(value);
+        if (values != std::vector<double>({1, 2, 3})) { std::cerr << "repeated parameter differs in pass " << pass << "\n"; errors++; }
+    }
+
+    const std::vector<std::string> attributes = {"genomeLength", "name", "empty", "missing", "populationSize"};
+    for (auto &&attribute : attributes)
+    {
+        std::string plain, indexed;
+        file->ClearIndex();
+        bool plainResult = file->RetrieveAttribute(attribute.c_str(), &plain);
+        file->BuildIndex();
+        bool indexedResult = file->RetrieveAttribute(attribute.c_str(), &indexed);
+        if (plainResult != indexedResult || plain != indexed) { std::cerr << "attribute " << attribute << " differs\n"; errors++; }
+    }
+    return errors;
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    std::string text = "<GAPARAMETERS genomeLength=\"10\" name=\"a b c\" empty=\"\" populationSize=\"100\" />\n"
+                       "alpha 1.5\nalphabet 7\n  beta\t\"quoted string\"\ngamma 1 xgamma 9 gamma 2\ngamma 3\n12 13\ndelta";
+    DataFile file;
+    file.SetRawData(text.c_str(), text.size());
+    errors += Compare(&file);
+
+    // the index matches whole attribute names where the scan also matches the end of a longer name
+    file.BuildIndex();
+    int genomeLength = 0;
+    std::string value;
+    if (!file.HasIndex() || file.RetrieveAttribute("genomeLength", &genomeLength) || genomeLength != 10) errors++;
+    if (file.RetrieveAttribute("Length", &value) == false) errors++;
+
+    text.replace(text.find("10"), 2, "20");
+    file.SetRawData(text.c_str(), text.size());
+    if (file.HasIndex() || file.RetrieveAttribute("genomeLength", &genomeLength) || genomeLength != 20) errors++;
+    errors += Compare(&file);
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,52 @@
+#include "../src/DispatchQueue.h"
+
+#include <iostream>
+#include <array>
+#include <cstdint>
+
+// checks the weighted shares, the zero weight fallback and the age guarantee
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    uint32_t allClasses = (uint32_t(1) << DispatchQueue::NumberOfClasses) - 1;
+
+    // requeue and elite are weighted 8 and 2 so with both always full they should share 80:20
+    DispatchQueue dispatchQueue;
+    dispatchQueue.Clear(0);
+    for (uint64_t i = 0; i < 1000; i++)
+    {
+        dispatchQueue.Push(DispatchQueue::RequeueClass, i, 0);
+        dispatchQueue.Push(DispatchQueue::EliteClass, i, 0);
+    }
+    std::array<int, DispatchQueue::NumberOfClasses> counts = {};
+    uint32_t queuedOnly = DispatchQueue::ClassBit(DispatchQueue::RequeueClass) | DispatchQueue::ClassBit(DispatchQueue::EliteClass);
+    for (int i = 0; i < 1000; i++)
+    {
+        DispatchQueue::PriorityClass priorityClass = dispatchQueue.Select(0, queuedOnly);
+        uint64_t runID;
+        double enqueueTime;
+        if (priorityClass == DispatchQueue::NumberOfClasses || !dispatchQueue.Pop(priorityClass, &runID, &enqueueTime)) { errors++; break; }
+        dispatchQueue.MarkServed(priorityClass, 0);
+        counts[priorityClass]++;
+    }
+    if (counts[DispatchQueue::RequeueClass] != 800 || counts[DispatchQueue::EliteClass] != 200) errors++;
+    std::cout << "Weighted shares requeue " << counts[DispatchQueue::RequeueClass] << " elite " << counts[DispatchQueue::EliteClass] << "\n";
+
+    // with the queues empty the start population (weight 1) wins over offspring (weight 0) and offspring is the fallback
+    dispatchQueue.Clear(0);
+    if (dispatchQueue.Select(0, allClasses) != DispatchQueue::StartPopulationClass) errors++;
+    if (dispatchQueue.Select(0, DispatchQueue::ClassBit(DispatchQueue::OffspringClass)) != DispatchQueue::OffspringClass) errors++;
+    if (dispatchQueue.Select(0, 0) != DispatchQueue::NumberOfClasses) errors++;
+
+    // an age guarantee lets offspring through even though it has no weight
+    dispatchQueue.Clear(0);
+    dispatchQueue.SetMaximumAge(DispatchQueue::OffspringClass, 1.0);
+    if (dispatchQueue.Select(0.5, allClasses) != DispatchQueue::StartPopulationClass) errors++;
+    if (dispatchQueue.Select(2.0, allClasses) != DispatchQueue::OffspringClass) errors++;
+    dispatchQueue.MarkServed(DispatchQueue::OffspringClass, 2.0);
+    if (dispatchQueue.Select(2.5, allClasses) != DispatchQueue::StartPopulationClass) errors++;
+    if (dispatchQueue.GetAgeLimitCount(DispatchQueue::OffspringClass) != 1) errors++;
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include "../src/EvaluationCache.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+// checks that scores are found again for the same base XML MD5 and genes, that they survive reopening the file,
+// that a different MD5 misses and that a full probe window loses its oldest entry
+static std::vector<double> Genes(size_t i, size_t genomeLength)
+{
+    std::vector<double> genes(genomeLength);
+    for (size_t j = 0; j < genomeLength; j++) genes[j] = double(i) + double(j) / 100.0;
+    return genes;
+}
+
+// inserts genomes until the first eviction and returns the index of the genome that was lost
+// touching a genome just before the eviction reinserts it so that it becomes the newest in its window
+static size_t FirstEviction(EvaluationCache *cache, const uint32_t *md5, size_t genomeLength, size_t touch, size_t touchBefore, size_t *evictingInsert)
+{
+    size_t i = 0;
+    for (i = 0; cache->GetEvictions() == 0 && i < 4 * cache->GetCapacity(); i++)
+    {
+        if (i == touchBefore) cache->Insert(md5, Genes(touch, genomeLength).data(), genomeLength, -double(touch));
+        cache->Insert(md5, Genes(i, genomeLength).data(), genomeLength, -double(i));
+    }
+    *evictingInsert = i - 1;
+    double score;
+    for (size_t j = 0; j < *evictingInsert; j++)
+    {
+        if (!cache->Lookup(md5, Genes(j, genomeLength).data(), genomeLength, &score)) return j;
+    }
+    return SIZE_MAX;
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    std::string filename = "EvaluationCacheTest.bin";
+    uint32_t md5[4] = {0x01234567, 0x89abcdef, 0x01234567, 0x89abcdef};
+    uint32_t otherMD5[4] = {0x01234567, 0x89abcdef, 0x01234567, 0x89abcdee};
+    size_t genomeLength = 20;
+    std::remove(filename.c_str());
+
+    EvaluationCache cache;
+    if (cache.Open(filename, 1000) || cache.GetCapacity() != 1024 || cache.GetCount() != 0) errors++;
+    for (size_t i = 0; i < 100; i++) cache.Insert(md5, Genes(i, genomeLength).data(), genomeLength, -double(i));
+    double score = 0;
+    for (size_t i = 0; i < 100; i++)
+    {
+        if (!cache.Lookup(md5, Genes(i, genomeLength).data(), genomeLength, &score) || score != -double(i)) errors++;
+    }
+    // inserting the same genes again replaces the score rather than adding an entry
+    cache.Insert(md5, Genes(0, genomeLength).data(), genomeLength, 42);
+    if (cache.GetCount() != 100 || !cache.Lookup(md5, Genes(0, genomeLength).data(), genomeLength, &score) || score != 42) errors++;
+    if (cache.Lookup(md5, Genes(100, genomeLength).data(), genomeLength, &score)) errors++;
+    if (cache.Lookup(md5, Genes(1, genomeLength).data(), genomeLength - 1, &score)) errors++;
+    if (cache.Lookup(otherMD5, Genes(1, genomeLength).data(), genomeLength, &score)) errors++;
+    if (cache.GetHits() != 101 || cache.GetMisses() != 3) errors++;
+    if (cache.Flush()) errors++;
+    cache.Close();
+
+    // the scores are still there after reopening the file
+    if (cache.Open(filename, 1000) || cache.GetCount() != 100) errors++;
+    for (size_t i = 1; i < 100; i++)
+    {
+        if (!cache.Lookup(md5, Genes(i, genomeLength).data(), genomeLength, &score) || score != -double(i)) errors++;
+    }
+    if (cache.Lookup(otherMD5, Genes(1, genomeLength).data(), genomeLength, &score)) errors++;
+    cache.Close();
+
+    // the first eviction happens when a probe window is full and it loses the oldest genome in the window
+    // so if that genome is touched just before the evicting insert a different one is lost instead
+    std::remove(filename.c_str());
+    size_t evictingInsert = 0, touchedEvictingInsert = 0;
+    if (cache.Open(filename, 1024)) errors++;
+    size_t evicted = FirstEviction(&cache, md5, genomeLength, SIZE_MAX, SIZE_MAX, &evictingInsert);
+    if (evicted == SIZE_MAX || cache.GetEvictions() != 1 || cache.GetCount() != evictingInsert) errors++;
+    if (!cache.Lookup(md5, Genes(evictingInsert, genomeLength).data(), genomeLength, &score)) errors++;
+    cache.Close();
+    std::remove(filename.c_str());
+    if (cache.Open(filename, 1024)) errors++;
+    size_t touchedEvicted = FirstEviction(&cache, md5, genomeLength, evicted, evictingInsert, &touchedEvictingInsert);
+    if (touchedEvictingInsert != evictingInsert || touchedEvicted == evicted || touchedEvicted == SIZE_MAX) errors++;
+    if (!cache.Lookup(md5, Genes(evicted, genomeLength).data(), genomeLength, &score) || score != -double(evicted)) errors++;
+    cache.Close();
+    std::remove(filename.c_str());
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+#include "../src/EvaluationJournal.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+
+// checks that every appended record can be read back in place, that a reopened journal is appended to
+// after any partly written record and that a journal for a different base XML file is refused
+static void AppendRecords(EvaluationJournal *journal, uint64_t firstRunID, size_t count, size_t genomeLength)
+{
+    std::vector<double> genes(genomeLength);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t runID = firstRunID + i;
+        for (size_t j = 0; j < genomeLength; j++) genes[j] = double(runID) + double(j) / 100.0;
+        EvaluationJournal::Record record = {};
+        record.runID = runID;
+        record.score = -double(runID);
+        record.dispatchTime = double(runID);
+        record.returnTime = double(runID) + 0.5;
+        record.parentRanks[0] = int32_t(runID % 7);
+        record.parentRanks[1] = -1;
+        record.genomeLength = uint32_t(genomeLength);
+        journal->Append(record, genes.data(), double(i) * 0.001);
+    }
+}
+
+static int CheckRecords(const std::string &filename, size_t expected, size_t genomeLength)
+{
+    EvaluationJournalReader reader;
+    if (reader.Open(filename)) return 1;
+    if (reader.GetSize() != expected) return 1;
+    for (size_t i = 0; i < reader.GetSize(); i++)
+    {
+        const EvaluationJournal::Record *record = reader.GetRecord(i);
+        if (record->runID != i || record->score != -double(i) || record->returnTime != double(i) + 0.5 || record->parentRanks[0] != int32_t(i % 7)) return 1;
+        if (record->genomeLength != genomeLength || reader.GetGenes(i)[genomeLength - 1] != double(i) + double(genomeLength - 1) / 100.0) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    const size_t genomeLength = 12;
+    const uint32_t md5[4] = {1, 2, 3, 4};
+    const uint32_t otherMD5[4] = {5, 6, 7, 8};
+    std::string filename = "EvaluationJournalTest.bin";
+    std::remove(filename.c_str());
+
+    EvaluationJournal journal;
+    journal.SetGroupCommit(64, 1);
+    if (journal.Open(filename, md5)) errors++;
+    AppendRecords(&journal, 0, 1000, genomeLength);
+    journal.Flush();
+    if (journal.GetWritten() != 1000 || journal.GetCommits() == 0 || journal.GetCommits() > 1000 / 64 + 1 || journal.GetDropped()) errors++; // a slow writer means fewer larger commits
+    std::cout << journal.GetStatusString() << "\n";
+    journal.Close();
+    errors += CheckRecords(filename, 1000, genomeLength);
+
+    // half a record left by a crash is ignored by the reader and removed before appending
+    {
+        std::ofstream outFile(filename, std::ios::binary | std::ios::app);
+        outFile << "partial record";
+    }
+    errors += CheckRecords(filename, 1000, genomeLength);
+    if (journal.Open(filename, md5)) errors++;
+    AppendRecords(&journal, 1000, 500, genomeLength);
+    journal.Close();
+    errors += CheckRecords(filename, 1500, genomeLength);
+
+    if (journal.Open(filename, otherMD5) == 0) errors++;
+    std::remove(filename.c_str());
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
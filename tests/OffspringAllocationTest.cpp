@@ -0,0 +1,137 @@
+#include "../src/Population.h"
+#include "../src/Genome.h"
+#include "../src/GenomePool.h"
+#include "../src/RunningList.h"
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <algorithm>
+
+// counts every heap allocation so that the whole dispatch and scoring cycle can be checked for allocations
+static std::atomic<size_t> g_allocationCount = 0;
+
+void *operator new(std::size_t size)
+{
+    g_allocationCount++;
+    if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+// same layout as GAMain::DataMessage
+struct DataMessage
+{
+    char text[16];
+    uint64_t evolveIdentifier;
+    uint32_t senderIP;
+    uint32_t senderPort;
+    uint32_t runID;
+    uint32_t genomeLength;
+    uint32_t xmlLength;
+    uint32_t md5[4];
+    union
+    {
+        double genome[1];
+        char xml[1];
+    } payload;
+};
+
+int main(int argc, const char **argv)
+{
+    const size_t populationSize = 1000;
+    const size_t genomeLength = 2000;
+    const size_t warmUpCount = 1000;
+    const size_t testCount = 10000;
+    const uint64_t inFlight = 200; // scores come back this many dispatches later
+    const uint64_t sessionCount = 16;
+
+    // build a population using the text format
+    std::stringstream populationText;
+    populationText << populationSize << "\n";
+    for (size_t i = 0; i < populationSize; i++)
+    {
+        populationText << "-1\n" << genomeLength << "\n";
+        for (size_t j = 0; j < genomeLength; j++) populationText << (double(j % 17) / 17.0) << "\t-1\t1\t0.1\n";
+        populationText << double(i) << "\t0\t0\t0\t0\n";
+    }
+    std::string populationFile = "OffspringAllocationTest_population.txt";
+    {
+        std::ofstream outFile(populationFile);
+        outFile << populationText.str();
+    }
+
+    std::shared_ptr<GenomePool> genomePool = GenomePool::Create();
+    Population population;
+    population.SetGenomePool(genomePool);
+    population.SetSelectionType(GammaBasedSelection);
+    population.SetGamma(0.5);
+    population.SetCrossoverChance(0.5);
+    population.SetCrossoverType(Mating::OnePoint);
+    population.SetGaussianMutationChance(0.01);
+    population.SetMultipleGaussian(true);
+    population.SetFrameShiftMutationChance(0.1);
+    population.SetDuplicationMutationChance(0.1);
+    if (population.ReadPopulation(populationFile.c_str()) || population.GetPopulationSize() != populationSize)
+    {
+        std::cerr << "Error reading " << populationFile << "\n";
+        return 1;
+    }
+    std::remove(populationFile.c_str());
+
+    // this mirrors the GAMain dispatch and score paths: the offspring is built in a genome from the pool, sent using a reused
+    // message buffer and held in the running list until its score comes back when it is inserted into the population
+    // which drops its oldest genome back into the pool. Some scores are already in the population so the new genome goes straight back.
+    RunningList runningList;
+    runningList.SetGenomePool(genomePool);
+    genomePool->ReserveBlocks(3 * (populationSize + inFlight));
+    std::vector<char> dataMessage;
+    uint64_t runID = 0;
+    size_t errors = 0;
+    auto cycle = [&]()
+    {
+        std::unique_ptr<Genome> offspring = runningList.AcquireGenome();
+        std::array<int32_t, 2> parentRanks;
+        population.GetOffspring(offspring.get(), &parentRanks);
+        dataMessage.resize(sizeof(DataMessage) + offspring->GetGenomeLength() * sizeof(double));
+        DataMessage *dataMessagePtr = reinterpret_cast<DataMessage *>(dataMessage.data());
+        std::strncpy(dataMessagePtr->text, "genome", sizeof(dataMessagePtr->text));
+        dataMessagePtr->runID = uint32_t(runID);
+        dataMessagePtr->genomeLength = uint32_t(offspring->GetGenomeLength());
+        std::copy_n(offspring->GetGenes()->data(), offspring->GetGenomeLength(), dataMessagePtr->payload.genome);
+        RunningList::RunSpecifier *runSpecifier = runningList.Insert(runID, std::move(offspring), runID % sessionCount + 1);
+        runSpecifier->parentRanks = parentRanks;
+        if (runID >= inFlight)
+        {
+            std::unique_ptr<Genome> genome = runningList.Take(runID - inFlight);
+            if (!genome) { errors++; return; }
+            genome->SetFitness(double((runID * 7919) % 20011));
+            population.InsertGenome(std::move(genome), populationSize);
+        }
+        runID++;
+    };
+
+    for (size_t i = 0; i < warmUpCount; i++) cycle();
+
+    size_t startAllocationCount = g_allocationCount;
+    auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < testCount; i++) cycle();
+    auto endTime = std::chrono::steady_clock::now();
+    size_t allocations = g_allocationCount - startAllocationCount;
+
+    if (population.GetPopulationSize() != populationSize || runningList.GetSize() != inFlight) errors++;
+    double seconds = std::chrono::duration<double>(endTime - startTime).count();
+    std::cout << "Offspring generated and scored " << testCount << " genome length " << genomeLength << "\n";
+    std::cout << "Time per offspring " << (seconds / double(testCount)) * 1e6 << " us\n";
+    std::cout << "Pooled genomes " << genomePool->GetSize() << " free control blocks " << genomePool->GetFreeBlockCount() << " errors " << errors << "\n";
+    std::cout << "Allocations " << allocations << " per offspring " << double(allocations) / double(testCount) << "\n";
+    return (allocations == 0 && errors == 0) ? 0 : 1;
+}
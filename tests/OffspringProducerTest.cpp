@@ -0,0 +1,84 @@
+#include "../src/OffspringProducer.h"
+#include "../src/Population.h"
+#include "../src/Genome.h"
+#include "../src/GenomePool.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+// checks that offspring are bred ahead up to the capacity from the published population, that the population can keep
+// changing while they are bred, that clearing drops the ready offspring and that stopping gives them back to the pool
+static void WaitForDepth(OffspringProducer *producer, size_t depth)
+{
+    for (int i = 0; i < 5000 && producer->GetDepth() != depth; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    const size_t populationSize = 100;
+    const size_t genomeLength = 50;
+    const size_t capacity = 16;
+
+    std::shared_ptr<GenomePool> genomePool = GenomePool::Create();
+    Population population;
+    population.SetGenomePool(genomePool);
+    population.SetCrossoverChance(0.5);
+    population.SetGaussianMutationChance(0.1);
+    std::vector<double> genes(genomeLength), lowBounds(genomeLength, -1), highBounds(genomeLength, 1), gaussianSDs(genomeLength, 0.1);
+    std::vector<int32_t> circularMutationFlags(genomeLength, 0);
+    for (size_t i = 0; i < populationSize; i++)
+    {
+        for (size_t j = 0; j < genomeLength; j++) genes[j] = double(i) / double(populationSize);
+        auto genome = std::make_unique<Genome>();
+        genome->Assign(Genome::IndividualRanges, genomeLength, genes.data(), lowBounds.data(), highBounds.data(), gaussianSDs.data(), circularMutationFlags.data(), double(i));
+        population.InsertGenome(std::move(genome), populationSize);
+    }
+
+    // nothing is bred until a population has been published
+    OffspringProducer producer;
+    producer.Start("offspring", capacity, genomePool);
+    std::unique_ptr<Genome> offspring = genomePool->Acquire();
+    std::array<int32_t, 2> parentRanks;
+    if (producer.Take(&offspring, &parentRanks) || producer.GetMisses() != 1) errors++;
+    if (!producer.Publish(population)) errors++;
+    WaitForDepth(&producer, capacity);
+    if (producer.GetDepth() != capacity || producer.GetProduced() != capacity) errors++;
+
+    // the population is changed while the producer keeps breeding from its copy
+    for (size_t i = 0; i < 1000; i++)
+    {
+        if (!producer.Take(&offspring, &parentRanks))
+        {
+            population.GetOffspring(offspring.get(), &parentRanks);
+        }
+        if (offspring->GetGenomeLength() != genomeLength || parentRanks[0] < 0 || parentRanks[0] >= int32_t(populationSize) || parentRanks[1] >= int32_t(populationSize)) errors++;
+        offspring->SetFitness(double(populationSize + i));
+        population.InsertGenome(std::move(offspring), populationSize);
+        producer.Publish(population);
+        offspring = genomePool->Acquire();
+    }
+    if (producer.GetTaken() == 0 || producer.GetPublished() == 0 || population.GetPopulationSize() != populationSize) errors++;
+    std::cout << producer.GetStatusString() << "\n";
+
+    // clearing drops the ready offspring and nothing more is bred until the next publish
+    WaitForDepth(&producer, capacity);
+    producer.Clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (producer.GetDepth() != 0) errors++;
+    if (!producer.Publish(population)) errors++;
+    WaitForDepth(&producer, capacity);
+    if (producer.GetDepth() != capacity) errors++;
+
+    // stopping returns the ready offspring to the pool, along with any genomes that only the copies still held
+    size_t poolSize = genomePool->GetSize();
+    producer.Stop();
+    if (genomePool->GetSize() < poolSize + capacity) errors++;
+    if (producer.Take(&offspring, &parentRanks)) errors++;
+    std::cout << producer.GetStatusString() << "\n";
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+#include "../src/PipelineStage.h"
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// checks the job order, the bounded queue back pressure, dropping when full, replacing keyed jobs and that stopping runs what is left
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+
+    // jobs run in the order they were pushed
+    PipelineStage stage;
+    stage.Start("test", 8);
+    std::vector<int> order;
+    for (int i = 0; i < 1000; i++) stage.Push([&order, i]() { order.push_back(i); });
+    stage.Flush();
+    for (int i = 0; i < 1000; i++) if (order.size() != 1000 || order[size_t(i)] != i) { errors++; break; }
+    if (stage.GetProcessed() != 1000) errors++;
+    if (stage.GetMaxDepth() > 8) errors++;
+    std::cout << stage.GetStatusString() << "\n";
+
+    // a blocked stage fills up and then either stalls or drops the producer
+    std::atomic<bool> release = false;
+    stage.Push([&release]() { while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+    while (stage.GetDepth()) std::this_thread::sleep_for(std::chrono::milliseconds(1)); // the blocking job has started
+    for (int i = 0; i < 8; i++) if (!stage.Push([]() {}, false)) errors++;
+    if (stage.GetDepth() != 8) errors++;
+    if (stage.Push([]() {}, false)) errors++;
+    if (stage.GetDrops() != 1) errors++;
+    uint64_t stalls = stage.GetStalls();
+    std::thread releaser([&release]() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); release = true; });
+    if (!stage.Push([]() {}, true)) errors++; // waits until the stage catches up
+    if (stage.GetStalls() != stalls + 1) errors++;
+    releaser.join();
+
+    // a keyed job replaces a queued one with the same key in its place and never waits
+    stage.Flush();
+    release = false;
+    stage.Push([&release]() { while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+    while (stage.GetDepth()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::vector<int> latest;
+    for (int i = 0; i < 100; i++)
+    {
+        if (!stage.PushLatest(1, [&latest, i]() { latest.push_back(i); })) errors++;
+        if (!stage.PushLatest(2, [&latest, i]() { latest.push_back(1000 + i); })) errors++;
+    }
+    if (stage.GetDepth() != 2 || stage.GetReplaced() != 198) errors++;
+    for (int i = 0; i < 6; i++) stage.Push([]() {}, false);
+    uint64_t drops = stage.GetDrops();
+    if (stage.PushLatest(3, []() {}) || stage.GetDrops() != drops + 1) errors++; // full and nothing to replace
+    if (!stage.PushLatest(1, [&latest]() { latest.push_back(100); })) errors++; // full but replacing is still fine
+    release = true;
+    stage.Flush();
+    if (latest.size() != 2 || latest[0] != 100 || latest[1] != 1099) errors++;
+
+    // stopping runs everything that is still queued and later pushes are refused so the caller can do the work itself
+    std::atomic<int> count = 0;
+    for (int i = 0; i < 5; i++) stage.Push([&count]() { std::this_thread::sleep_for(std::chrono::milliseconds(2)); count++; });
+    stage.Stop();
+    if (count != 5) errors++;
+    if (stage.Push([]() {})) errors++;
+    std::cout << stage.GetStatusString() << "\n";
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
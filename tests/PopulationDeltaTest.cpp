@@ -0,0 +1,142 @@
+#include "../src/PopulationDelta.h"
+#include "../src/Population.h"
+#include "../src/Genome.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <numeric>
+#include <filesystem>
+#include <cstdio>
+
+// checks that every snapshot written as a delta is rebuilt exactly from its keyframe, that the deltas are much smaller
+// than the full files, that a snapshot where most of the genomes are new falls back to a keyframe and that a damaged
+// chain is refused
+static void Evolve(Population *population, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        auto offspring = std::make_unique<Genome>();
+        population->GetOffspring(offspring.get());
+        offspring->SetFitness(std::accumulate(offspring->GetGenes()->begin(), offspring->GetGenes()->end(), 0.0));
+        population->InsertGenome(std::move(offspring), 0);
+    }
+}
+
+static bool Same(const std::vector<std::shared_ptr<const Genome>> &lhs, const std::vector<std::shared_ptr<const Genome>> &rhs)
+{
+    if (lhs.size() != rhs.size()) return false;
+    for (size_t i = 0; i < lhs.size(); i++)
+    {
+        const Genome &l = *lhs[i], &r = *rhs[i];
+        if (l.GetGenomeType() != r.GetGenomeType() || l.GetFitness() != r.GetFitness() || *l.GetGenes() != *r.GetGenes() || *l.GetLowBounds() != *r.GetLowBounds() ||
+            *l.GetHighBounds() != *r.GetHighBounds() || *l.GetGaussianSDs() != *r.GetGaussianSDs()) return false;
+    }
+    return true;
+}
+
+static std::vector<std::shared_ptr<const Genome>> ReadAll(const std::string &filename, int *err)
+{
+    std::vector<std::shared_ptr<const Genome>> genomes;
+    *err = Population::ReadGenomes(filename.c_str(), [&genomes](std::unique_ptr<Genome> genome, size_t) { genomes.push_back(std::move(genome)); return true; });
+    return genomes;
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    const size_t populationSize = 500;
+    const size_t genomeLength = 20;
+    std::filesystem::path folder = "PopulationDeltaTest";
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directory(folder);
+
+    std::string startFile = (folder / "start.txt").string();
+    {
+        std::ofstream outFile(startFile);
+        outFile << populationSize << "\n";
+        for (size_t i = 0; i < populationSize; i++)
+        {
+            outFile << "-1\n" << genomeLength << "\n";
+            for (size_t j = 0; j < genomeLength; j++) outFile << (double((i * 7 + j) % 23) / 23.0) << "\t-1\t1\t0.1\n";
+            outFile << double(i) << "\t0\t0\t0\t0\n";
+        }
+    }
+    Population population;
+    population.SetParentsToKeep(5);
+    population.SetCrossoverChance(0.5);
+    population.SetCrossoverType(Mating::OnePoint);
+    population.SetGaussianMutationChance(0.5);
+    if (population.ReadPopulation(startFile.c_str())) errors++;
+
+    PopulationDelta delta;
+    std::vector<std::string> filenames;
+    std::vector<std::vector<std::shared_ptr<const Genome>>> snapshots;
+    size_t deltaCount = 0, keyframeCount = 0;
+    for (size_t i = 0; i < 12; i++)
+    {
+        if (i == 6) population.SetGlobalCircularMutation(true); // every genome is replaced by a copy
+        if (i == 8)
+        {
+            // an elite re-evaluation brings back a copy of the best genome with a new fitness
+            std::shared_ptr<const Genome> best = population.GetSnapshot(1).front();
+            auto elite = std::make_unique<Genome>(*best);
+            if (elite->GetParent(0) || elite->GetParent(1)) errors++; // copies never name the parents of the original
+            elite->SetParents(best);
+            Genome assigned;
+            assigned = *elite;
+            if (assigned.GetParent(0)) errors++;
+            elite->SetFitness(best->GetFitness() + 0.5);
+            population.RemoveGenome(*best->GetGenes());
+            population.InsertGenome(std::move(elite), 0);
+        }
+        Evolve(&population, 20);
+        std::vector<std::shared_ptr<const Genome>> snapshot = population.GetSnapshot(populationSize);
+        std::string base = (folder / ("Population_" + std::to_string(i))).string();
+        if (delta.Encode(snapshot, 5))
+        {
+            if (delta.WriteDelta(base + ".delta")) errors++;
+            filenames.push_back(base + ".delta");
+            deltaCount++;
+        }
+        else
+        {
+            if (Population::WriteGenomes((base + ".txt").c_str(), snapshot)) errors++;
+            delta.SetKeyframe(base + ".txt", snapshot);
+            filenames.push_back(base + ".txt");
+            keyframeCount++;
+        }
+        snapshots.push_back(snapshot);
+    }
+    // keyframes at 0, 5 (the count), 6 (all new) and 11
+    if (keyframeCount != 4 || deltaCount != 8) errors++;
+    std::cerr << "keyframes " << keyframeCount << " deltas " << deltaCount << "\n";
+
+    for (size_t i = 0; i < filenames.size(); i++)
+    {
+        int err = 0;
+        std::vector<std::shared_ptr<const Genome>> rebuilt = ReadAll(filenames[i], &err);
+        if (err || !Same(rebuilt, snapshots[i])) { std::cerr << "snapshot " << i << " is not rebuilt correctly\n"; errors++; }
+    }
+    uintmax_t keyframeSize = std::filesystem::file_size(filenames[0]);
+    uintmax_t deltaSize = std::filesystem::file_size(filenames[1]);
+    std::cerr << "keyframe " << keyframeSize << " bytes delta " << deltaSize << " bytes\n";
+    if (deltaSize * 20 > keyframeSize) errors++;
+
+    // a damaged delta and a missing keyframe both stop the snapshot being rebuilt
+    {
+        std::fstream file(filenames[2], std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-3, std::ios::end);
+        file.put('x');
+    }
+    int err = 0;
+    if (ReadAll(filenames[3], &err).size() || err == 0) errors++;
+    std::filesystem::remove(filenames[6]);
+    if (ReadAll(filenames[7], &err).size() || err == 0) errors++;
+
+    std::filesystem::remove_all(folder);
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
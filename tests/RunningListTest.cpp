@@ -0,0 +1,171 @@
+#include "../src/RunningList.h"
+#include "../src/Genome.h"
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+
+// checks the open addressing table against an unordered_map: the backward shift delete in probe sequences that wrap
+// past the end of the table, lookups by the 32 bit wire runID, growing a table whose probe sequences wrap and the session index
+
+static std::unique_ptr<Genome> MakeGenome(uint64_t runID)
+{
+    auto genome = std::make_unique<Genome>();
+    genome->SetFitness(double(runID));
+    return genome;
+}
+
+static int Check(RunningList *runningList, const std::unordered_map<uint64_t, bool> &expected)
+{
+    int errors = 0;
+    if (runningList->GetSize() != expected.size()) errors++;
+    for (auto &&item : expected)
+    {
+        RunningList::RunSpecifier *runSpecifier = runningList->Find(item.first);
+        if (!runSpecifier || runSpecifier->runID != item.first || !runSpecifier->genome || runSpecifier->genome->GetFitness() != double(item.first)) errors++;
+    }
+    size_t count = 0;
+    runningList->ForEach([&](const RunningList::RunSpecifier &runSpecifier) { count++; if (!expected.count(runSpecifier.runID)) errors++; });
+    if (count != expected.size()) errors++;
+    return errors;
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+
+    // a cluster that starts at the last slot and wraps round to the start of the table
+    {
+        RunningList runningList(16);
+        std::unordered_map<uint64_t, bool> expected;
+        const std::vector<uint64_t> runIDs = {15, 31, 47, 0, 63, 1, 14, 30};
+        for (auto &&runID : runIDs) { runningList.Insert(runID, MakeGenome(runID)); expected[runID] = true; }
+        errors += Check(&runningList, expected);
+        // removing from the front, middle and wrapped part of the cluster has to pull the later members back
+        for (uint64_t runID : {31ull, 15ull, 0ull, 14ull})
+        {
+            std::unique_ptr<Genome> genome = runningList.Take(runID);
+            if (!genome || genome->GetFitness() != double(runID)) errors++;
+            expected.erase(runID);
+            errors += Check(&runningList, expected);
+        }
+        if (runningList.Take(31)) errors++;
+        if (runningList.GetCapacity() != 16) errors++;
+    }
+
+    // the wire runID is the low 32 bits and the home slot is the same as for the full runID
+    {
+        RunningList runningList(16);
+        const uint64_t high = uint64_t(1) << 32;
+        runningList.Insert(high * 3 + 7, MakeGenome(high * 3 + 7));
+        runningList.Insert(high * 3 + 23, MakeGenome(high * 3 + 23)); // same home slot
+        RunningList::RunSpecifier *runSpecifier = runningList.FindWireRunID(23);
+        if (!runSpecifier || runSpecifier->runID != high * 3 + 23) errors++;
+        runSpecifier = runningList.FindWireRunID(7);
+        if (!runSpecifier || runSpecifier->runID != high * 3 + 7) errors++;
+        if (runningList.FindWireRunID(39)) errors++;
+        if (runningList.Find(23)) errors++; // the full runID has to match
+        runningList.Erase(high * 3 + 7);
+        runSpecifier = runningList.FindWireRunID(23);
+        if (!runSpecifier || runSpecifier->runID != high * 3 + 23) errors++;
+    }
+
+    // growing while clusters wrap round the end of the table
+    {
+        RunningList runningList(16);
+        std::unordered_map<uint64_t, bool> expected;
+        for (uint64_t runID : {13ull, 29ull, 45ull, 61ull, 14ull, 15ull, 77ull})
+        {
+            runningList.Insert(runID, MakeGenome(runID));
+            expected[runID] = true;
+        }
+        if (runningList.GetCapacity() != 16) errors++;
+        for (uint64_t runID = 100; runningList.GetCapacity() == 16; runID++)
+        {
+            runningList.Insert(runID, MakeGenome(runID));
+            expected[runID] = true;
+        }
+        errors += Check(&runningList, expected);
+    }
+
+    // closing a session finds its runs, including the ones it holds as a duplicate, without a scan
+    {
+        RunningList runningList(16);
+        for (uint64_t runID = 0; runID < 40; runID++) runningList.Insert(runID, MakeGenome(runID), runID % 4 + 1);
+        runningList.SetDuplicateSessionID(runningList.Find(5), 3);
+        runningList.SetSessionID(runningList.Find(6), 1); // moved from session 3
+        runningList.Erase(10);
+        if (runningList.Take(14) == nullptr) errors++;
+        if (runningList.GetSessionRunCount(3) != 8 || runningList.GetSessionRunCount(0) != 0) errors++;
+        std::vector<uint64_t> runIDs;
+        runningList.CloseSession(3, &runIDs);
+        if (runningList.GetSessionRunCount(3) != 0) errors++;
+        std::sort(runIDs.begin(), runIDs.end());
+        if (runIDs != std::vector<uint64_t>({2, 5, 18, 22, 26, 30, 34, 38})) errors++;
+        for (auto &&runID : runIDs)
+        {
+            RunningList::RunSpecifier *runSpecifier = runningList.Find(runID);
+            if (runSpecifier->sessionID == 3 || runSpecifier->duplicateSessionID == 3) errors++;
+        }
+        if (runningList.Find(5)->sessionID != 2 || runningList.Find(6)->sessionID != 1) errors++;
+        runIDs.clear();
+        runningList.CloseSession(3, &runIDs);
+        if (runIDs.size()) errors++;
+        runningList.Insert(100, MakeGenome(100), 3); // the session ID is reused
+        runningList.CloseSession(3, &runIDs);
+        if (runIDs != std::vector<uint64_t>({100})) errors++;
+    }
+
+    // random inserts and removals with some very old runs left outstanding
+    {
+        RunningList runningList(16);
+        std::unordered_map<uint64_t, bool> expected;
+        std::vector<uint64_t> outstanding;
+        std::mt19937_64 generator(1234);
+        uint64_t nextRunID = (uint64_t(1) << 32) - 1000; // cross the 32 bit boundary on the way
+        for (size_t i = 0; i < 200000; i++)
+        {
+            if (outstanding.size() < 50 || generator() % 2)
+            {
+                runningList.Insert(nextRunID, MakeGenome(nextRunID));
+                expected[nextRunID] = true;
+                outstanding.push_back(nextRunID);
+                nextRunID++;
+            }
+            else
+            {
+                // mostly the recent runs so that a few old ones stay behind
+                size_t index = (generator() % 10) ? outstanding.size() - 1 - generator() % std::min(outstanding.size(), size_t(20)) : generator() % outstanding.size();
+                uint64_t runID = outstanding[index];
+                outstanding[index] = outstanding.back();
+                outstanding.pop_back();
+                if (generator() % 2)
+                {
+                    std::unique_ptr<Genome> genome = runningList.Take(runID);
+                    if (!genome || genome->GetFitness() != double(runID)) errors++;
+                }
+                else
+                {
+                    runningList.Erase(runID);
+                }
+                expected.erase(runID);
+            }
+            if (i % 1000 == 0)
+            {
+                errors += Check(&runningList, expected);
+                for (auto &&runID : outstanding)
+                {
+                    RunningList::RunSpecifier *runSpecifier = runningList.FindWireRunID(uint32_t(runID));
+                    if (!runSpecifier || runSpecifier->runID != runID) errors++;
+                }
+            }
+        }
+        errors += Check(&runningList, expected);
+    }
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
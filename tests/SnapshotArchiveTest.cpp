@@ -0,0 +1,103 @@
+#include "../src/SnapshotArchive.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <cstdio>
+
+// checks that snapshots come back exactly as they were added, that only the last few of each kind are kept,
+// that the file is compacted, that adding only appends and that the snapshots are still found without an index
+static std::string Contents(size_t i, size_t length)
+{
+    std::ostringstream contents;
+    contents << length << "\n";
+    for (size_t j = 0; j < length; j++) contents << double(i) + double(j) / 1000.0 << "\t-1\t1\t0.1\n";
+    return contents.str();
+}
+
+static std::string Name(const char *model, size_t i)
+{
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), model, i);
+    return buffer;
+}
+
+int main(int argc, const char **argv)
+{
+    int errors = 0;
+    std::string filename = "SnapshotArchiveTest.bin";
+    std::string md5 = "0123456789abcdef0123456789abcdef";
+    std::remove(filename.c_str());
+
+    SnapshotArchive archive;
+    archive.SetMinCompactBytes(100000);
+    if (archive.Open(filename)) errors++;
+    for (size_t i = 0; i < 200; i++)
+    {
+        if (archive.Add(SnapshotArchive::BestGenome, Name("BestGenome_%012zu.txt", i), "", Contents(i, 10), 3)) errors++;
+        if (i % 10 == 0 && archive.Add(SnapshotArchive::Population, Name("Population_%012zu.txt", i), md5, Contents(i, 1000), 5)) errors++;
+    }
+    // 3 best genomes and 5 populations, and the dropped snapshots have been compacted away rather than filling the file
+    if (archive.GetSize() != 8 || !archive.Contains(Name("BestGenome_%012zu.txt", 199)) || archive.Contains(Name("BestGenome_%012zu.txt", 196))) errors++;
+    if (!archive.Contains(Name("Population_%012zu.txt", 150)) || archive.Contains(Name("Population_%012zu.txt", 140))) errors++;
+    if (archive.GetDeadBytes() > 100000 || std::filesystem::file_size(filename) > 250000) errors++;
+
+    // an add appends the snapshot and a tombstone for the one it drops without rewriting the index
+    uintmax_t before = std::filesystem::file_size(filename);
+    std::string bestContents = Contents(200, 10);
+    if (archive.Add(SnapshotArchive::BestGenome, Name("BestGenome_%012zu.txt", 200), "", bestContents, 3)) errors++;
+    if (std::filesystem::file_size(filename) - before > bestContents.size() + 200) errors++;
+
+    // an archive that was never closed has no index and is recovered without the snapshots that were dropped
+    std::string crashFilename = "SnapshotArchiveTest_crash.bin";
+    std::filesystem::copy_file(filename, crashFilename, std::filesystem::copy_options::overwrite_existing);
+    SnapshotArchive crashed;
+    if (crashed.Open(crashFilename, true) || !crashed.GetRecovered() || crashed.GetSize() != 8) errors++;
+    if (!crashed.Contains(Name("BestGenome_%012zu.txt", 200)) || crashed.Contains(Name("BestGenome_%012zu.txt", 197))) errors++;
+    crashed.Close();
+    std::remove(crashFilename.c_str());
+    archive.Close();
+
+    SnapshotArchive reader;
+    if (reader.Open(filename, true) || reader.GetRecovered() || reader.GetSize() != 8) errors++;
+    std::string contents;
+    for (size_t i = 0; i < reader.GetSize(); i++)
+    {
+        const SnapshotArchive::Entry &entry = reader.GetEntry(i);
+        size_t index = size_t(std::stoul(entry.name.substr(entry.name.find('_') + 1)));
+        if (reader.ReadContents(i, &contents) || contents != Contents(index, entry.kind == SnapshotArchive::Population ? 1000 : 10)) errors++;
+        if ((entry.kind == SnapshotArchive::Population) != (entry.md5 == md5)) errors++;
+    }
+
+    // extracting recreates the text file and its md5 record
+    if (reader.Extract(reader.GetSize() - 1, ".")) errors++;
+    std::string extracted = reader.GetEntry(reader.GetSize() - 1).name;
+    {
+        std::ifstream inFile(extracted, std::ios::binary);
+        std::stringstream buffer;
+        buffer << inFile.rdbuf();
+        if (reader.ReadContents(reader.GetSize() - 1, &contents) || buffer.str() != contents) errors++;
+    }
+    if (!std::filesystem::exists(extracted + ".md5") && reader.GetEntry(reader.GetSize() - 1).md5.size()) errors++;
+    std::remove(extracted.c_str());
+    std::remove((extracted + ".md5").c_str());
+    reader.Close();
+
+    // losing the end of the index means the entries are found by walking them and the next snapshot is added after them
+    uintmax_t size = std::filesystem::file_size(filename);
+    std::filesystem::resize_file(filename, size - 10);
+    if (archive.Open(filename) || !archive.GetRecovered() || archive.GetSize() != 8) errors++;
+    if (archive.Add(SnapshotArchive::BestGenome, Name("BestGenome_%012zu.txt", 201), "", Contents(201, 10), 3)) errors++;
+    archive.Close();
+    if (reader.Open(filename, true) || reader.GetRecovered() || reader.GetSize() != 8 || !reader.Contains(Name("BestGenome_%012zu.txt", 201)) || reader.Contains(Name("BestGenome_%012zu.txt", 198))) errors++;
+    reader.Close();
+
+    // a missing archive is only created when writing
+    std::remove(filename.c_str());
+    if (reader.Open(filename, true) == 0) errors++;
+
+    std::cout << "Errors " << errors << "\n";
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+#include "../src/TimerWheel.h"
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+// schedules timers across all the wheel levels and checks that each one fires exactly once in the tick it is due
+int main(int argc, const char **argv)
+{
+    const double resolution = 0.1;
+    const size_t timerCount = 100000;
+    TimerWheel timerWheel(resolution);
+    double startTime = 1000.05;
+    timerWheel.Initialise(startTime);
+
+    std::mt19937_64 generator(1234);
+    std::vector<uint64_t> dueTick(timerCount);
+    std::vector<int> fired(timerCount, 0);
+    uint64_t startTick = uint64_t(startTime / resolution);
+    for (size_t i = 0; i < timerCount; i++)
+    {
+        // mostly short timers plus some that need cascading from the upper levels
+        uint64_t delta = (i % 10 == 0) ? generator() % 200000 + 1 : generator() % 2000 + 1;
+        dueTick[i] = startTick + delta;
+        timerWheel.Schedule(i, uint32_t(i % 3), double(dueTick[i]) * resolution - resolution * 0.5);
+    }
+
+    int errors = 0;
+    std::vector<TimerWheel::Timer> expired;
+    uint64_t tick = startTick;
+    while (timerWheel.GetSize())
+    {
+        tick += (tick % 7 == 0) ? 13 : 1; // advance by more than one tick sometimes
+        expired.clear();
+        timerWheel.Advance(double(tick) * resolution + resolution * 0.5, &expired);
+        for (auto &&timer : expired)
+        {
+            fired[timer.id]++;
+            if (dueTick[timer.id] > tick || dueTick[timer.id] + 13 < tick) errors++;
+            if (timer.type != uint32_t(timer.id % 3)) errors++;
+        }
+        if (tick > startTick + 300000) break;
+    }
+    for (size_t i = 0; i < timerCount; i++) { if (fired[i] != 1) errors++; }
+
+    std::cout << "Timers " << timerCount << " errors " << errors << "\n";
+    return errors ? 1 : 0;
+}